@@ -18,6 +18,8 @@ class BluetoothDelegate: NSObject, CBCentralManagerDelegate, CBPeripheralDelegat
     private var notificationCenter: NotificationCenter
     private var interestingPeripheral: CBPeripheral?
     private var scanTimer: Timer?
+    // With several BME280s every one has its own characteristics; the first ones belong to "Sensor 1"
+    private var subscribed = Set<CBCharacteristic>()
 
     init(notificationCenter: NotificationCenter) {
         self.notificationCenter = notificationCenter
@@ -63,8 +65,11 @@ class BluetoothDelegate: NSObject, CBCentralManagerDelegate, CBPeripheralDelegat
     }
 
     func peripheral(_ peripheral: CBPeripheral, didDiscoverCharacteristicsFor service: CBService, error: Error?) {
+        subscribed.removeAll()
         for c in service.characteristics! {
-            if c.uuid == temperatureUuid || c.uuid == pressureUuid || c.uuid == humidityUuid || c.uuid == co2Uuid {
+            if (c.uuid == temperatureUuid || c.uuid == pressureUuid || c.uuid == humidityUuid || c.uuid == co2Uuid)
+                       && !subscribed.contains(where: { $0.uuid == c.uuid }) {
+                subscribed.insert(c)
                 peripheral.setNotifyValue(true, for: c)
                 peripheral.readValue(for: c)
             }
@@ -72,8 +77,11 @@ class BluetoothDelegate: NSObject, CBCentralManagerDelegate, CBPeripheralDelegat
     }
 
     func peripheral(_ peripheral: CBPeripheral, didUpdateValueFor characteristic: CBCharacteristic, error: Error?) {
+        if (!subscribed.contains(characteristic)) {
+            return
+        }
         let _ = setValue(characteristic, temperatureUuid, Notification.Name.onTemperatureChange, 100.0, Int16.max)
-                || setValue(characteristic, pressureUuid, Notification.Name.onPressureChange, 10.0, UInt32.max)
+                || setValue(characteristic, pressureUuid, Notification.Name.onPressureChange, 1000.0, UInt32.max)
                 || setValue(characteristic, humidityUuid, Notification.Name.onHumidityChange, 100.0, UInt16.max)
                 || setValue(characteristic, co2Uuid, Notification.Name.onCO2Change, 1.0, UInt16.max)
     }
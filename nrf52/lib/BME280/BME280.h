@@ -38,107 +38,560 @@
 #ifndef MBED_BME280_H
 #define MBED_BME280_H
 
-#include "mbed.h"
+#include <cstddef>
+#include <cstdint>
+
+#include "BME280Registers.h"
+#include "BME280Transport.h"
+#include "HalCallback.h"
+#include "HalEventQueue.h"
+#include "HalStaticEvent.h"
 
 #define DEFAULT_SLAVE_ADDRESS (0x76 << 1)
 
-#ifdef _DEBUG
-extern Serial pc;
-#define DEBUG_PRINT(...) pc.printf(__VA_ARGS__)
-#else
-#define DEBUG_PRINT(...)
-#endif
+namespace bme280 {
+
+/** Compensated values of a single measurement cycle in the native units of the compensation formulas
+ */
+typedef struct {
+    int32_t temperature;    /**< 0.01 degree Celsius */
+    uint32_t pressure;      /**< pascal */
+    uint32_t humidity;      /**< 1/1024 humidity % */
+} Measurement;
+
+/** Values of Measurement fields for channels with OVERSAMPLING_SKIPPED
+ */
+constexpr int32_t TEMPERATURE_SKIPPED = INT32_MIN;
+constexpr uint32_t PRESSURE_SKIPPED = UINT32_MAX;
+constexpr uint32_t HUMIDITY_SKIPPED = UINT32_MAX;
+
+/** Sensor configuration, fixed at compile time
+ *
+ *  Pressure and humidity compensation depend on the temperature, it can only be skipped with both of them.
+ *  Without humidity the driver also accepts a BMP280.
+ */
+template<Oversampling TEMPERATURE, Oversampling PRESSURE, Oversampling HUMIDITY,
+         Filter FILTER = FILTER_OFF, Mode MODE = MODE_FORCED, Standby STANDBY = STANDBY_1000_MS>
+struct Settings {
+    static_assert(TEMPERATURE != OVERSAMPLING_SKIPPED
+                  || (PRESSURE == OVERSAMPLING_SKIPPED && HUMIDITY == OVERSAMPLING_SKIPPED),
+                  "Pressure and humidity need the temperature");
+    static_assert(MODE != MODE_SLEEP, "The sensor would never measure");
+
+    static constexpr Oversampling temperature = TEMPERATURE;
+    static constexpr Oversampling pressure = PRESSURE;
+    static constexpr Oversampling humidity = HUMIDITY;
+    static constexpr Filter filter = FILTER;
+    static constexpr Mode mode = MODE;
+    static constexpr Standby standby = STANDBY; /**< used in normal mode only */
+};
+
+/** Normal mode, x1 oversampling, 1000 ms standby, filter off: the configuration of the original library
+ */
+typedef Settings<OVERSAMPLING_X1, OVERSAMPLING_X1, OVERSAMPLING_X1, FILTER_OFF, MODE_NORMAL> DefaultSettings;
+
+/** Calibration of all channels, e.g. to keep it over a reset. Skipped channels are left as they are
+ */
+struct Calibration {
+    TemperatureCalibration temperature;
+    PressureCalibration pressure;
+    HumidityCalibration humidity;
+};
+
+/** Calibration and compensation of the pressure, empty if the channel is skipped
+ */
+template<bool ENABLED>
+struct PressureChannel {
+    PressureCalibration calibration;
+
+    /** @param data CALIB_T_P block */
+    void decode(const uint8_t *data)
+    {
+        calibration = decodePressureCalibration(data);
+    }
+
+    void save(PressureCalibration &saved) const
+    {
+        saved = calibration;
+    }
+
+    void restore(const PressureCalibration &saved)
+    {
+        calibration = saved;
+    }
+
+    /** @param data data registers from PRESS */
+    uint32_t compensate(const uint8_t *data, int32_t t_fine) const
+    {
+        return compensatePressure(calibration, raw20(data), t_fine);
+    }
+};
+
+template<>
+struct PressureChannel<false> {
+    void decode(const uint8_t *) {}
+
+    void save(PressureCalibration &) const {}
+
+    void restore(const PressureCalibration &) {}
+
+    uint32_t compensate(const uint8_t *, int32_t) const
+    {
+        return PRESSURE_SKIPPED;
+    }
+};
+
+/** Calibration and compensation of the humidity, empty if the channel is skipped
+ */
+template<bool ENABLED>
+struct HumidityChannel {
+    HumidityCalibration calibration;
+
+    template<typename Transport>
+    void read(Transport &transport)
+    {
+        uint8_t h1[Transport::READ_OFFSET + CALIB_H1.length];
+        uint8_t data[Transport::READ_OFFSET + CALIB_H2.length];
+
+        transport.read(CALIB_H1.address, h1, CALIB_H1.length);
+        transport.read(CALIB_H2.address, data, CALIB_H2.length);
+
+        calibration = decodeHumidityCalibration(h1[Transport::READ_OFFSET], data + Transport::READ_OFFSET);
+    }
+
+    void save(HumidityCalibration &saved) const
+    {
+        saved = calibration;
+    }
+
+    void restore(const HumidityCalibration &saved)
+    {
+        calibration = saved;
+    }
+
+    /** @param data data registers from PRESS */
+    uint32_t compensate(const uint8_t *data, int32_t t_fine) const
+    {
+        return compensateHumidity(calibration, raw16(data + HUM.address - PRESS.address), t_fine);
+    }
+};
+
+template<>
+struct HumidityChannel<false> {
+    template<typename Transport>
+    void read(Transport &) {}
+
+    void save(HumidityCalibration &) const {}
+
+    void restore(const HumidityCalibration &) {}
+
+    uint32_t compensate(const uint8_t *, int32_t) const
+    {
+        return HUMIDITY_SKIPPED;
+    }
+};
+
+}
 
 /**  Interface for controlling BME280 Combined humidity and pressure sensor
  *
  * @code
  * #include "mbed.h"
  * #include "BME280.h"
+ * #include "MbedI2C.h"
  *
  * Serial pc(USBTX, USBRX);
- *
- * #if defined(TARGET_LPC1768)
- * BME280 sensor(p28, p27);
- * #else
- * BME280 sensor(I2C_SDA, I2C_SCL);
- * #endif
+ * hal::EventQueue queue;
+ * hal::MbedI2C i2c(I2C_SDA, I2C_SCL);
+ * typedef bme280::I2CTransport<hal::MbedI2C> Transport;
+ * BME280<Transport> sensor(Transport(i2c, DEFAULT_SLAVE_ADDRESS), queue);
  *
  * int main() {
  *
  *     while(1) {
- *         pc.printf("%2.2f degC, %04.2f hPa, %2.2f %%\n", sensor.getTemperature(), sensor.getPressure(), sensor.getHumidity());
+ *         bme280::Measurement m = sensor.readAll();
+ *         pc.printf("%d.%02d degC, %u Pa, %u %%\n", m.temperature / 100, m.temperature % 100, m.pressure, m.humidity / 1024);
  *         wait(1);
  *     }
  * }
  *
  * @endcode
+ *
+ * Several sensors share a bus through I2CBus, which queues their background transfers. Over SPI the sensor
+ * has a bus of its own, bme280::SpiTransport on a hal::Spi with its chip select.
  */
 
 /** BME280 class
  *
  *  BME280: A library to correct environmental data using Boshe BME280 environmental sensor device
  *
+ *  The configuration is a template parameter: the register values are constants and the code of skipped
+ *  channels, their calibration, compensation and data registers, is not compiled in. The transport is one
+ *  too, bme280::I2CTransport or bme280::SpiTransport: the compensation does not depend on the bus, and
+ *  a final bus class is called directly.
+ *
+ * @tparam Transport register access, see BME280Transport.h
+ * @tparam Config bme280::Settings
  */
+template<typename Transport, typename Config = bme280::DefaultSettings>
 class BME280
 {
 public:
 
+    typedef bme280::Measurement Measurement;
+
+    static constexpr int32_t TEMPERATURE_SKIPPED = bme280::TEMPERATURE_SKIPPED;
+    static constexpr uint32_t PRESSURE_SKIPPED = bme280::PRESSURE_SKIPPED;
+    static constexpr uint32_t HUMIDITY_SKIPPED = bme280::HUMIDITY_SKIPPED;
+
+    static constexpr bool HAS_TEMPERATURE = Config::temperature != bme280::OVERSAMPLING_SKIPPED;
+    static constexpr bool HAS_PRESSURE = Config::pressure != bme280::OVERSAMPLING_SKIPPED;
+    static constexpr bool HAS_HUMIDITY = Config::humidity != bme280::OVERSAMPLING_SKIPPED;
+
+    /** Worst-case duration of a single conversion (microseconds), see bme280::measurementTimeUs()
+     */
+    static constexpr uint32_t MEASUREMENT_TIME_US =
+            bme280::measurementTimeUs(Config::temperature, Config::pressure, Config::humidity);
+
+    /** Events the sensor keeps on its queue, see hal::StaticEvent
+     */
+    static const size_t STATIC_EVENTS = 2;
+
     /** Create a BME280 instance
-     *  which is connected to specified I2C pins with specified address
+     *  which is reached through the transport, e.g. on an I2C bus at an address
      *
-     * @param sda I2C-bus SDA pin
-     * @param scl I2C-bus SCL pin
-     * @param slave_adr (option) I2C-bus address (default: 0x76)
+     *  The chip ID is checked, and the configuration and calibration are loaded if it matches.
+     *  A calibration known from before, e.g. kept over a reset, saves reading it: 32 bytes in three
+     *  transactions.
+     *
+     * @param transport register access, copied
+     * @param queue event queue for readAllAsync()
+     * @param calibration (option) getCalibration() of this sensor in an earlier run
      */
-    BME280(PinName sda, PinName sck, char slave_adr = DEFAULT_SLAVE_ADDRESS);
+    BME280(const Transport &transport, hal::EventQueue &queue, const bme280::Calibration *calibration = NULL);
 
-    /** Create a BME280 instance
-     *  which is connected to specified I2C pins with specified address
+    BME280(const BME280 &) = delete;
+
+    BME280 &operator=(const BME280 &) = delete;
+
+    /** Whether the chip ID is the BME280 one, or the BMP280 one if humidity is skipped
      *
-     * @param i2c_obj I2C object (instance)
-     * @param slave_adr (option) I2C-bus address (default: 0x76)
+     *  A sensor that is absent or does not answer is not configured and must not be used.
      */
-    BME280(I2C &i2c_obj, char slave_adr = DEFAULT_SLAVE_ADDRESS);
+    bool isPresent(void) const
+    {
+        return present;
+    }
 
-    /** Destructor of BME280
+    /** Calibration in use, the one read from the sensor unless it was given to the constructor
      */
-    virtual ~BME280();
+    bme280::Calibration getCalibration(void) const;
 
-    /** Initializa BME280 sensor
-     *
-     *  Configure sensor setting and read parameters for calibration
+    /** Start a single conversion in forced mode
      *
+     *  Results are available when isMeasuring() returns false, usually after
+     *  MEASUREMENT_TIME_US. Does nothing in normal mode.
      */
-    void initialize(void);
+    void startMeasurement(void);
 
-    /** Read the current temperature value (degree Celsius) from BME280 sensor
-     *
+    /** Check the measuring bit of the status register
      */
-    float getTemperature(void);
+    bool isMeasuring(void);
 
-    /** Read the current pressure value (hectopascal)from BME280 sensor
+    /** Read temperature, pressure and humidity from BME280 sensor
+     *
+     *  All data registers are fetched in one burst, so the three
+     *  values belong to the same conversion and share the same t_fine.
+     *  Skipped channels are reported as *_SKIPPED values.
      *
      */
-    float getPressure(void);
+    Measurement readAll(void);
 
-    /** Read the current humidity value (humidity %) from BME280 sensor
+    /** Read temperature, pressure and humidity without blocking the caller
+     *
+     *  In forced mode a conversion is started first and the data registers
+     *  are fetched after MEASUREMENT_TIME_US. Bus transfers run in the
+     *  background through the async calls of the transport, their completion interrupts only
+     *  post the static events of the sensor to its queue, and the handler is
+     *  called from the queue with the compensated result, or with NULL if the
+     *  transfer failed.
      *
+     * @param handler called once the measurement is complete
+     * @returns true if the measurement was started, false if another one is in progress
      */
-    float getHumidity(void);
+    bool readAllAsync(hal::Callback<void(const Measurement *)> handler);
 
 private:
 
-    I2C         *i2c_p;
-    I2C         &i2c;
-    char        address;
-    uint16_t    dig_T1;
-    int16_t     dig_T2, dig_T3;
-    uint16_t    dig_P1;
-    int16_t     dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
-    uint16_t    dig_H1, dig_H3;
-    int16_t     dig_H2, dig_H4, dig_H5, dig_H6;
-    int32_t     t_fine;
+    /** First data register read, pressure comes before temperature in the map */
+    static constexpr bme280::Register DATA{
+            bme280::PRESS.address,
+            uint8_t((HAS_HUMIDITY ? bme280::HUM.end() : bme280::TEMP.end()) - bme280::PRESS.address)};
+    /** Burst of the asynchronous read: status, control, config, reserved and data registers */
+    static constexpr bme280::Register BURST{
+            bme280::STATUS.address, uint8_t(DATA.end() - bme280::STATUS.address)};
+
+    static constexpr uint8_t CTRL_MEAS_VALUE = bme280::ctrlMeas(Config::temperature, Config::pressure, Config::mode);
+
+    void initialize(const bme280::Calibration *calibration);
+
+    void writeRegister(bme280::Register reg, uint8_t value);
+
+    void readCalibration(void);
+
+    Measurement compensate(const uint8_t *data) const;
+
+    void asyncTriggerComplete(int event);
+    void asyncStartRead(void);
+    void asyncReadComplete(int event);
+    void asyncFinish(void);
+
+    Transport   transport;
+    bool        present;
+    bme280::TemperatureCalibration temperature_calibration;
+    bme280::PressureChannel<HAS_PRESSURE> pressure;
+    bme280::HumidityChannel<HAS_HUMIDITY> humidity;
+
+    hal::StaticEvent async_read_event;
+    hal::StaticEvent async_finish_event;
+    int         async_event;    // Transport event of the transfer that completed last
+    hal::Callback<void(const Measurement *)> async_handler;
+    uint8_t     async_rx[Transport::READ_OFFSET + BURST.length];
 
 };
 
+template<typename Transport, typename Config>
+constexpr int32_t BME280<Transport, Config>::TEMPERATURE_SKIPPED;
+
+template<typename Transport, typename Config>
+constexpr uint32_t BME280<Transport, Config>::PRESSURE_SKIPPED;
+
+template<typename Transport, typename Config>
+constexpr uint32_t BME280<Transport, Config>::HUMIDITY_SKIPPED;
+
+template<typename Transport, typename Config>
+constexpr bool BME280<Transport, Config>::HAS_TEMPERATURE;
+
+template<typename Transport, typename Config>
+constexpr bool BME280<Transport, Config>::HAS_PRESSURE;
+
+template<typename Transport, typename Config>
+constexpr bool BME280<Transport, Config>::HAS_HUMIDITY;
+
+template<typename Transport, typename Config>
+constexpr uint32_t BME280<Transport, Config>::MEASUREMENT_TIME_US;
+
+template<typename Transport, typename Config>
+const size_t BME280<Transport, Config>::STATIC_EVENTS;
+
+template<typename Transport, typename Config>
+constexpr bme280::Register BME280<Transport, Config>::DATA;
+
+template<typename Transport, typename Config>
+constexpr bme280::Register BME280<Transport, Config>::BURST;
+
+template<typename Transport, typename Config>
+constexpr uint8_t BME280<Transport, Config>::CTRL_MEAS_VALUE;
+
+template<typename Transport, typename Config>
+BME280<Transport, Config>::BME280(const Transport &transport, hal::EventQueue &queue,
+                                  const bme280::Calibration *calibration)
+    :
+    transport(transport),
+    present(false),
+    temperature_calibration(),
+    pressure(),
+    humidity(),
+    async_read_event(queue, hal::callback(this, &BME280::asyncStartRead)),
+    async_finish_event(queue, hal::callback(this, &BME280::asyncFinish)),
+    async_event(0)
+{
+    initialize(calibration);
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::initialize(const bme280::Calibration *calibration)
+{
+    uint8_t id[Transport::READ_OFFSET + bme280::CHIP_ID.length];
+
+    present = transport.read(bme280::CHIP_ID.address, id, bme280::CHIP_ID.length) == 0
+              && (id[Transport::READ_OFFSET] == bme280::CHIP_ID_BME280
+                  || (!HAS_HUMIDITY && id[Transport::READ_OFFSET] == bme280::CHIP_ID_BMP280));
+    if (!present) {
+        return;
+    }
+
+    // Sleep mode first, so the filter and standby settings are always accepted
+    writeRegister(bme280::CTRL_MEAS, bme280::ctrlMeas(Config::temperature, Config::pressure, bme280::MODE_SLEEP));
+    writeRegister(bme280::CONFIG, bme280::config(Config::standby, Config::filter));
+    if (HAS_HUMIDITY) {
+        writeRegister(bme280::CTRL_HUM, Config::humidity);
+    }
+    writeRegister(bme280::CTRL_MEAS, CTRL_MEAS_VALUE);
+
+    if (calibration == NULL) {
+        readCalibration();
+        return;
+    }
+    temperature_calibration = calibration->temperature;
+    pressure.restore(calibration->pressure);
+    humidity.restore(calibration->humidity);
+}
+
+template<typename Transport, typename Config>
+bme280::Calibration BME280<Transport, Config>::getCalibration() const
+{
+    bme280::Calibration calibration = bme280::Calibration();
+    calibration.temperature = temperature_calibration;
+    pressure.save(calibration.pressure);
+    humidity.save(calibration.humidity);
+    return calibration;
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::writeRegister(bme280::Register reg, uint8_t value)
+{
+    const uint8_t cmd[2] = {reg.address, value};
+    transport.write(cmd, sizeof(cmd));
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::readCalibration()
+{
+    if (!HAS_TEMPERATURE) {
+        return;
+    }
+
+    uint8_t buffer[Transport::READ_OFFSET + bme280::CALIB_T_P.length];
+    const uint8_t *data = buffer + Transport::READ_OFFSET;
+
+    transport.read(bme280::CALIB_T_P.address, buffer, bme280::CALIB_T_P.length);
+
+    temperature_calibration = bme280::decodeTemperatureCalibration(data);
+    pressure.decode(data);
+    humidity.read(transport);
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::startMeasurement()
+{
+    if (Config::mode != bme280::MODE_FORCED) {
+        return;
+    }
+
+    writeRegister(bme280::CTRL_MEAS, CTRL_MEAS_VALUE);
+}
+
+template<typename Transport, typename Config>
+bool BME280<Transport, Config>::isMeasuring()
+{
+    uint8_t status[Transport::READ_OFFSET + bme280::STATUS.length];
+
+    transport.read(bme280::STATUS.address, status, bme280::STATUS.length);
+
+    return (status[Transport::READ_OFFSET] & bme280::STATUS_MEASURING) != 0;
+}
+
+template<typename Transport, typename Config>
+typename BME280<Transport, Config>::Measurement BME280<Transport, Config>::readAll()
+{
+    uint8_t buffer[Transport::READ_OFFSET + DATA.length];
+
+    transport.read(DATA.address, buffer, DATA.length);
+
+    return compensate(buffer + Transport::READ_OFFSET);
+}
+
+template<typename Transport, typename Config>
+typename BME280<Transport, Config>::Measurement BME280<Transport, Config>::compensate(const uint8_t *data) const
+{
+    Measurement result;
+    if (!HAS_TEMPERATURE) {
+        result.temperature = TEMPERATURE_SKIPPED;
+        result.pressure = PRESSURE_SKIPPED;
+        result.humidity = HUMIDITY_SKIPPED;
+        return result;
+    }
+    // Temperature goes first: t_fine is the input of the other two channels
+    int32_t t_fine = bme280::fineTemperature(temperature_calibration,
+                                             bme280::raw20(data + bme280::TEMP.address - DATA.address));
+    result.temperature = bme280::compensateTemperature(t_fine);
+    result.pressure = pressure.compensate(data, t_fine);
+    result.humidity = humidity.compensate(data, t_fine);
+    return result;
+}
+
+template<typename Transport, typename Config>
+bool BME280<Transport, Config>::readAllAsync(hal::Callback<void(const Measurement *)> handler)
+{
+    if (async_handler) {
+        return false;
+    }
+    async_handler = handler;
+
+    if (Config::mode != bme280::MODE_FORCED) {
+        asyncStartRead();
+        return true;
+    }
+
+    const uint8_t cmd[2] = {bme280::CTRL_MEAS.address, CTRL_MEAS_VALUE};
+    if (transport.writeAsync(cmd, sizeof(cmd), hal::callback(this, &BME280::asyncTriggerComplete)) != 0) {
+        async_handler = nullptr;
+        return false;
+    }
+    return true;
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::asyncTriggerComplete(int event)
+{
+    // Interrupt context
+    if (event & Transport::EVENT_COMPLETE) {
+        async_read_event.postIn(MEASUREMENT_TIME_US / 1000 + 1);
+    } else {
+        async_event = event;
+        async_finish_event.post();
+    }
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::asyncStartRead()
+{
+    if (transport.readAsync(BURST.address, async_rx, BURST.length,
+                            hal::callback(this, &BME280::asyncReadComplete)) != 0) {
+        async_event = Transport::EVENT_ERROR;
+        asyncFinish();
+    }
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::asyncReadComplete(int event)
+{
+    // Interrupt context
+    async_event = event;
+    async_finish_event.post();
+}
+
+template<typename Transport, typename Config>
+void BME280<Transport, Config>::asyncFinish()
+{
+    int event = async_event;
+    const uint8_t *burst = async_rx + Transport::READ_OFFSET;
+    if ((event & Transport::EVENT_COMPLETE) && (burst[0] & bme280::STATUS_MEASURING)) {
+        // Conversion is still running, poll again
+        async_read_event.postIn(1);
+        return;
+    }
+
+    hal::Callback<void(const Measurement *)> handler = async_handler;
+    async_handler = nullptr;
+
+    if (event & Transport::EVENT_COMPLETE) {
+        Measurement result = compensate(&burst[DATA.address - BURST.address]);
+        handler(&result);
+    } else {
+        handler(NULL);
+    }
+}
+
 #endif // MBED_BME280_H
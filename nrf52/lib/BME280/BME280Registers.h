@@ -0,0 +1,215 @@
+#ifndef BME280_REGISTERS_H
+#define BME280_REGISTERS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Register map, configuration encoding, calibration decoding and compensation of the BME280, all constexpr.
+ * The formulas are the 32-bit integer ones of the datasheet (section 4.2.3), BME280.cpp checks them at compile
+ * time against the datasheet example.
+ *
+ * Datasheet: http://ae-bst.resource.bosch.com/media/products/dokumente/bme280/BST-BME280_DS001-10.pdf
+ */
+namespace bme280 {
+
+/** A register or a block of consecutive registers */
+struct Register {
+    uint8_t address;
+    uint8_t length;
+
+    constexpr uint8_t end() const {
+        return uint8_t(address + length);
+    }
+};
+
+constexpr Register CALIB_T_P{0x88, 24};     /**< dig_T1..dig_T3, dig_P1..dig_P9 */
+constexpr Register CALIB_H1{0xA1, 1};       /**< dig_H1 */
+constexpr Register CHIP_ID{0xD0, 1};
+constexpr Register RESET{0xE0, 1};
+constexpr Register CALIB_H2{0xE1, 7};       /**< dig_H2..dig_H6 */
+constexpr Register CTRL_HUM{0xF2, 1};       /**< takes effect after the following CTRL_MEAS write */
+constexpr Register STATUS{0xF3, 1};
+constexpr Register CTRL_MEAS{0xF4, 1};
+constexpr Register CONFIG{0xF5, 1};
+constexpr Register PRESS{0xF7, 3};          /**< msb, lsb, xlsb */
+constexpr Register TEMP{0xFA, 3};           /**< msb, lsb, xlsb */
+constexpr Register HUM{0xFD, 2};            /**< msb, lsb */
+
+constexpr uint8_t CHIP_ID_BME280 = 0x60;
+/** BMP280 mass production, the same register map without humidity */
+constexpr uint8_t CHIP_ID_BMP280 = 0x58;
+constexpr uint8_t STATUS_MEASURING = 0x08;
+
+static_assert(CALIB_T_P.end() <= CALIB_H1.address && CALIB_H2.end() <= CTRL_HUM.address,
+              "Calibration blocks must not overlap the control registers");
+static_assert(CTRL_HUM.end() == STATUS.address && STATUS.end() == CTRL_MEAS.address
+              && CTRL_MEAS.end() == CONFIG.address && CONFIG.end() + 1 == PRESS.address,
+              "Status, control and data registers must be one burst, with a reserved register before the data");
+static_assert(PRESS.end() == TEMP.address && TEMP.end() == HUM.address && HUM.end() == 0xFF,
+              "Data registers must be consecutive and end the register map");
+
+/** osrs_t, osrs_p, osrs_h */
+enum Oversampling : uint8_t {
+    OVERSAMPLING_SKIPPED = 0,   /**< channel is not measured, its code is compiled out */
+    OVERSAMPLING_X1 = 1,
+    OVERSAMPLING_X2 = 2,
+    OVERSAMPLING_X4 = 3,
+    OVERSAMPLING_X8 = 4,
+    OVERSAMPLING_X16 = 5,
+};
+
+/** IIR filter coefficient */
+enum Filter : uint8_t {
+    FILTER_OFF = 0,
+    FILTER_2 = 1,
+    FILTER_4 = 2,
+    FILTER_8 = 3,
+    FILTER_16 = 4,
+};
+
+enum Mode : uint8_t {
+    MODE_SLEEP = 0,
+    MODE_FORCED = 1,            /**< one conversion per measurement, the sensor sleeps in between */
+    MODE_NORMAL = 3,            /**< continuous conversions separated by the standby time */
+};
+
+/** t_sb, inactive duration between conversions in normal mode */
+enum Standby : uint8_t {
+    STANDBY_0_5_MS = 0,
+    STANDBY_62_5_MS = 1,
+    STANDBY_125_MS = 2,
+    STANDBY_250_MS = 3,
+    STANDBY_500_MS = 4,
+    STANDBY_1000_MS = 5,
+    STANDBY_10_MS = 6,
+    STANDBY_20_MS = 7,
+};
+
+constexpr uint8_t ctrlMeas(Oversampling temperature, Oversampling pressure, Mode mode) {
+    return uint8_t(temperature << 5 | pressure << 2 | mode);
+}
+
+constexpr uint8_t config(Standby standby, Filter filter) {
+    return uint8_t(standby << 5 | filter << 2);
+}
+
+constexpr uint32_t oversamplingFactor(Oversampling oversampling) {
+    return oversampling == OVERSAMPLING_SKIPPED ? 0 : 1u << (oversampling - 1);
+}
+
+/**
+ * Worst-case duration of a conversion, microseconds (datasheet appendix B):
+ * 1.25 ms + 2.3 ms * T_osr + (2.3 ms * P_osr + 0.575 ms) + (2.3 ms * H_osr + 0.575 ms), skipped channels don't count.
+ */
+constexpr uint32_t measurementTimeUs(Oversampling temperature, Oversampling pressure, Oversampling humidity) {
+    return 1250 + 2300 * oversamplingFactor(temperature)
+           + (pressure != OVERSAMPLING_SKIPPED ? 2300 * oversamplingFactor(pressure) + 575 : 0)
+           + (humidity != OVERSAMPLING_SKIPPED ? 2300 * oversamplingFactor(humidity) + 575 : 0);
+}
+
+struct TemperatureCalibration {
+    uint16_t dig_T1;
+    int16_t dig_T2, dig_T3;
+};
+
+struct PressureCalibration {
+    uint16_t dig_P1;
+    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+};
+
+struct HumidityCalibration {
+    uint8_t dig_H1, dig_H3;
+    int16_t dig_H2, dig_H4, dig_H5;
+    int8_t dig_H6;
+};
+
+constexpr uint16_t unsigned16(const uint8_t *data) {
+    return uint16_t(data[1] << 8 | data[0]);
+}
+
+constexpr int16_t signed16(const uint8_t *data) {
+    return int16_t(unsigned16(data));
+}
+
+/** @param data CALIB_T_P block */
+constexpr TemperatureCalibration decodeTemperatureCalibration(const uint8_t *data) {
+    return TemperatureCalibration{unsigned16(data), signed16(data + 2), signed16(data + 4)};
+}
+
+/** @param data CALIB_T_P block */
+constexpr PressureCalibration decodePressureCalibration(const uint8_t *data) {
+    return PressureCalibration{unsigned16(data + 6), signed16(data + 8), signed16(data + 10),
+                               signed16(data + 12), signed16(data + 14), signed16(data + 16),
+                               signed16(data + 18), signed16(data + 20), signed16(data + 22)};
+}
+
+/**
+ * dig_H4 and dig_H5 are 12-bit values sharing a byte, their upper bytes are signed.
+ * @param h1 CALIB_H1 register
+ * @param data CALIB_H2 block
+ */
+constexpr HumidityCalibration decodeHumidityCalibration(uint8_t h1, const uint8_t *data) {
+    return HumidityCalibration{h1, data[2], signed16(data),
+                               int16_t(int8_t(data[3]) * 16 | (data[4] & 0x0F)),
+                               int16_t(int8_t(data[5]) * 16 | (data[4] >> 4)),
+                               int8_t(data[6])};
+}
+
+/** 20-bit pressure and temperature values, msb first */
+constexpr int32_t raw20(const uint8_t *data) {
+    return int32_t(uint32_t(data[0]) << 12 | uint32_t(data[1]) << 4 | data[2] >> 4);
+}
+
+constexpr int32_t raw16(const uint8_t *data) {
+    return int32_t(data[0] << 8 | data[1]);
+}
+
+/** Fine temperature, the input of the pressure and humidity compensation */
+constexpr int32_t fineTemperature(const TemperatureCalibration &c, int32_t raw) {
+    return ((((raw >> 3) - (int32_t(c.dig_T1) << 1)) * c.dig_T2) >> 11)
+           + (((((raw >> 4) - c.dig_T1) * ((raw >> 4) - c.dig_T1)) >> 12) * c.dig_T3 >> 14);
+}
+
+/** 0.01 degree Celsius */
+constexpr int32_t compensateTemperature(int32_t tFine) {
+    return (tFine * 5 + 128) >> 8;
+}
+
+/** Pascal, 0 if the calibration is broken */
+constexpr uint32_t compensatePressure(const PressureCalibration &c, int32_t raw, int32_t tFine) {
+    int32_t var1 = (tFine >> 1) - 64000;
+    int32_t var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * c.dig_P6;
+    var2 = var2 + var1 * c.dig_P5 * 2;
+    var2 = (var2 >> 2) + c.dig_P4 * 65536;
+    var1 = (((c.dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((c.dig_P2 * var1) >> 1)) >> 18;
+    var1 = ((32768 + var1) * c.dig_P1) >> 15;
+    if (var1 == 0) {
+        return 0;
+    }
+    uint32_t pressure = uint32_t((1048576 - raw) - (var2 >> 12)) * 3125;
+    if (pressure < 0x80000000) {
+        pressure = (pressure << 1) / uint32_t(var1);
+    } else {
+        pressure = (pressure / uint32_t(var1)) * 2;
+    }
+    var1 = (int32_t(c.dig_P9) * int32_t(((pressure >> 3) * (pressure >> 3)) >> 13)) >> 12;
+    var2 = (int32_t(pressure >> 2) * c.dig_P8) >> 13;
+    return uint32_t(int32_t(pressure) + ((var1 + var2 + c.dig_P7) >> 4));
+}
+
+/** 1/1024 % */
+constexpr uint32_t compensateHumidity(const HumidityCalibration &c, int32_t raw, int32_t tFine) {
+    int32_t v = tFine - 76800;
+    v = ((((raw * 16384) - int32_t(c.dig_H4) * 1048576 - int32_t(c.dig_H5) * v) + 16384) >> 15)
+        * (((((((v * int32_t(c.dig_H6)) >> 10) * (((v * int32_t(c.dig_H3)) >> 11) + 32768)) >> 10) + 2097152)
+            * int32_t(c.dig_H2) + 8192) >> 14);
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * int32_t(c.dig_H1)) >> 4);
+    v = v < 0 ? 0 : v;
+    v = v > 419430400 ? 419430400 : v;
+    return uint32_t(v >> 12);
+}
+
+}
+
+#endif // BME280_REGISTERS_H
@@ -0,0 +1,146 @@
+#ifndef BME280_TRANSPORT_H
+#define BME280_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "HalCallback.h"
+#include "HalI2C.h"
+#include "HalSpi.h"
+
+/**
+ * Register access of the BME280 driver over the bus the sensor is on. A transport provides
+ *  - write(): register address and value pairs, at most MAX_WRITE bytes,
+ *  - read(): length consecutive registers into buffer + READ_OFFSET, the buffer has READ_OFFSET
+ *    more bytes in front so that the transaction reads straight into it,
+ *  - writeAsync() and readAsync(): the same without blocking, the callback gets EVENT_COMPLETE or
+ *    EVENT_ERROR, possibly from interrupt context,
+ * all returning 0 on success. Transports are small values kept in the driver, they hold the bytes
+ * of a running transaction.
+ */
+namespace bme280 {
+
+/**
+ * The sensor at an I2C address, on hal::I2C or anything with its read(), write() and transfer().
+ */
+template<typename Bus>
+class I2CTransport {
+public:
+    static constexpr size_t READ_OFFSET = 0;
+    static constexpr int MAX_WRITE = 8;
+    static constexpr int EVENT_COMPLETE = hal::I2C::EVENT_COMPLETE;
+    static constexpr int EVENT_ERROR = hal::I2C::EVENT_ERROR;
+
+    /** @param address 8-bit form, 0x76 << 1 with SDO low */
+    I2CTransport(Bus &bus, int address) : bus(bus), address(address) {}
+
+    int write(const uint8_t *pairs, int length) {
+        return bus.write(address, (const char *) pairs, length);
+    }
+
+    int read(uint8_t reg, uint8_t *buffer, int length) {
+        tx[0] = char(reg);
+        return bus.write(address, tx, 1) == 0 && bus.read(address, (char *) buffer, length) == 0 ? 0 : -1;
+    }
+
+    int writeAsync(const uint8_t *pairs, int length, const hal::Callback<void(int)> &callback) {
+        if (length > MAX_WRITE) {
+            return -1;
+        }
+        memcpy(tx, pairs, length);
+        return bus.transfer(address, tx, length, nullptr, 0, callback);
+    }
+
+    int readAsync(uint8_t reg, uint8_t *buffer, int length, const hal::Callback<void(int)> &callback) {
+        tx[0] = char(reg);
+        return bus.transfer(address, tx, 1, (char *) buffer, length, callback);
+    }
+
+private:
+    Bus &bus;
+    int address;
+    char tx[MAX_WRITE];
+};
+
+/**
+ * The sensor on its own chip select, on hal::Spi or anything with its write() and transfer(). The BME280
+ * takes SPI mode 0 or 3 up to 10 MHz: a data burst takes microseconds where I2C at 100 kHz takes over a
+ * millisecond. On the wire register addresses lose bit 7, set for a read and cleared for a write command
+ * (datasheet section 6.3). The byte clocked in during the command is the READ_OFFSET one.
+ */
+template<typename Bus = hal::Spi>
+class SpiTransport {
+public:
+    static constexpr size_t READ_OFFSET = 1;
+    static constexpr int MAX_WRITE = 8;
+    static constexpr int EVENT_COMPLETE = hal::Spi::EVENT_COMPLETE;
+    static constexpr int EVENT_ERROR = hal::Spi::EVENT_ERROR;
+
+    explicit SpiTransport(Bus &bus) : bus(bus) {}
+
+    int write(const uint8_t *pairs, int length) {
+        return encodeWrite(pairs, length) ? bus.write(tx, length, nullptr, 0) : -1;
+    }
+
+    int read(uint8_t reg, uint8_t *buffer, int length) {
+        tx[0] = char(reg | READ);
+        return bus.write(tx, 1, (char *) buffer, int(READ_OFFSET) + length);
+    }
+
+    int writeAsync(const uint8_t *pairs, int length, const hal::Callback<void(int)> &callback) {
+        return encodeWrite(pairs, length) ? bus.transfer(tx, length, nullptr, 0, callback) : -1;
+    }
+
+    int readAsync(uint8_t reg, uint8_t *buffer, int length, const hal::Callback<void(int)> &callback) {
+        tx[0] = char(reg | READ);
+        return bus.transfer(tx, 1, (char *) buffer, int(READ_OFFSET) + length, callback);
+    }
+
+private:
+    static constexpr uint8_t READ = 0x80;
+
+    bool encodeWrite(const uint8_t *pairs, int length) {
+        if (length > MAX_WRITE) {
+            return false;
+        }
+        for (int i = 0; i < length; ++i) {
+            tx[i] = char(i % 2 == 0 ? pairs[i] & ~READ : pairs[i]);
+        }
+        return true;
+    }
+
+    Bus &bus;
+    char tx[MAX_WRITE];
+};
+
+template<typename Bus>
+constexpr size_t I2CTransport<Bus>::READ_OFFSET;
+
+template<typename Bus>
+constexpr int I2CTransport<Bus>::MAX_WRITE;
+
+template<typename Bus>
+constexpr int I2CTransport<Bus>::EVENT_COMPLETE;
+
+template<typename Bus>
+constexpr int I2CTransport<Bus>::EVENT_ERROR;
+
+template<typename Bus>
+constexpr size_t SpiTransport<Bus>::READ_OFFSET;
+
+template<typename Bus>
+constexpr int SpiTransport<Bus>::MAX_WRITE;
+
+template<typename Bus>
+constexpr int SpiTransport<Bus>::EVENT_COMPLETE;
+
+template<typename Bus>
+constexpr int SpiTransport<Bus>::EVENT_ERROR;
+
+template<typename Bus>
+constexpr uint8_t SpiTransport<Bus>::READ;
+
+}
+
+#endif // BME280_TRANSPORT_H
@@ -0,0 +1,13 @@
+#include "Crc32.h"
+
+uint32_t crc32(const void *data, size_t length, uint32_t previous) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint32_t crc = ~previous;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,13 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC-32 (IEEE 802.3, reflected, as zlib), bitwise: slow but without a table in flash.
+ * @param previous CRC of the data before, to checksum non-contiguous blocks as one
+ */
+uint32_t crc32(const void *data, size_t length, uint32_t previous = 0);
+
+#endif // CRC32_H
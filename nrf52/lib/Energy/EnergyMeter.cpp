@@ -0,0 +1,100 @@
+#include "EnergyMeter.h"
+
+constexpr EnergyMeter::Model EnergyMeter::NRF52_MODEL;
+
+EnergyMeter::Report &EnergyMeter::Report::operator+=(const Report &other) {
+    elapsedMs += other.elapsedMs;
+    cpu.awakeUs += other.cpu.awakeUs;
+    cpu.sleepUs += other.cpu.sleepUs;
+    cpu.deepSleepUs += other.cpu.deepSleepUs;
+    advertisingEvents += other.advertisingEvents;
+    connectionEvents += other.connectionEvents;
+    bme280Conversions += other.bme280Conversions;
+    uartTransactions += other.uartTransactions;
+    cpuNc += other.cpuNc;
+    radioNc += other.radioNc;
+    sensorsNc += other.sensorsNc;
+    return *this;
+}
+
+uint32_t EnergyMeter::Report::averageMcuNa() const {
+    return elapsedMs == 0 ? 0 : uint32_t((cpuNc + radioNc) * 1000 / elapsedMs);
+}
+
+uint32_t EnergyMeter::Report::averageNa() const {
+    return elapsedMs == 0 ? 0 : uint32_t((cpuNc + radioNc + sensorsNc) * 1000 / elapsedMs);
+}
+
+EnergyMeter::EnergyMeter(const Model &model)
+        : model(model),
+          startMs(hal::uptimeMs()),
+          startCpu(hal::cpuTime()) {}
+
+uint32_t EnergyMeter::Periodic::count(uint64_t nowMs) {
+    if (intervalMs == 0) {
+        sinceMs = nowMs;
+        return 0;
+    }
+    uint32_t events = uint32_t((nowMs - sinceMs) / intervalMs);
+    sinceMs += uint64_t(events) * intervalMs;
+    return events;
+}
+
+uint32_t EnergyMeter::Rate::count(uint64_t nowMs) {
+    remainder += (nowMs - sinceMs) * perKilosecond;
+    sinceMs = nowMs;
+    uint32_t events = uint32_t(remainder / 1000000);
+    remainder %= 1000000;
+    return events;
+}
+
+void EnergyMeter::setAdvertisingInterval(uint32_t ms) {
+    current.advertisingEvents += advertising.count(hal::uptimeMs());
+    advertising.intervalMs = ms;
+}
+
+void EnergyMeter::setConnectionEventRate(uint32_t perKilosecond) {
+    current.connectionEvents += connection.count(hal::uptimeMs());
+    connection.perKilosecond = perKilosecond;
+}
+
+EnergyMeter::Report EnergyMeter::snapshot(uint64_t nowMs, const hal::CpuTime &cpu) const {
+    Report report = current;
+    Periodic pendingAdvertising = advertising;
+    Rate pendingConnection = connection;
+    report.advertisingEvents += pendingAdvertising.count(nowMs);
+    report.connectionEvents += pendingConnection.count(nowMs);
+
+    report.elapsedMs = nowMs - startMs;
+    report.cpu = {cpu.awakeUs - startCpu.awakeUs, cpu.sleepUs - startCpu.sleepUs,
+                  cpu.deepSleepUs - startCpu.deepSleepUs};
+
+    report.cpuNc = (report.cpu.awakeUs * model.cpuRunNa + report.cpu.sleepUs * model.cpuSleepNa
+                    + report.cpu.deepSleepUs * model.cpuDeepSleepNa) / 1000000;
+    report.radioNc = uint64_t(report.advertisingEvents) * model.advertisingEventNc
+                     + uint64_t(report.connectionEvents) * model.connectionEventNc;
+    report.sensorsNc = uint64_t(report.bme280Conversions) * model.bme280ConversionNc
+                       + uint64_t(report.uartTransactions) * model.uartTransactionNc
+                       + report.elapsedMs * (model.bme280StandbyNa + model.mhz19bNa) / 1000;
+    return report;
+}
+
+EnergyMeter::Report EnergyMeter::takeReport() {
+    uint64_t now = hal::uptimeMs();
+    hal::CpuTime cpu = hal::cpuTime();
+    Report report = snapshot(now, cpu);
+    totals += report;
+
+    advertising.count(now);
+    connection.count(now);
+    current = Report{};
+    startMs = now;
+    startCpu = cpu;
+    return report;
+}
+
+EnergyMeter::Report EnergyMeter::total() const {
+    Report report = totals;
+    report += snapshot(hal::uptimeMs(), hal::cpuTime());
+    return report;
+}
@@ -0,0 +1,123 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <cstdint>
+
+#include <Hal.h>
+
+/**
+ * @class EnergyMeter
+ * @brief Estimates the average supply current from what the firmware did.
+ *
+ * CPU time comes from hal::cpuTime(). Radio events are counted from the advertising interval and the
+ * connection event rate in effect, sensor activity is reported by the application. Every activity is charged with
+ * the Model, the result is an average current per report interval, good enough to compare builds.
+ */
+class EnergyMeter {
+public:
+    /** Currents in nA, charges in nC, i.e. nA for one second */
+    struct Model {
+        uint32_t cpuRunNa;
+        uint32_t cpuSleepNa;
+        uint32_t cpuDeepSleepNa;
+        uint32_t advertisingEventNc;
+        uint32_t connectionEventNc;
+        uint32_t bme280ConversionNc;
+        uint32_t bme280StandbyNa;
+        uint32_t uartTransactionNc;
+        uint32_t mhz19bNa;
+    };
+
+    /**
+     * nRF52832 at 3 V with the DC/DC converter, 0 dBm, from the product specification and the
+     * online power profiler; BME280 and MH-Z19B from their datasheets.
+     */
+    static constexpr Model NRF52_MODEL{
+            3700000, /* CPU running from flash at 64 MHz */
+            400000, /* System ON with the high-frequency clock and a timer running */
+            1900, /* System ON, full RAM retention, RTC wakeup */
+            11000, /* three channels, 31-byte payload and scan response */
+            3500, /* empty connection event */
+            3600, /* forced mode, all channels at x1 oversampling */
+            100,
+            20000, /* UART and its clock for a 9-byte request and response */
+            18000000, /* maximum average current, from 5 V */
+    };
+
+    struct Report {
+        uint64_t elapsedMs = 0;
+        hal::CpuTime cpu{0, 0, 0};
+        uint32_t advertisingEvents = 0;
+        uint32_t connectionEvents = 0;
+        uint32_t bme280Conversions = 0;
+        uint32_t uartTransactions = 0;
+        uint64_t cpuNc = 0;
+        uint64_t radioNc = 0;
+        uint64_t sensorsNc = 0;
+
+        Report &operator+=(const Report &other);
+
+        /** Of the nRF52 alone and of the whole device, sensors included */
+        uint32_t averageMcuNa() const;
+
+        uint32_t averageNa() const;
+    };
+
+    explicit EnergyMeter(const Model &model = NRF52_MODEL);
+
+    /** @param ms advertising interval, 0 if it is off */
+    void setAdvertisingInterval(uint32_t ms);
+
+    /**
+     * @param perKilosecond connection events of all connections per 1000 s, 0 if there is no connection.
+     *        A connection with slave latency has (1 + latency) times fewer events while it has nothing to send.
+     */
+    void setConnectionEventRate(uint32_t perKilosecond);
+
+    void addBme280Conversion() {
+        ++current.bme280Conversions;
+    }
+
+    void addUartTransaction() {
+        ++current.uartTransactions;
+    }
+
+    /** The interval from the last takeReport() till now, it starts a new interval */
+    Report takeReport();
+
+    /** Everything since the meter was created */
+    Report total() const;
+
+private:
+    /** Radio events on a fixed interval, counted as they happen */
+    struct Periodic {
+        uint32_t intervalMs = 0;
+        uint64_t sinceMs = 0;
+
+        /** Counts the events up to nowMs, the remainder carries over */
+        uint32_t count(uint64_t nowMs);
+    };
+
+    /** Radio events at a rate, counted as they happen */
+    struct Rate {
+        uint32_t perKilosecond = 0;
+        uint64_t sinceMs = 0;
+        /** Fraction of the next event, in millionths */
+        uint64_t remainder = 0;
+
+        uint32_t count(uint64_t nowMs);
+    };
+
+    /** The current interval as of nowMs */
+    Report snapshot(uint64_t nowMs, const hal::CpuTime &cpu) const;
+
+    const Model model;
+    Periodic advertising;
+    Rate connection;
+    Report current;
+    Report totals;
+    uint64_t startMs;
+    hal::CpuTime startCpu;
+};
+
+#endif // ENERGY_METER_H
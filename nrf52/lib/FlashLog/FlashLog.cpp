@@ -0,0 +1,288 @@
+#include <cstddef>
+#include <cstring>
+
+#include <Crc32.h>
+
+#include "FlashLog.h"
+
+namespace {
+
+const uint32_t MAGIC = 0x474f4c54; /* "TLOG" */
+
+bool isErased(const void *data, size_t length) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < length; ++i) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t sequenceKey(uint32_t sequence, uint32_t) {
+    return sequence;
+}
+
+uint32_t timeKey(uint32_t, uint32_t time) {
+    return time;
+}
+
+}
+
+FlashLog::FlashLog(hal::Flash &flash) : flash(flash) {}
+
+int FlashLog::mount() {
+    mounted = false;
+    int result = flash.init();
+    if (result != 0) {
+        return result;
+    }
+    sectorSize = flash.getSectorSize();
+    sectorCount = flash.getSize() / sectorSize;
+    if (sectorCount < 2 || sectorSize < sizeof(Header) + sizeof(Slot)
+        || sizeof(Header) % flash.getProgramSize() != 0 || sizeof(Slot) % flash.getProgramSize() != 0) {
+        return -1;
+    }
+    slotsPerSector = (sectorSize - sizeof(Header)) / sizeof(Slot);
+    statistics = Stats();
+    statistics.sectors = sectorCount;
+    statistics.slotsPerSector = slotsPerSector;
+
+    // The active sector starts with the largest sequence number
+    Header newest{};
+    sectorsInUse = 0;
+    for (uint32_t sector = 0; sector < sectorCount; ++sector) {
+        Header header;
+        if (!readHeader(sector, header)) {
+            continue;
+        }
+        if (header.eraseCount > statistics.maxEraseCount) {
+            statistics.maxEraseCount = header.eraseCount;
+        }
+        if (sectorsInUse == 0 || header.firstSequence > newest.firstSequence) {
+            newest = header;
+            activeSector = sector;
+            sectorsInUse = 1;
+        }
+    }
+    if (sectorsInUse == 0) {
+        writeSlot = 0;
+        nextSeq = 0;
+        firstSeq = 0;
+        lastSampleTime = 0;
+        mounted = true;
+        return 0;
+    }
+
+    // Older sectors precede it, up to a sector which is erased, torn or reused
+    Header oldest = newest;
+    while (sectorsInUse < sectorCount) {
+        Header header;
+        if (!readHeader((activeSector + sectorCount - sectorsInUse) % sectorCount, header)
+            || header.firstSequence >= oldest.firstSequence) {
+            break;
+        }
+        oldest = header;
+        ++sectorsInUse;
+    }
+    firstSeq = oldest.firstSequence;
+
+    // Appends continue after the last programmed slot, even if its programming was interrupted
+    Sample sample;
+    writeSlot = slotsPerSector;
+    while (writeSlot > 0 && readSlot(activeSector, writeSlot - 1, sample) == SLOT_ERASED) {
+        --writeSlot;
+    }
+    nextSeq = newest.firstSequence;
+    lastSampleTime = newest.firstTime;
+    for (uint32_t slot = writeSlot; slot-- > 0;) {
+        if (readSlot(activeSector, slot, sample) == SLOT_VALID) {
+            nextSeq = sample.sequence + 1;
+            lastSampleTime = sample.time;
+            break;
+        }
+    }
+    mounted = true;
+    return 0;
+}
+
+int FlashLog::append(const Sample &sample) {
+    if (!mounted) {
+        return -1;
+    }
+    if (sectorsInUse == 0 || writeSlot == slotsPerSector) {
+        int result = startSector(sample);
+        if (result != 0) {
+            ++statistics.errors;
+            return result;
+        }
+    }
+    // The slot is used even if programming fails, mount() would find it torn anyway
+    Slot slot{sample, crc32(&sample, sizeof(sample))};
+    uint32_t address = slotAddress(activeSector, writeSlot++);
+    nextSeq = sample.sequence + 1;
+    lastSampleTime = sample.time;
+    int result = flash.program(address, &slot, sizeof(slot));
+    if (result != 0) {
+        ++statistics.errors;
+    }
+    return result;
+}
+
+uint32_t FlashLog::firstSequence() const {
+    return sectorsInUse == 0 ? nextSeq : firstSeq;
+}
+
+FlashLog::Cursor FlashLog::seekSequence(uint32_t sequence) {
+    return seek(sequence, sequenceKey);
+}
+
+FlashLog::Cursor FlashLog::seekTime(uint32_t time) {
+    return seek(time, timeKey);
+}
+
+bool FlashLog::read(Cursor &cursor, Sample &sample) {
+    if (!mounted || sectorsInUse == 0) {
+        return false;
+    }
+    if (!isCurrent(cursor)) {
+        cursor = seekSequence(cursor.sequence);
+    }
+    while (true) {
+        if (cursor.sector == activeSector && cursor.slot >= writeSlot) {
+            return false;
+        }
+        if (cursor.slot == slotsPerSector) {
+            cursor.sector = (cursor.sector + 1) % sectorCount;
+            cursor.slot = 0;
+            continue;
+        }
+        if (readSlot(cursor.sector, cursor.slot++, sample) == SLOT_VALID && sample.sequence >= cursor.sequence) {
+            cursor.sequence = sample.sequence + 1;
+            return true;
+        }
+    }
+}
+
+bool FlashLog::readHeader(uint32_t sector, Header &header) {
+    return flash.read(sectorAddress(sector), &header, sizeof(header)) == 0
+           && header.magic == MAGIC
+           && header.crc == crc32(&header, offsetof(Header, crc));
+}
+
+FlashLog::SlotState FlashLog::readSlot(uint32_t sector, uint32_t slot, Sample &sample) {
+    Slot data;
+    if (flash.read(slotAddress(sector, slot), &data, sizeof(data)) != 0) {
+        return SLOT_CORRUPTED;
+    }
+    if (isErased(&data, sizeof(data))) {
+        return SLOT_ERASED;
+    }
+    if (data.crc != crc32(&data.sample, sizeof(data.sample))) {
+        return SLOT_CORRUPTED;
+    }
+    sample = data.sample;
+    return SLOT_VALID;
+}
+
+int FlashLog::startSector(const Sample &first) {
+    uint32_t sector = sectorsInUse == 0 ? 0 : (activeSector + 1) % sectorCount;
+    Header previous;
+    uint32_t eraseCount = readHeader(sector, previous) ? previous.eraseCount : statistics.maxEraseCount;
+    if (sectorsInUse == sectorCount) {
+        // The oldest sector goes, whether the erase succeeds or not
+        --sectorsInUse;
+        Header oldest;
+        if (readHeader(logSector(0), oldest)) {
+            firstSeq = oldest.firstSequence;
+        }
+    }
+
+    ++statistics.erases;
+    int result = flash.erase(sectorAddress(sector), sectorSize);
+    if (result != 0) {
+        return result;
+    }
+    Header header{MAGIC, eraseCount + 1, first.sequence, first.time, 0};
+    header.crc = crc32(&header, offsetof(Header, crc));
+    result = flash.program(sectorAddress(sector), &header, sizeof(header));
+    if (result != 0) {
+        return result;
+    }
+
+    if (sectorsInUse == 0) {
+        firstSeq = first.sequence;
+    }
+    activeSector = sector;
+    ++sectorsInUse;
+    writeSlot = 0;
+    if (header.eraseCount > statistics.maxEraseCount) {
+        statistics.maxEraseCount = header.eraseCount;
+    }
+    return 0;
+}
+
+template<typename Key>
+FlashLog::Cursor FlashLog::seek(uint32_t value, Key key) {
+    Cursor end{nextSeq, activeSector, writeSlot};
+    if (!mounted || sectorsInUse == 0) {
+        return end;
+    }
+
+    // The last sector starting before the value, the first one if there is none
+    uint32_t low = 0;
+    uint32_t high = sectorsInUse;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        Header header;
+        if (!readHeader(logSector(middle), header) || key(header.firstSequence, header.firstTime) < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    uint32_t index = low == 0 ? 0 : low - 1;
+    uint32_t sector = logSector(index);
+
+    // The first intact sample not less than the value, torn slots are stepped over
+    Sample sample;
+    uint32_t found = slotsPerSector;
+    Cursor cursor = end;
+    low = 0;
+    high = slotsWritten(sector);
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        uint32_t slot = middle;
+        while (slot < high && readSlot(sector, slot, sample) != SLOT_VALID) {
+            ++slot;
+        }
+        if (slot == high) {
+            high = middle;
+        } else if (key(sample.sequence, sample.time) < value) {
+            low = slot + 1;
+        } else {
+            found = slot;
+            cursor = {sample.sequence, sector, slot};
+            high = middle;
+        }
+    }
+    if (found != slotsPerSector) {
+        return cursor;
+    }
+    if (index + 1 < sectorsInUse) {
+        Header next;
+        uint32_t nextSector = logSector(index + 1);
+        return {readHeader(nextSector, next) ? next.firstSequence : nextSeq, nextSector, 0};
+    }
+    return end;
+}
+
+bool FlashLog::isCurrent(const Cursor &cursor) {
+    if (cursor.sector >= sectorCount || cursor.slot > slotsPerSector
+        || (cursor.sector + sectorCount - logSector(0)) % sectorCount >= sectorsInUse) {
+        return false;
+    }
+    // A reused sector starts after the cursor
+    Header header;
+    return readHeader(cursor.sector, header) && header.firstSequence <= cursor.sequence;
+}
@@ -0,0 +1,161 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <cstdint>
+
+#include <HalFlash.h>
+
+/**
+ * Persistent time series in a flash region, written as a log. Samples are appended to the active
+ * sector, when it is full the next sector is erased and becomes active, so after the first pass
+ * every append of a sector overwrites the oldest one. Sectors are erased strictly in turn,
+ * which spreads wear evenly over the region.
+ *
+ * Every sample carries its sequence number and a CRC, sector headers carry the first sequence number
+ * and time of the sector. A reset at any point loses at most the sample being written: mount()
+ * skips a torn sample or a sector whose erase or header write was interrupted.
+ *
+ * Sequence numbers and times never decrease, so lookup by either is a binary search over the sector
+ * headers and then over the samples of one sector.
+ */
+class FlashLog {
+public:
+    /** Stored followed by CRC-32 of its bytes */
+    struct Sample {
+        uint32_t sequence;
+        uint32_t time; /* seconds */
+        int16_t temperature; /* 0.01 C */
+        uint16_t humidity; /* 0.01 % */
+        uint16_t pressure; /* 2 Pa */
+        uint16_t co2; /* ppm */
+    };
+
+    /** Read position, stays valid when the log rotates under it */
+    struct Cursor {
+        uint32_t sequence;
+        uint32_t sector;
+        uint32_t slot;
+    };
+
+    struct Stats {
+        uint32_t sectors = 0;
+        uint32_t slotsPerSector = 0;
+        uint32_t erases = 0;
+        uint32_t maxEraseCount = 0;
+        uint32_t errors = 0;
+    };
+
+    explicit FlashLog(hal::Flash &flash);
+
+    /**
+     * Find the written sectors and the end of the log. An empty or unreadable region is formatted
+     * on the first append.
+     * @return 0 on success
+     */
+    int mount();
+
+    bool isMounted() const {
+        return mounted;
+    }
+
+    /**
+     * @param sample sequence and time must not be less than the ones of the last sample
+     * @return 0 on success
+     */
+    int append(const Sample &sample);
+
+    /** Sequence number of the oldest sample, or nextSequence() if the log is empty */
+    uint32_t firstSequence() const;
+
+    /** One more than the sequence number of the last sample, 0 if the log is empty */
+    uint32_t nextSequence() const {
+        return nextSeq;
+    }
+
+    /** Time of the last sample */
+    uint32_t lastTime() const {
+        return lastSampleTime;
+    }
+
+    /** Cursor at the first sample with the sequence number not less than the given one */
+    Cursor seekSequence(uint32_t sequence);
+
+    /** Cursor at the first sample taken at or after the given time */
+    Cursor seekTime(uint32_t time);
+
+    /**
+     * Read the first intact sample at or after the cursor and advance it.
+     * @return false at the end of the log
+     */
+    bool read(Cursor &cursor, Sample &sample);
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t eraseCount;
+        uint32_t firstSequence;
+        uint32_t firstTime;
+        uint32_t crc;
+    };
+
+    struct Slot {
+        Sample sample;
+        uint32_t crc;
+    };
+
+    enum SlotState {
+        SLOT_ERASED,
+        SLOT_VALID,
+        SLOT_CORRUPTED,
+    };
+
+    uint32_t sectorAddress(uint32_t sector) const {
+        return sector * sectorSize;
+    }
+
+    uint32_t slotAddress(uint32_t sector, uint32_t slot) const {
+        return sectorAddress(sector) + sizeof(Header) + slot * sizeof(Slot);
+    }
+
+    /** Physical sector of the index-th sector of the log, counting from the oldest */
+    uint32_t logSector(uint32_t index) const {
+        return (activeSector + sectorCount - (sectorsInUse - 1) + index) % sectorCount;
+    }
+
+    /** Number of written slots of a sector of the log */
+    uint32_t slotsWritten(uint32_t sector) const {
+        return sector == activeSector ? writeSlot : slotsPerSector;
+    }
+
+    bool readHeader(uint32_t sector, Header &header);
+
+    SlotState readSlot(uint32_t sector, uint32_t slot, Sample &sample);
+
+    int startSector(const Sample &first);
+
+    template<typename Key>
+    Cursor seek(uint32_t value, Key key);
+
+    bool isCurrent(const Cursor &cursor);
+
+    hal::Flash &flash;
+    bool mounted = false;
+    uint32_t sectorSize = 0;
+    uint32_t sectorCount = 0;
+    uint32_t slotsPerSector = 0;
+    uint32_t activeSector = 0;
+    uint32_t sectorsInUse = 0;
+    uint32_t writeSlot = 0;
+    uint32_t nextSeq = 0;
+    uint32_t firstSeq = 0;
+    uint32_t lastSampleTime = 0;
+    Stats statistics;
+};
+
+static_assert(sizeof(FlashLog::Sample) == 16, "FlashLog::Sample must be packed");
+
+#endif // FLASH_LOG_H
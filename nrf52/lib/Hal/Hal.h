@@ -0,0 +1,20 @@
+#ifndef HAL_H
+#define HAL_H
+
+/**
+ * Hardware abstraction used by the firmware: the device build implements it on top of mbed
+ * (MbedHal.h), the native build on top of simulated peripherals (lib/Simulation).
+ */
+
+#include "HalBle.h"
+#include "HalCallback.h"
+#include "HalEventQueue.h"
+#include "HalFlash.h"
+#include "HalI2C.h"
+#include "HalRetained.h"
+#include "HalSerial.h"
+#include "HalSpi.h"
+#include "HalStaticEvent.h"
+#include "HalTime.h"
+
+#endif // HAL_H
@@ -0,0 +1,338 @@
+#ifndef HAL_BLE_H
+#define HAL_BLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "HalCallback.h"
+
+namespace hal {
+
+/**
+ * Error codes of BLE calls. Values match ble_error_t, so the mbed implementation passes them through.
+ */
+enum BleError {
+    BLE_ERROR_NONE = 0,
+    BLE_ERROR_BUFFER_OVERFLOW = 1,
+    BLE_ERROR_NOT_IMPLEMENTED = 2,
+    BLE_ERROR_PARAM_OUT_OF_RANGE = 3,
+    BLE_ERROR_INVALID_PARAM = 4,
+    BLE_ERROR_INVALID_STATE = 6,
+    BLE_ERROR_NO_MEM = 7,
+    BLE_ERROR_UNSPECIFIED = 11,
+};
+
+/** Identifies a connection in GAP and GATT calls, assigned by the stack */
+typedef uint16_t ConnectionHandle;
+
+/**
+ * Connection parameters in the units of the specification. A request gives the central a range of intervals,
+ * the parameters in use have minInterval == maxInterval.
+ */
+struct ConnectionParameters {
+    /** 1.25 ms units, 6 (7.5 ms) to 3200 (4 s) */
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    /** Connection events the peripheral may skip when it has nothing to send */
+    uint16_t slaveLatency;
+    /** 10 ms units, longer than (1 + slaveLatency) * maxInterval * 2 */
+    uint16_t supervisionTimeout;
+};
+
+/** LE physical layers, values match ble::phy_t */
+enum Phy : uint8_t {
+    PHY_1M = 1,
+    PHY_2M = 2,
+    PHY_CODED = 3,
+};
+
+/**
+ * Raw advertising payload: a sequence of length, type, data structures.
+ */
+class AdvertisingData {
+public:
+    enum Type : uint8_t {
+        FLAGS = 0x01,
+        COMPLETE_LIST_16BIT_SERVICE_IDS = 0x03,
+        SHORTENED_LOCAL_NAME = 0x08,
+        COMPLETE_LOCAL_NAME = 0x09,
+        SERVICE_DATA = 0x16,
+        APPEARANCE = 0x19,
+        MANUFACTURER_SPECIFIC_DATA = 0xFF,
+    };
+
+    enum Flags : uint8_t {
+        LE_GENERAL_DISCOVERABLE = 0x02,
+        BREDR_NOT_SUPPORTED = 0x04,
+    };
+
+    enum Appearance : uint16_t {
+        GENERIC_THERMOMETER = 768,
+    };
+
+    static const size_t MAX_LENGTH = 31;
+
+    int add(Type type, const void *data, size_t dataLength) {
+        if (length + 2 + dataLength > MAX_LENGTH) {
+            return BLE_ERROR_BUFFER_OVERFLOW;
+        }
+        payload[length++] = uint8_t(dataLength + 1);
+        payload[length++] = type;
+        memcpy(&payload[length], data, dataLength);
+        length += dataLength;
+        return BLE_ERROR_NONE;
+    }
+
+    void clear() {
+        length = 0;
+    }
+
+    const uint8_t *getPayload() const {
+        return payload;
+    }
+
+    size_t getLength() const {
+        return length;
+    }
+
+private:
+    uint8_t payload[MAX_LENGTH]{0};
+    size_t length = 0;
+};
+
+/**
+ * Bluetooth UUID, either a 16-bit SIG-assigned one or a 128-bit vendor-specific one.
+ * Long UUIDs are stored in the order they are written, most significant byte first.
+ */
+class Uuid {
+public:
+    static const size_t LONG_LENGTH = 16;
+
+    /** Zero short UUID, for attribute tables that are filled in later */
+    Uuid() : shortUuid(0) {}
+
+    Uuid(uint16_t shortUuid) : shortUuid(shortUuid) {}
+
+    explicit Uuid(const uint8_t (&longUuid)[LONG_LENGTH]) : shortUuid(0), isLong(true) {
+        memcpy(bytes, longUuid, LONG_LENGTH);
+    }
+
+    /**
+     * Vendor UUID derived from a base by replacing bytes 2 and 3, the way 16-bit SIG UUIDs
+     * are derived from the Bluetooth base UUID.
+     */
+    static Uuid fromBase(const uint8_t (&base)[LONG_LENGTH], uint16_t shortUuid) {
+        Uuid uuid(base);
+        uuid.bytes[2] = uint8_t(shortUuid >> 8);
+        uuid.bytes[3] = uint8_t(shortUuid);
+        return uuid;
+    }
+
+    bool isShort() const {
+        return !isLong;
+    }
+
+    uint16_t getShort() const {
+        return shortUuid;
+    }
+
+    /** Most significant byte first, only valid for long UUIDs */
+    const uint8_t *getLong() const {
+        return bytes;
+    }
+
+    bool operator==(const Uuid &other) const {
+        return isLong == other.isLong
+               && (isLong ? memcmp(bytes, other.bytes, LONG_LENGTH) == 0 : shortUuid == other.shortUuid);
+    }
+
+    bool operator!=(const Uuid &other) const {
+        return !(*this == other);
+    }
+
+private:
+    uint16_t shortUuid;
+    bool isLong = false;
+    uint8_t bytes[LONG_LENGTH]{0};
+};
+
+/**
+ * GATT server: registration of services and updates of characteristic values.
+ */
+class GattServer {
+public:
+    typedef uint16_t Handle;
+
+    enum Properties : uint8_t {
+        PROPERTY_READ = 0x02,
+        PROPERTY_WRITE_WITHOUT_RESPONSE = 0x04,
+        PROPERTY_WRITE = 0x08,
+        PROPERTY_NOTIFY = 0x10,
+        PROPERTY_INDICATE = 0x20,
+    };
+
+    /** ATT MTU every client supports, 20 bytes of notification payload */
+    static const uint16_t DEFAULT_ATT_MTU = 23;
+
+    /** Bytes taken by the ATT header of a notification */
+    static const uint16_t NOTIFICATION_HEADER_LENGTH = 3;
+
+    /**
+     * Characteristic descriptor, readable and optionally writable by clients. handle is assigned
+     * by addService(). The CCCD of notifying characteristics is added by the stack.
+     */
+    struct Descriptor {
+        Uuid uuid;
+        uint8_t *value;
+        uint16_t length;
+        uint16_t maxLength;
+        bool writable;
+        Handle handle;
+    };
+
+    /**
+     * Characteristic definition passed to addService(). The value buffer holds the initial value,
+     * valueHandle is assigned by addService(). The value has a variable length when maxLength
+     * is greater than length.
+     */
+    struct Characteristic {
+        Uuid uuid;
+        uint8_t properties;
+        uint8_t *value;
+        uint16_t length;
+        uint16_t maxLength;
+        Handle valueHandle;
+        Descriptor *descriptors;
+        uint8_t descriptorCount;
+    };
+
+    virtual ~GattServer() = default;
+
+    virtual int addService(const Uuid &uuid, Characteristic *characteristics, size_t count) = 0;
+
+    /**
+     * Update a characteristic or descriptor value and notify every subscribed client unless localOnly is set.
+     * Returns BLE_ERROR_NO_MEM when the stack had no room for the notification of some client,
+     * the value is updated anyway.
+     */
+    virtual int write(Handle handle, const uint8_t *value, uint16_t length, bool localOnly = false) = 0;
+
+    /**
+     * Update a characteristic value and notify one client, if it is subscribed.
+     * Returns BLE_ERROR_NO_MEM when the stack has no room for another notification,
+     * retry after the onDataSent() callback.
+     */
+    virtual int write(ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length) = 0;
+
+    /**
+     * Whether the client on the connection enabled notifications of the characteristic.
+     */
+    virtual bool areUpdatesEnabled(ConnectionHandle connection, Handle handle) = 0;
+
+    /**
+     * ATT MTU negotiated on the connection, DEFAULT_ATT_MTU if there was no exchange.
+     */
+    virtual uint16_t getAttMtu(ConnectionHandle connection) const = 0;
+
+    /**
+     * Called with the connection, the handle and the new value when a client writes a characteristic
+     * or a descriptor.
+     */
+    virtual void onDataWritten(
+            const Callback<void(ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) = 0;
+
+    /**
+     * Called with the value handle of a characteristic when some client enables or disables its
+     * notifications, areUpdatesEnabled() tells which clients are subscribed now.
+     */
+    virtual void onUpdatesChanged(const Callback<void(Handle)> &callback) = 0;
+
+    /**
+     * Called with the number of notifications sent since the previous call.
+     */
+    virtual void onDataSent(const Callback<void(unsigned)> &callback) = 0;
+};
+
+/**
+ * Generic access profile: advertising and connection state. The device is a peripheral,
+ * several centrals can be connected at the same time.
+ */
+class Gap {
+public:
+    virtual ~Gap() = default;
+
+    /** Whether any central is connected */
+    bool isConnected() const {
+        return getConnectionCount() != 0;
+    }
+
+    virtual uint8_t getConnectionCount() const = 0;
+
+    /** Connections the stack is configured for, connectable advertising fails once they are all taken */
+    virtual uint8_t getMaxConnections() const = 0;
+
+    /** Can be replaced while advertising */
+    virtual int setAdvertisingPayload(const AdvertisingData &data) = 0;
+
+    virtual int setScanResponse(const AdvertisingData &data) = 0;
+
+    /**
+     * Start undirected advertising, connectable or scannable only. The stack stops connectable advertising
+     * when a central connects, scannable advertising goes on.
+     */
+    virtual int startAdvertising(uint16_t intervalMs, bool connectable = true) = 0;
+
+    virtual int stopAdvertising() = 0;
+
+    virtual void onConnection(const Callback<void(ConnectionHandle)> &callback) = 0;
+
+    virtual void onDisconnection(const Callback<void(ConnectionHandle)> &callback) = 0;
+
+    /**
+     * Ask the central for other connection parameters. The central decides, the result comes through
+     * onConnectionUpdated() or never.
+     */
+    virtual int updateConnectionParameters(ConnectionHandle connection, const ConnectionParameters &parameters) = 0;
+
+    /** Parameters in use on the connection, as far as the stack reported them */
+    virtual int getConnectionParameters(ConnectionHandle connection, ConnectionParameters &parameters) const = 0;
+
+    /**
+     * Ask for a PHY on the connection, both directions. The larger data length that comes with 2M is
+     * negotiated by the stack. Returns BLE_ERROR_NOT_IMPLEMENTED when the stack cannot change the PHY.
+     */
+    virtual int setPreferredPhy(ConnectionHandle connection, Phy phy) = 0;
+
+    /** PHY in use on the connection, PHY_1M until an update completes */
+    virtual Phy getPhy(ConnectionHandle connection) const = 0;
+
+    /** Called when the parameters or the PHY of a connection changed */
+    virtual void onConnectionUpdated(const Callback<void(ConnectionHandle)> &callback) = 0;
+};
+
+/**
+ * BLE stack instance.
+ */
+class Ble {
+public:
+    /** StaticEvent objects an implementation keeps on the event queue */
+    static const size_t STATIC_EVENTS = 1;
+
+    virtual ~Ble() = default;
+
+    /**
+     * Initialize the stack. initComplete is called with a BleError code from the event queue.
+     */
+    virtual int init(const Callback<void(int)> &initComplete) = 0;
+
+    virtual Gap &gap() = 0;
+
+    virtual GattServer &gattServer() = 0;
+
+    virtual const char *errorToString(int error) const = 0;
+};
+
+}
+
+#endif // HAL_BLE_H
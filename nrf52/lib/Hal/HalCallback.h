@@ -0,0 +1,88 @@
+#ifndef HAL_CALLBACK_H
+#define HAL_CALLBACK_H
+
+#ifdef HAL_NATIVE
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace hal {
+
+template<typename Signature>
+class Callback;
+
+/**
+ * Host replacement of mbed::Callback. Supports the same construction forms that are used with mbed:
+ * empty, function pointer, object with member function and any other function object.
+ */
+template<typename R, typename... Args>
+class Callback<R(Args...)> {
+public:
+    Callback() = default;
+
+    Callback(std::nullptr_t) {}
+
+    Callback(R (*function)(Args...)) {
+        if (function != nullptr) {
+            target = function;
+        }
+    }
+
+    template<typename T, typename U>
+    Callback(U *object, R (T::*method)(Args...))
+            : target([object, method](Args... args) -> R {
+                  return (object->*method)(std::forward<Args>(args)...);
+              }) {}
+
+    template<typename T, typename U>
+    Callback(const U *object, R (T::*method)(Args...) const)
+            : target([object, method](Args... args) -> R {
+                  return (object->*method)(std::forward<Args>(args)...);
+              }) {}
+
+    template<typename F, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, Callback>::value
+            && !std::is_same<typename std::decay<F>::type, std::nullptr_t>::value
+            && !std::is_pointer<typename std::decay<F>::type>::value>::type>
+    Callback(F function) : target(std::move(function)) {}
+
+    R operator()(Args... args) const {
+        return target(std::forward<Args>(args)...);
+    }
+
+    R call(Args... args) const {
+        return target(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const {
+        return static_cast<bool>(target);
+    }
+
+private:
+    std::function<R(Args...)> target;
+};
+
+template<typename T, typename U, typename R, typename... Args>
+Callback<R(Args...)> callback(U *object, R (T::*method)(Args...)) {
+    return Callback<R(Args...)>(object, method);
+}
+
+}
+
+#else
+
+#include <mbed.h>
+
+namespace hal {
+
+template<typename Signature>
+using Callback = mbed::Callback<Signature>;
+
+using mbed::callback;
+
+}
+
+#endif
+
+#endif // HAL_CALLBACK_H
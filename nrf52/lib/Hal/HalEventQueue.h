@@ -0,0 +1,26 @@
+#ifndef HAL_EVENT_QUEUE_H
+#define HAL_EVENT_QUEUE_H
+
+#ifdef HAL_NATIVE
+
+#include "NativeEventQueue.h"
+
+namespace hal {
+
+using EventQueue = NativeEventQueue;
+
+}
+
+#else
+
+#include "MbedEventQueue.h"
+
+namespace hal {
+
+using EventQueue = MbedEventQueue;
+
+}
+
+#endif
+
+#endif // HAL_EVENT_QUEUE_H
@@ -0,0 +1,36 @@
+#ifndef HAL_FLASH_H
+#define HAL_FLASH_H
+
+#include <cstdint>
+
+namespace hal {
+
+/**
+ * Region of NOR flash. Calls follow mbed::FlashIAP, but addresses are offsets in the region.
+ * Erasing sets a whole sector to 0xFF, programming can only clear bits, 0 is returned on success.
+ */
+class Flash {
+public:
+    virtual ~Flash() = default;
+
+    virtual int init() = 0;
+
+    /** Smallest programmable unit, addresses and sizes of program() are multiples of it */
+    virtual uint32_t getProgramSize() const = 0;
+
+    virtual uint32_t getSectorSize() const = 0;
+
+    /** Size of the region, a multiple of the sector size */
+    virtual uint32_t getSize() const = 0;
+
+    virtual int read(uint32_t address, void *buffer, uint32_t size) = 0;
+
+    virtual int program(uint32_t address, const void *data, uint32_t size) = 0;
+
+    /** Erase whole sectors */
+    virtual int erase(uint32_t address, uint32_t size) = 0;
+};
+
+}
+
+#endif // HAL_FLASH_H
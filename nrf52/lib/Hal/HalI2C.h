@@ -0,0 +1,38 @@
+#ifndef HAL_I2C_H
+#define HAL_I2C_H
+
+#include "HalCallback.h"
+
+namespace hal {
+
+/**
+ * I2C bus master. Blocking calls follow mbed::I2C: address is the 8-bit form (7-bit address << 1)
+ * and 0 is returned on success.
+ */
+class I2C {
+public:
+    /** Bits passed to the transfer() completion callback */
+    enum Event {
+        EVENT_COMPLETE = 1 << 0,
+        EVENT_ERROR = 1 << 1,
+    };
+
+    virtual ~I2C() = default;
+
+    virtual int write(int address, const char *data, int length, bool repeated = false) = 0;
+
+    virtual int read(int address, char *data, int length, bool repeated = false) = 0;
+
+    /**
+     * Write txLength bytes and then read rxLength bytes after a repeated start, without blocking.
+     * Either part may be empty. The callback is called with EVENT_* bits once the transfer is over,
+     * possibly from interrupt context. Buffers must stay valid until then.
+     * @return 0 if the transfer was started
+     */
+    virtual int transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                         const Callback<void(int)> &callback) = 0;
+};
+
+}
+
+#endif // HAL_I2C_H
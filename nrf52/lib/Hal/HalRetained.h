@@ -0,0 +1,18 @@
+#ifndef HAL_RETAINED_H
+#define HAL_RETAINED_H
+
+/**
+ * Puts a variable of static storage duration into RAM the start-up code neither loads nor zeroes, the
+ * .noinit section of the mbed linker script. nRF52 RAM keeps its contents over a soft, watchdog or pin
+ * reset, so the variable holds what the previous run left there; after power-on it holds garbage.
+ * The type must be trivially constructible, a constructor would overwrite it at start-up.
+ *
+ * On the host it is an ordinary variable, zeroed when the program starts.
+ */
+#ifdef HAL_NATIVE
+#define HAL_RETAINED
+#else
+#define HAL_RETAINED __attribute__((section(".noinit")))
+#endif
+
+#endif // HAL_RETAINED_H
@@ -0,0 +1,48 @@
+#ifndef HAL_SERIAL_H
+#define HAL_SERIAL_H
+
+#include <cstdint>
+
+#include "HalCallback.h"
+
+namespace hal {
+
+/**
+ * Asynchronous UART, the subset of mbed::RawSerial used by the drivers.
+ */
+class Serial {
+public:
+    /** Bits passed to the write() completion callback, none if the write failed */
+    enum Event {
+        EVENT_TX_COMPLETE = 1 << 0,
+    };
+
+    virtual ~Serial() = default;
+
+    virtual bool writeable() = 0;
+
+    /**
+     * Start sending length bytes. The callback is called from interrupt context.
+     * @return 0 if the transfer was started
+     */
+    virtual int write(const uint8_t *buffer, int length, const Callback<void(int)> &callback) = 0;
+
+    /**
+     * Every byte received while the UART is enabled goes to the handler, called from interrupt context.
+     * Bytes arriving while the previous ones are handled are buffered by the driver. An empty handler
+     * stops reception.
+     */
+    virtual void setReceiveHandler(const Callback<void(uint8_t)> &handler) = 0;
+
+    virtual void abortWrite() = 0;
+
+    /**
+     * A disabled UART draws no current and lets the CPU sleep deeply, incoming bytes are lost.
+     * Writes must be aborted before disabling it.
+     */
+    virtual void setEnabled(bool enabled) = 0;
+};
+
+}
+
+#endif // HAL_SERIAL_H
@@ -0,0 +1,37 @@
+#ifndef HAL_SPI_H
+#define HAL_SPI_H
+
+#include "HalCallback.h"
+
+namespace hal {
+
+/**
+ * SPI master with the chip select of a single device. A transaction selects the device, clocks out
+ * txLength bytes and fill bytes after them until rxLength bytes came in, and deselects the device.
+ * Like mbed::SPI::write(), the received bytes start with the one clocked in during the first tx byte.
+ */
+class Spi {
+public:
+    /** Bits passed to the transfer() completion callback */
+    enum Event {
+        EVENT_COMPLETE = 1 << 0,
+        EVENT_ERROR = 1 << 1,
+    };
+
+    virtual ~Spi() = default;
+
+    /** @return 0 on success */
+    virtual int write(const char *txBuffer, int txLength, char *rxBuffer, int rxLength) = 0;
+
+    /**
+     * The same transaction without blocking. The callback is called with EVENT_* bits once it is over,
+     * possibly from interrupt context. Buffers must stay valid until then.
+     * @return 0 if the transaction was started
+     */
+    virtual int transfer(const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                         const Callback<void(int)> &callback) = 0;
+};
+
+}
+
+#endif // HAL_SPI_H
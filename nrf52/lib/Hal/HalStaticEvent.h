@@ -0,0 +1,112 @@
+#ifndef HAL_STATIC_EVENT_H
+#define HAL_STATIC_EVENT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "HalCallback.h"
+#include "HalEventQueue.h"
+
+#ifndef HAL_NATIVE
+#include <atomic>
+#endif
+
+namespace hal {
+
+/**
+ * A recurring event owned by the code that posts it. It is pending once or not at all: posting it again
+ * while it is pending keeps the pending one, so a burst of BLE stack events or received bytes collapses
+ * into one handler run and cannot crowd the other events out of the queue.
+ *
+ * Every static event holds SLOTS slots of SLOT_SIZE bytes of the queue, whether it is pending or not: the run
+ * being dispatched may post the next one before the queue has released it. Queues are sized for their static
+ * events plus the one-off calls (see App::EVENT_QUEUE_SIZE). On the device every post takes a chunk of the
+ * queue's buffer and the run gives it back, on the host the event is kept outside the queue and its slots are
+ * only subtracted from the capacity. A post the queue refuses all the same leaves the event not pending, so
+ * the next post tries again, and is counted in the staticDropped queue statistic.
+ *
+ * Of the events that are due, high-priority ones run first. A background event runs only when no high-priority
+ * one is due, one at a time: a high-priority event posted while a background handler runs waits for the rest
+ * of that handler and the high-priority events before it, never for more background work. BLE processing
+ * and the completions of interrupts are high-priority, periodic tasks and the work on their results
+ * background. The queue statistics show the longest wait and the longest background handler.
+ *
+ * post() and postIn() are safe in interrupt context. cancel() and isPending() are for the thread that
+ * dispatches the queue.
+ */
+class StaticEvent {
+public:
+    /** Queue slots to reserve for every static event */
+    static constexpr size_t SLOTS = 2;
+#ifdef HAL_NATIVE
+    static constexpr size_t SLOT_SIZE = EVENTS_EVENT_SIZE;
+#else
+    /** A run is a call of dispatch() with the generation: the equeue header and the callback with its argument */
+    static constexpr size_t SLOT_SIZE = (sizeof(struct equeue_event) + sizeof(MbedEventQueue::StaticRun)
+                                         + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+#endif
+
+    enum Priority {
+        HIGH,
+        BACKGROUND,
+    };
+
+    StaticEvent(EventQueue &eventQueue, const Callback<void()> &callback, Priority priority = HIGH);
+
+    ~StaticEvent();
+
+    StaticEvent(const StaticEvent &) = delete;
+
+    StaticEvent &operator=(const StaticEvent &) = delete;
+
+    /** Runs the callback on the queue as soon as possible */
+    void post() {
+        postIn(0);
+    }
+
+    /** Runs the callback on the queue in ms milliseconds. A pending event keeps its time, cancel it to move it. */
+    void postIn(int ms);
+
+    /** @return true if the event was pending */
+    bool cancel();
+
+    bool isPending() const;
+
+private:
+#ifdef HAL_NATIVE
+    friend class NativeEventQueue;
+
+    NativeEventQueue &eventQueue;
+    Callback<void()> callback;
+    const Priority priority;
+    bool pending = false;
+    uint64_t dueUs = 0;
+    uint64_t sequence = 0;
+    /** Queue work counters when posted for immediate dispatch, see NativeEventQueue::Stats */
+    NativeEventQueue::WorkStamp posted;
+    /** All static events of the queue, pending or not */
+    StaticEvent *next = nullptr;
+#else
+    friend class MbedEventQueue;
+
+    void dispatch(unsigned postedGeneration);
+
+    EventQueue &eventQueue;
+    Callback<void()> callback;
+    const Priority priority;
+    std::atomic<bool> pending{false};
+    int id = 0;
+    /** Changes on cancel(), a run posted before is stale */
+    unsigned generation = 0;
+    /** High-priority: posted for immediate dispatch, counted in the queue until it runs */
+    bool waiting = false;
+    MbedEventQueue::WorkStamp posted;
+    /** Background: due, in the queue's list of events waiting for the high-priority ones */
+    bool ready = false;
+    StaticEvent *nextReady = nullptr;
+#endif
+};
+
+}
+
+#endif // HAL_STATIC_EVENT_H
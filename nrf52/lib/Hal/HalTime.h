@@ -0,0 +1,90 @@
+#ifndef HAL_TIME_H
+#define HAL_TIME_H
+
+#include <cstdint>
+
+#ifndef HAL_NATIVE
+#include <mbed.h>
+#endif
+
+namespace hal {
+
+/** Where the CPU spent the time since the system start */
+struct CpuTime {
+    uint64_t awakeUs;
+    /** Sleeping with the high-frequency clock running, e.g. while a UART transfer holds it */
+    uint64_t sleepUs;
+    /** Sleeping on the low-frequency clock only */
+    uint64_t deepSleepUs;
+};
+
+#ifdef HAL_NATIVE
+
+/**
+ * Milliseconds since the simulation start, driven by the virtual clock of NativeEventQueue.
+ */
+uint64_t uptimeMs();
+
+/**
+ * Host time spent in event handlers counts as awake, the rest of the virtual time as deep sleep.
+ * The host is much faster than the device, so this is a lower bound of its awake time.
+ */
+CpuTime cpuTime();
+
+/**
+ * Free-running counter for timing code in nanoseconds, it wraps around. Virtual time, plus the host time
+ * spent in the current handler, so durations across handlers count virtual time and within one host time.
+ */
+uint32_t cycleCount();
+
+inline void startCycleCount() {}
+
+inline uint32_t cyclesPerUs() {
+    return 1000;
+}
+
+#else
+
+/**
+ * Milliseconds since the system start.
+ */
+inline uint64_t uptimeMs() {
+    return rtos::Kernel::get_ms_count();
+}
+
+/**
+ * Needs MBED_CPU_STATS_ENABLED, without it all of the time counts as awake.
+ */
+inline CpuTime cpuTime() {
+#if MBED_CPU_STATS_ENABLED
+    mbed_stats_cpu_t stats;
+    mbed_stats_cpu_get(&stats);
+    return {stats.uptime - stats.sleep_time - stats.deep_sleep_time, stats.sleep_time, stats.deep_sleep_time};
+#else
+    return {uptimeMs() * 1000, 0, 0};
+#endif
+}
+
+/**
+ * Free-running counter for timing code, the DWT cycle counter. It wraps around, after 67 s at 64 MHz.
+ * Call startCycleCount() once before using it.
+ */
+inline uint32_t cycleCount() {
+    return DWT->CYCCNT;
+}
+
+inline void startCycleCount() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+inline uint32_t cyclesPerUs() {
+    return SystemCoreClock / 1000000;
+}
+
+#endif
+
+}
+
+#endif // HAL_TIME_H
@@ -0,0 +1,375 @@
+#ifndef HAL_NATIVE
+
+#include <Profiler.h>
+
+#include "MbedBle.h"
+
+namespace hal {
+
+static UUID toMbedUuid(const Uuid &uuid) {
+    if (uuid.isShort()) {
+        return UUID(uuid.getShort());
+    }
+    return UUID(uuid.getLong(), UUID::MSB);
+}
+
+MbedGattServer::MbedGattServer(::GattServer &server, ::Gap &gap) : server(server) {
+    gap.onDisconnection(this, &MbedGattServer::onDisconnectionEvent);
+#if HAL_MBED_ATT_MTU_EVENTS
+    server.setEventHandler(this);
+#endif
+}
+
+int MbedGattServer::addService(const Uuid &uuid, Characteristic *characteristics, size_t count) {
+    // The stack keeps pointers to characteristics for the lifetime of the server, services are never removed
+    GattCharacteristic **table = new GattCharacteristic *[count];
+    for (size_t i = 0; i < count; ++i) {
+        const Characteristic &characteristic = characteristics[i];
+        GattAttribute **descriptors = nullptr;
+        if (characteristic.descriptorCount > 0) {
+            descriptors = new GattAttribute *[characteristic.descriptorCount];
+            for (uint8_t d = 0; d < characteristic.descriptorCount; ++d) {
+                const Descriptor &descriptor = characteristic.descriptors[d];
+                uint16_t maxLength = descriptor.maxLength > descriptor.length ? descriptor.maxLength : descriptor.length;
+                descriptors[d] = new GattAttribute(toMbedUuid(descriptor.uuid), descriptor.value,
+                                                   descriptor.length, maxLength, maxLength != descriptor.length);
+                if (!descriptor.writable) {
+                    descriptors[d]->allowWrite(false);
+                }
+            }
+        }
+        uint16_t maxLength = characteristic.maxLength > characteristic.length
+                             ? characteristic.maxLength : characteristic.length;
+        table[i] = new GattCharacteristic(toMbedUuid(characteristic.uuid), characteristic.value,
+                                          characteristic.length, maxLength,
+                                          characteristic.properties, descriptors, characteristic.descriptorCount,
+                                          maxLength != characteristic.length);
+    }
+
+    GattService service(toMbedUuid(uuid), table, count);
+    ble_error_t error = server.addService(service);
+    if (error == ::BLE_ERROR_NONE) {
+        for (size_t i = 0; i < count; ++i) {
+            characteristics[i].valueHandle = table[i]->getValueHandle();
+            for (uint8_t d = 0; d < characteristics[i].descriptorCount; ++d) {
+                characteristics[i].descriptors[d].handle = table[i]->getDescriptor(d)->getHandle();
+            }
+            characteristicList.push_back(table[i]);
+        }
+    }
+    return error;
+}
+
+int MbedGattServer::write(Handle handle, const uint8_t *value, uint16_t length, bool localOnly) {
+    return server.write(handle, value, length, localOnly);
+}
+
+int MbedGattServer::write(ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length) {
+    return server.write(connection, handle, value, length);
+}
+
+bool MbedGattServer::areUpdatesEnabled(ConnectionHandle connection, Handle handle) {
+    GattCharacteristic *characteristic = findCharacteristic(handle);
+    bool enabled = false;
+    return characteristic != nullptr
+           && server.areUpdatesEnabled(connection, *characteristic, &enabled) == ::BLE_ERROR_NONE && enabled;
+}
+
+uint16_t MbedGattServer::getAttMtu(ConnectionHandle connection) const {
+    for (const Link &link : links) {
+        if (link.used && link.handle == connection) {
+            return link.attMtu;
+        }
+    }
+    return DEFAULT_ATT_MTU;
+}
+
+void MbedGattServer::onDataWritten(
+        const Callback<void(ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) {
+    dataWrittenCallback = callback;
+    server.onDataWritten(this, &MbedGattServer::onDataWrittenEvent);
+}
+
+void MbedGattServer::onUpdatesChanged(const Callback<void(Handle)> &callback) {
+    updatesChangedCallback = callback;
+    server.onUpdatesEnabled({this, &MbedGattServer::onUpdatesEvent});
+    server.onUpdatesDisabled({this, &MbedGattServer::onUpdatesEvent});
+}
+
+void MbedGattServer::onDataSent(const Callback<void(unsigned)> &callback) {
+    dataSentCallback = callback;
+    server.onDataSent(this, &MbedGattServer::onDataSentEvent);
+}
+
+#if HAL_MBED_ATT_MTU_EVENTS
+void MbedGattServer::onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) {
+    Link *free = nullptr;
+    for (Link &link : links) {
+        if (link.used && link.handle == connectionHandle) {
+            link.attMtu = attMtuSize;
+            return;
+        }
+        if (!link.used && free == nullptr) {
+            free = &link;
+        }
+    }
+    if (free != nullptr) {
+        *free = {true, connectionHandle, attMtuSize};
+    }
+}
+#endif
+
+void MbedGattServer::onDataWrittenEvent(const GattWriteCallbackParams *params) {
+    dataWrittenCallback(params->connHandle, params->handle, params->data, params->len);
+}
+
+void MbedGattServer::onUpdatesEvent(GattAttribute::Handle_t handle) {
+    updatesChangedCallback(handle);
+}
+
+void MbedGattServer::onDataSentEvent(unsigned count) {
+    dataSentCallback(count);
+}
+
+void MbedGattServer::onDisconnectionEvent(const ::Gap::DisconnectionCallbackParams_t *params) {
+    for (Link &link : links) {
+        if (link.used && link.handle == params->handle) {
+            link.used = false;
+        }
+    }
+}
+
+GattCharacteristic *MbedGattServer::findCharacteristic(Handle handle) {
+    for (GattCharacteristic *characteristic : characteristicList) {
+        if (characteristic->getValueHandle() == handle) {
+            return characteristic;
+        }
+    }
+    return nullptr;
+}
+
+MbedGap::MbedGap(::Gap &gap) : gap(gap) {
+#if HAL_MBED_GAP_EVENTS
+    gap.setEventHandler(this);
+#endif
+}
+
+uint8_t MbedGap::getConnectionCount() const {
+    return connectionCount;
+}
+
+uint8_t MbedGap::getMaxConnections() const {
+    return HAL_MBED_MAX_CONNECTIONS;
+}
+
+static ble_error_t toGapAdvertisingData(const AdvertisingData &data, GapAdvertisingData &advertisingData) {
+    const uint8_t *payload = data.getPayload();
+    for (size_t i = 0; i + 1 < data.getLength(); i += payload[i] + 1) {
+        ble_error_t error = advertisingData.addData((GapAdvertisingData::DataType_t) payload[i + 1],
+                                                    &payload[i + 2], payload[i] - 1);
+        if (error != ::BLE_ERROR_NONE) {
+            return error;
+        }
+    }
+    return ::BLE_ERROR_NONE;
+}
+
+int MbedGap::setAdvertisingPayload(const AdvertisingData &data) {
+    GapAdvertisingData advertisingData;
+    ble_error_t error = toGapAdvertisingData(data, advertisingData);
+    if (error != ::BLE_ERROR_NONE) {
+        return error;
+    }
+    return gap.setAdvertisingPayload(advertisingData);
+}
+
+int MbedGap::setScanResponse(const AdvertisingData &data) {
+    GapAdvertisingData scanResponse;
+    ble_error_t error = toGapAdvertisingData(data, scanResponse);
+    if (error != ::BLE_ERROR_NONE) {
+        return error;
+    }
+    return gap.setAdvertisingScanResponse(scanResponse);
+}
+
+int MbedGap::startAdvertising(uint16_t intervalMs, bool connectable) {
+    gap.setAdvertisingType(connectable ? GapAdvertisingParams::ADV_CONNECTABLE_UNDIRECTED
+                                       : GapAdvertisingParams::ADV_SCANNABLE_UNDIRECTED);
+    gap.setAdvertisingInterval(intervalMs);
+    return gap.startAdvertising();
+}
+
+int MbedGap::stopAdvertising() {
+    return gap.stopAdvertising();
+}
+
+void MbedGap::onConnection(const Callback<void(ConnectionHandle)> &callback) {
+    connectionCallback = callback;
+    gap.onConnection(this, &MbedGap::onConnectionEvent);
+}
+
+void MbedGap::onDisconnection(const Callback<void(ConnectionHandle)> &callback) {
+    disconnectionCallback = callback;
+    gap.onDisconnection(this, &MbedGap::onDisconnectionEvent);
+}
+
+int MbedGap::updateConnectionParameters(ConnectionHandle connection, const ConnectionParameters &parameters) {
+    Link *link = findLink(connection);
+    if (link == nullptr) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    const ::Gap::ConnectionParams_t params{parameters.minInterval, parameters.maxInterval, parameters.slaveLatency,
+                                           parameters.supervisionTimeout};
+    ble_error_t error = gap.updateConnectionParams(connection, &params);
+#if !HAL_MBED_GAP_EVENTS
+    // Nothing reports the interval the central picks, the requested range stands for it
+    if (error == ::BLE_ERROR_NONE) {
+        link->parameters = parameters;
+        if (connectionUpdatedCallback) {
+            connectionUpdatedCallback(connection);
+        }
+    }
+#endif
+    return error;
+}
+
+int MbedGap::getConnectionParameters(ConnectionHandle connection, ConnectionParameters &parameters) const {
+    const Link *link = findLink(connection);
+    if (link == nullptr) {
+        return BLE_ERROR_INVALID_PARAM;
+    }
+    parameters = link->parameters;
+    return BLE_ERROR_NONE;
+}
+
+int MbedGap::setPreferredPhy(ConnectionHandle connection, Phy phy) {
+#if HAL_MBED_GAP_EVENTS
+    const ble::phy_set_t phys(phy == PHY_1M, phy == PHY_2M, phy == PHY_CODED);
+    return gap.setPhy(connection, &phys, &phys, ble::coded_symbol_per_bit_t::UNDEFINED);
+#else
+    return BLE_ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+Phy MbedGap::getPhy(ConnectionHandle connection) const {
+    const Link *link = findLink(connection);
+    return link != nullptr ? link->phy : PHY_1M;
+}
+
+void MbedGap::onConnectionUpdated(const Callback<void(ConnectionHandle)> &callback) {
+    connectionUpdatedCallback = callback;
+}
+
+#if HAL_MBED_GAP_EVENTS
+void MbedGap::onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) {
+    Link *link = findLink(event.getConnectionHandle());
+    if (event.getStatus() != ::BLE_ERROR_NONE || link == nullptr) {
+        return;
+    }
+    const uint16_t interval = event.getConnectionInterval().value();
+    link->parameters = {interval, interval, event.getSlaveLatency().value(), event.getSupervisionTimeout().value()};
+    if (connectionUpdatedCallback) {
+        connectionUpdatedCallback(link->handle);
+    }
+}
+
+void MbedGap::onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connectionHandle, ble::phy_t txPhy,
+                                  ble::phy_t rxPhy) {
+    Link *link = findLink(connectionHandle);
+    if (status != ::BLE_ERROR_NONE || link == nullptr) {
+        return;
+    }
+    // Notifications go out, so the transmitting side is the one that counts
+    link->phy = Phy(txPhy.value());
+    if (connectionUpdatedCallback) {
+        connectionUpdatedCallback(link->handle);
+    }
+}
+#endif
+
+void MbedGap::onConnectionEvent(const ::Gap::ConnectionCallbackParams_t *params) {
+    ++connectionCount;
+    for (Link &link : links) {
+        if (!link.used) {
+            const ::Gap::ConnectionParams_t *current = params->connectionParams;
+            link = {true, params->handle,
+                    {current->minConnectionInterval, current->maxConnectionInterval, current->slaveLatency,
+                     current->connectionSupervisionTimeout}, PHY_1M};
+            break;
+        }
+    }
+    connectionCallback(params->handle);
+}
+
+void MbedGap::onDisconnectionEvent(const ::Gap::DisconnectionCallbackParams_t *params) {
+    if (connectionCount > 0) {
+        --connectionCount;
+    }
+    if (Link *link = findLink(params->handle)) {
+        link->used = false;
+    }
+    disconnectionCallback(params->handle);
+}
+
+MbedGap::Link *MbedGap::findLink(ConnectionHandle connection) {
+    for (Link &link : links) {
+        if (link.used && link.handle == connection) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+const MbedGap::Link *MbedGap::findLink(ConnectionHandle connection) const {
+    for (const Link &link : links) {
+        if (link.used && link.handle == connection) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+MbedBle::MbedBle(EventQueue &eventQueue)
+        : processingEvent(eventQueue, callback(this, &MbedBle::processEvents)),
+          ble(BLE::Instance()),
+          gapImpl(ble.gap()),
+          gattServerImpl(ble.gattServer(), ble.gap()) {}
+
+int MbedBle::init(const Callback<void(int)> &initComplete) {
+    initCompleteCallback = initComplete;
+    ble.onEventsToProcess({this, &MbedBle::scheduleEventProcessing});
+    return ble.init(this, &MbedBle::onInitComplete);
+}
+
+Gap &MbedBle::gap() {
+    return gapImpl;
+}
+
+GattServer &MbedBle::gattServer() {
+    return gattServerImpl;
+}
+
+const char *MbedBle::errorToString(int error) const {
+    return BLE::errorToString((ble_error_t) error);
+}
+
+void MbedBle::scheduleEventProcessing(BLE::OnEventsToProcessCallbackContext *context) {
+    processingEvent.post();
+}
+
+void MbedBle::processEvents() {
+    PROFILE_SCOPE(BLE_STACK);
+    ble.processEvents();
+}
+
+void MbedBle::onInitComplete(BLE::InitializationCompleteCallbackContext *context) {
+    if (context->error == ::BLE_ERROR_NONE && context->ble.getInstanceID() != BLE::DEFAULT_INSTANCE) {
+        initCompleteCallback(BLE_ERROR_INVALID_STATE);
+        return;
+    }
+    initCompleteCallback(context->error);
+}
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef HAL_MBED_BLE_H
+#define HAL_MBED_BLE_H
+
+#ifndef HAL_NATIVE
+
+#include <ble/BLE.h>
+#include <ble/Gap.h>
+#include <ble/GattCharacteristic.h>
+#include "HalEventQueue.h"
+#include "HalStaticEvent.h"
+#include <mbed.h>
+
+#include <vector>
+
+#include "HalBle.h"
+
+// ATT MTU change events were added to the GattServer in mbed OS 5.10
+#if MBED_VERSION >= MBED_ENCODE_VERSION(5, 10, 0)
+#define HAL_MBED_ATT_MTU_EVENTS 1
+#else
+#define HAL_MBED_ATT_MTU_EVENTS 0
+#endif
+
+// Connection parameter and PHY update events came with the Gap event handler of mbed OS 5.12,
+// before that a parameter request is assumed to take effect
+#if MBED_VERSION >= MBED_ENCODE_VERSION(5, 12, 0)
+#define HAL_MBED_GAP_EVENTS 1
+#else
+#define HAL_MBED_GAP_EVENTS 0
+#endif
+
+// Connections the BLE stack is configured for: cordio.max-connections with the Cordio stack,
+// the peripheral link count of sdk_config.h with the SoftDevice, a single link if neither is known
+#ifndef HAL_MBED_MAX_CONNECTIONS
+#if defined(MBED_CONF_CORDIO_MAX_CONNECTIONS)
+#define HAL_MBED_MAX_CONNECTIONS MBED_CONF_CORDIO_MAX_CONNECTIONS
+#else
+#if defined(__has_include)
+#if __has_include(<sdk_config.h>)
+#include <sdk_config.h>
+#endif
+#endif
+#if defined(NRF_SDH_BLE_PERIPHERAL_LINK_COUNT)
+#define HAL_MBED_MAX_CONNECTIONS NRF_SDH_BLE_PERIPHERAL_LINK_COUNT
+#else
+#define HAL_MBED_MAX_CONNECTIONS 1
+#endif
+#endif
+#endif
+
+namespace hal {
+
+class MbedGattServer : public GattServer
+#if HAL_MBED_ATT_MTU_EVENTS
+        , private ::GattServer::EventHandler
+#endif
+{
+public:
+    MbedGattServer(::GattServer &server, ::Gap &gap);
+
+    int addService(const Uuid &uuid, Characteristic *characteristics, size_t count) override;
+
+    int write(Handle handle, const uint8_t *value, uint16_t length, bool localOnly = false) override;
+
+    int write(ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length) override;
+
+    bool areUpdatesEnabled(ConnectionHandle connection, Handle handle) override;
+
+    uint16_t getAttMtu(ConnectionHandle connection) const override;
+
+    void onDataWritten(const Callback<void(ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) override;
+
+    void onUpdatesChanged(const Callback<void(Handle)> &callback) override;
+
+    void onDataSent(const Callback<void(unsigned)> &callback) override;
+
+private:
+    /** ATT MTU of a connection, the stack does not keep it for the legacy API */
+    struct Link {
+        bool used;
+        ConnectionHandle handle;
+        uint16_t attMtu;
+    };
+
+#if HAL_MBED_ATT_MTU_EVENTS
+    void onAttMtuChange(ble::connection_handle_t connectionHandle, uint16_t attMtuSize) override;
+#endif
+
+    void onDataWrittenEvent(const GattWriteCallbackParams *params);
+
+    void onUpdatesEvent(GattAttribute::Handle_t handle);
+
+    void onDataSentEvent(unsigned count);
+
+    void onDisconnectionEvent(const ::Gap::DisconnectionCallbackParams_t *params);
+
+    GattCharacteristic *findCharacteristic(Handle handle);
+
+    ::GattServer &server;
+    std::vector<GattCharacteristic *> characteristicList;
+    Link links[HAL_MBED_MAX_CONNECTIONS]{};
+    Callback<void(ConnectionHandle, Handle, const uint8_t *, uint16_t)> dataWrittenCallback;
+    Callback<void(Handle)> updatesChangedCallback;
+    Callback<void(unsigned)> dataSentCallback;
+};
+
+class MbedGap : public Gap
+#if HAL_MBED_GAP_EVENTS
+        , private ::Gap::EventHandler
+#endif
+{
+public:
+    explicit MbedGap(::Gap &gap);
+
+    uint8_t getConnectionCount() const override;
+
+    uint8_t getMaxConnections() const override;
+
+    int setAdvertisingPayload(const AdvertisingData &data) override;
+
+    int setScanResponse(const AdvertisingData &data) override;
+
+    int startAdvertising(uint16_t intervalMs, bool connectable = true) override;
+
+    int stopAdvertising() override;
+
+    void onConnection(const Callback<void(ConnectionHandle)> &callback) override;
+
+    void onDisconnection(const Callback<void(ConnectionHandle)> &callback) override;
+
+    int updateConnectionParameters(ConnectionHandle connection, const ConnectionParameters &parameters) override;
+
+    int getConnectionParameters(ConnectionHandle connection, ConnectionParameters &parameters) const override;
+
+    int setPreferredPhy(ConnectionHandle connection, Phy phy) override;
+
+    Phy getPhy(ConnectionHandle connection) const override;
+
+    void onConnectionUpdated(const Callback<void(ConnectionHandle)> &callback) override;
+
+private:
+    /** Parameters and PHY of a connection, the legacy API only reports them in events */
+    struct Link {
+        bool used;
+        ConnectionHandle handle;
+        ConnectionParameters parameters;
+        Phy phy;
+    };
+
+#if HAL_MBED_GAP_EVENTS
+    void onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) override;
+
+    void onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connectionHandle, ble::phy_t txPhy,
+                             ble::phy_t rxPhy) override;
+#endif
+
+    void onConnectionEvent(const ::Gap::ConnectionCallbackParams_t *params);
+
+    void onDisconnectionEvent(const ::Gap::DisconnectionCallbackParams_t *params);
+
+    Link *findLink(ConnectionHandle connection);
+
+    const Link *findLink(ConnectionHandle connection) const;
+
+    ::Gap &gap;
+    uint8_t connectionCount = 0;
+    Link links[HAL_MBED_MAX_CONNECTIONS]{};
+    Callback<void(ConnectionHandle)> connectionCallback;
+    Callback<void(ConnectionHandle)> disconnectionCallback;
+    Callback<void(ConnectionHandle)> connectionUpdatedCallback;
+};
+
+/**
+ * The default BLE instance. Stack events are processed on the given event queue, through a static event:
+ * however many the stack signals, one processing run at a time is pending.
+ */
+class MbedBle : public Ble {
+public:
+    explicit MbedBle(EventQueue &eventQueue);
+
+    int init(const Callback<void(int)> &initComplete) override;
+
+    Gap &gap() override;
+
+    GattServer &gattServer() override;
+
+    const char *errorToString(int error) const override;
+
+private:
+    void scheduleEventProcessing(BLE::OnEventsToProcessCallbackContext *context);
+
+    void processEvents();
+
+    void onInitComplete(BLE::InitializationCompleteCallbackContext *context);
+
+    StaticEvent processingEvent;
+    BLE &ble;
+    MbedGap gapImpl;
+    MbedGattServer gattServerImpl;
+    Callback<void(int)> initCompleteCallback;
+};
+
+}
+
+#endif
+
+#endif // HAL_MBED_BLE_H
@@ -0,0 +1,164 @@
+#ifndef HAL_NATIVE
+
+#include <algorithm>
+
+#include "HalStaticEvent.h"
+#include "HalTime.h"
+
+namespace hal {
+
+const size_t MbedEventQueue::STATIC_EVENTS;
+
+MbedEventQueue::WorkStamp MbedEventQueue::stamp() {
+    WorkStamp stamp;
+    stamp.cycles = cycleCount();
+    stamp.backgroundCycles = backgroundCycles + (inBackground ? stamp.cycles - backgroundStart : 0);
+    return stamp;
+}
+
+void MbedEventQueue::recordWait(const WorkStamp &posted) {
+    maxWaitCycles = std::max(maxWaitCycles, cycleCount() - posted.cycles);
+    maxWaitBackgroundCycles = std::max(maxWaitBackgroundCycles, backgroundCycles - posted.backgroundCycles);
+}
+
+void MbedEventQueue::makeReady(StaticEvent *event) {
+    event->ready = true;
+    event->nextReady = nullptr;
+    if (readyTail != nullptr) {
+        readyTail->nextReady = event;
+    } else {
+        readyHead = event;
+    }
+    readyTail = event;
+    postBackground();
+}
+
+void MbedEventQueue::postBackground() {
+    if (!backgroundPosted && readyHead != nullptr) {
+        // A failed post is retried after the next static event runs
+        backgroundPosted = call(this, &MbedEventQueue::dispatchBackground) != 0;
+        if (!backgroundPosted) {
+            staticDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MbedEventQueue::removeReady(StaticEvent *event) {
+    StaticEvent *previous = nullptr;
+    for (StaticEvent *item = readyHead; item != nullptr; previous = item, item = item->nextReady) {
+        if (item == event) {
+            (previous != nullptr ? previous->nextReady : readyHead) = item->nextReady;
+            if (readyTail == item) {
+                readyTail = previous;
+            }
+            break;
+        }
+    }
+    event->ready = false;
+}
+
+void MbedEventQueue::dispatchBackground() {
+    backgroundPosted = false;
+    if (readyHead == nullptr) {
+        return;
+    }
+    StaticEvent *event = nullptr;
+    if (waiting.load() == 0) {
+        event = readyHead;
+        removeReady(event);
+    }
+    // Behind the events posted until now, high-priority ones included
+    postBackground();
+    if (event == nullptr) {
+        return;
+    }
+    event->id = 0;
+    event->pending = false;
+    backgroundStart = cycleCount();
+    inBackground = true;
+    event->callback();
+    uint32_t elapsed = cycleCount() - backgroundStart;
+    inBackground = false;
+    backgroundCycles = backgroundCycles + elapsed;
+    ++backgroundDispatched;
+    maxBackgroundCycles = std::max(maxBackgroundCycles, elapsed);
+}
+
+constexpr size_t StaticEvent::SLOTS;
+constexpr size_t StaticEvent::SLOT_SIZE;
+
+StaticEvent::StaticEvent(EventQueue &eventQueue, const Callback<void()> &callback, Priority priority)
+        : eventQueue(eventQueue), callback(callback), priority(priority) {}
+
+StaticEvent::~StaticEvent() {
+    cancel();
+}
+
+void StaticEvent::postIn(int ms) {
+    if (pending.exchange(true)) {
+        return;
+    }
+    if (priority == HIGH && ms <= 0) {
+        posted = eventQueue.stamp();
+        waiting = true;
+        ++eventQueue.waiting;
+    }
+    // The queue is sized for SLOTS chunks of SLOT_SIZE per static event, so this takes a free chunk of its buffer
+    id = eventQueue.call_in(ms, this, &StaticEvent::dispatch, generation);
+    if (id == 0) {
+        eventQueue.staticDropped.fetch_add(1, std::memory_order_relaxed);
+        if (waiting) {
+            waiting = false;
+            --eventQueue.waiting;
+        }
+        pending = false;
+    }
+}
+
+bool StaticEvent::cancel() {
+    if (!pending) {
+        return false;
+    }
+    // The event may have left the queue already for the dispatch in progress, it finds itself stale then
+    eventQueue.cancel(id);
+    if (ready) {
+        eventQueue.removeReady(this);
+    }
+    if (waiting) {
+        waiting = false;
+        --eventQueue.waiting;
+    }
+    ++generation;
+    id = 0;
+    pending = false;
+    return true;
+}
+
+bool StaticEvent::isPending() const {
+    return pending;
+}
+
+void StaticEvent::dispatch(unsigned postedGeneration) {
+    if (postedGeneration != generation) {
+        return;
+    }
+    if (priority == BACKGROUND) {
+        // Stays pending until the background dispatch runs it
+        eventQueue.makeReady(this);
+        return;
+    }
+    if (waiting) {
+        waiting = false;
+        --eventQueue.waiting;
+        eventQueue.recordWait(posted);
+    }
+    // Posts from interrupts while the callback runs queue the next run
+    id = 0;
+    pending = false;
+    callback();
+    eventQueue.postBackground();
+}
+
+}
+
+#endif
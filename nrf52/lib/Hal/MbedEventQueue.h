@@ -0,0 +1,130 @@
+#ifndef HAL_MBED_EVENT_QUEUE_H
+#define HAL_MBED_EVENT_QUEUE_H
+
+#ifndef HAL_NATIVE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <events/EventQueue.h>
+
+namespace hal {
+
+class StaticEvent;
+
+/**
+ * events::EventQueue that counts the events it could not take and how full it has been.
+ * The posting methods hide the ones of the base class, post through this type to count drops.
+ *
+ * The queue dispatches all events that are due in one batch, so background static events are not run by it
+ * directly. When one is due it joins a list, and a dispatch event runs the first one of the list and posts
+ * itself again for the next: behind the high-priority events posted meanwhile. It does not run one at all
+ * while a high-priority static event posted for immediate dispatch is waiting, it only posts itself again.
+ */
+class MbedEventQueue : public events::EventQueue {
+public:
+    /** The background dispatch event */
+    static const size_t STATIC_EVENTS = 1;
+
+    /** Times are in hal::cycleCount() units, CPU cycles */
+    struct Stats {
+        uint32_t dropped;
+        /** Posts of static events among the dropped ones */
+        uint32_t staticDropped;
+        /** In events of EVENTS_EVENT_SIZE, from the part of the buffer ever allocated */
+        size_t highWaterMark;
+        uint32_t backgroundDispatched;
+        /** Longest time a high-priority static event posted for immediate dispatch waited for its handler */
+        uint32_t maxWaitCycles;
+        /** Longest part of such a wait spent in a background handler, at most maxBackgroundCycles */
+        uint32_t maxWaitBackgroundCycles;
+        uint32_t maxBackgroundCycles;
+    };
+
+    /** What a post of a static event allocates in the queue: the context of call_in(ms, event, method, generation) */
+    struct StaticRun {
+        mbed::Callback<void(unsigned)> callback;
+        unsigned generation;
+    };
+
+    /** Cycle counter and background cycles when an event was posted */
+    struct WorkStamp {
+        uint32_t cycles = 0;
+        uint32_t backgroundCycles = 0;
+    };
+
+    explicit MbedEventQueue(size_t size = EVENTS_QUEUE_SIZE) : events::EventQueue(size), size(size) {}
+
+    template<typename... Args>
+    int call(Args &&... args) {
+        return counted(events::EventQueue::call(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    int call_in(Args &&... args) {
+        return counted(events::EventQueue::call_in(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    int call_every(Args &&... args) {
+        return counted(events::EventQueue::call_every(std::forward<Args>(args)...));
+    }
+
+    Stats stats() const {
+        // Freed events are reused before the untouched rest of the slab, so its size only shrinks
+        return {dropped.load(std::memory_order_relaxed), staticDropped.load(std::memory_order_relaxed),
+                (size - _equeue.slab.size) / EVENTS_EVENT_SIZE,
+                backgroundDispatched, maxWaitCycles, maxWaitBackgroundCycles, maxBackgroundCycles};
+    }
+
+private:
+    friend class StaticEvent;
+
+    /** Interrupt context too */
+    WorkStamp stamp();
+
+    /** A high-priority event posted with stamp() runs now */
+    void recordWait(const WorkStamp &posted);
+
+    /** The background event is due */
+    void makeReady(StaticEvent *event);
+
+    void removeReady(StaticEvent *event);
+
+    void dispatchBackground();
+
+    /** Posts the background dispatch if background events are ready and it is not posted */
+    void postBackground();
+
+    int counted(int id) {
+        if (id == 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return id;
+    }
+
+    const size_t size;
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> staticDropped{0};
+    /** High-priority static events posted for immediate dispatch that did not run yet */
+    std::atomic<uint32_t> waiting{0};
+    StaticEvent *readyHead = nullptr;
+    StaticEvent *readyTail = nullptr;
+    bool backgroundPosted = false;
+    /** Written by the dispatching thread, read in interrupt context by stamp() */
+    volatile bool inBackground = false;
+    volatile uint32_t backgroundStart = 0;
+    volatile uint32_t backgroundCycles = 0;
+    uint32_t backgroundDispatched = 0;
+    uint32_t maxWaitCycles = 0;
+    uint32_t maxWaitBackgroundCycles = 0;
+    uint32_t maxBackgroundCycles = 0;
+};
+
+}
+
+#endif
+
+#endif // HAL_MBED_EVENT_QUEUE_H
@@ -0,0 +1,64 @@
+#ifndef HAL_NATIVE
+
+#include "MbedFlash.h"
+
+#if DEVICE_FLASH
+
+// Older mbed OS releases do not define it, the GCC linker scripts have the symbols
+#if !defined(FLASHIAP_APP_ROM_END_ADDR) && defined(__GNUC__)
+extern uint32_t __etext, __data_start__, __data_end__;
+#define FLASHIAP_APP_ROM_END_ADDR ((uint32_t) &__etext + ((uint32_t) &__data_end__ - (uint32_t) &__data_start__))
+#endif
+
+namespace hal {
+
+MbedFlash::MbedFlash(uint32_t regionSize) : regionSize(regionSize) {}
+
+int MbedFlash::init() {
+    int result = flash.init();
+    if (result != 0) {
+        return result;
+    }
+    uint32_t flashEnd = flash.get_flash_start() + flash.get_flash_size();
+    if (regionSize > flash.get_flash_size() || regionSize % flash.get_sector_size(flashEnd - 1) != 0) {
+        return -1;
+    }
+    regionStart = flashEnd - regionSize;
+#ifdef FLASHIAP_APP_ROM_END_ADDR
+    // The image is the code followed by the initial values of the data
+    if (FLASHIAP_APP_ROM_END_ADDR > regionStart) {
+        return -2;
+    }
+#endif
+    return 0;
+}
+
+uint32_t MbedFlash::getProgramSize() const {
+    return flash.get_page_size();
+}
+
+uint32_t MbedFlash::getSectorSize() const {
+    return flash.get_sector_size(regionStart);
+}
+
+uint32_t MbedFlash::getSize() const {
+    return regionSize;
+}
+
+int MbedFlash::read(uint32_t address, void *buffer, uint32_t size) {
+    return flash.read(buffer, regionStart + address, size);
+}
+
+int MbedFlash::program(uint32_t address, const void *data, uint32_t size) {
+    return flash.program(data, regionStart + address, size);
+}
+
+int MbedFlash::erase(uint32_t address, uint32_t size) {
+    return flash.erase(regionStart + address, size);
+}
+
+}
+
+#endif
+
+#endif
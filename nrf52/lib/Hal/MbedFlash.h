@@ -0,0 +1,49 @@
+#ifndef HAL_MBED_FLASH_H
+#define HAL_MBED_FLASH_H
+
+#ifndef HAL_NATIVE
+
+#include <mbed.h>
+
+#include "HalFlash.h"
+
+namespace hal {
+
+#if DEVICE_FLASH
+
+/**
+ * The last regionSize bytes of the internal flash, which the linker must leave free (see mbed_app.json).
+ * init() fails if the firmware image reaches into the region, rather than let the log erase code.
+ * Erasing a page stalls the CPU for up to 85 ms on nRF52.
+ */
+class MbedFlash : public Flash {
+public:
+    explicit MbedFlash(uint32_t regionSize);
+
+    int init() override;
+
+    uint32_t getProgramSize() const override;
+
+    uint32_t getSectorSize() const override;
+
+    uint32_t getSize() const override;
+
+    int read(uint32_t address, void *buffer, uint32_t size) override;
+
+    int program(uint32_t address, const void *data, uint32_t size) override;
+
+    int erase(uint32_t address, uint32_t size) override;
+
+private:
+    mbed::FlashIAP flash;
+    uint32_t regionSize;
+    uint32_t regionStart = 0;
+};
+
+#endif
+
+}
+
+#endif
+
+#endif // HAL_MBED_FLASH_H
@@ -0,0 +1,14 @@
+#ifndef HAL_MBED_HAL_H
+#define HAL_MBED_HAL_H
+
+/**
+ * Implementation of the hardware abstraction on top of mbed drivers and BLE API.
+ */
+
+#include "MbedBle.h"
+#include "MbedFlash.h"
+#include "MbedI2C.h"
+#include "MbedSerial.h"
+#include "MbedSpi.h"
+
+#endif // HAL_MBED_HAL_H
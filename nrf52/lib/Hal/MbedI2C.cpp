@@ -0,0 +1,45 @@
+#ifndef HAL_NATIVE
+
+#include "MbedI2C.h"
+
+namespace hal {
+
+MbedI2C::MbedI2C(PinName sda, PinName scl) : i2c(sda, scl) {}
+
+int MbedI2C::write(int address, const char *data, int length, bool repeated) {
+    return i2c.write(address, data, length, repeated);
+}
+
+int MbedI2C::read(int address, char *data, int length, bool repeated) {
+    return i2c.read(address, data, length, repeated);
+}
+
+int MbedI2C::transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                      const Callback<void(int)> &callback) {
+#if DEVICE_I2C_ASYNCH
+    transferCallback = callback;
+    return i2c.transfer(address, txBuffer, txLength, rxBuffer, rxLength,
+                        mbed::callback(this, &MbedI2C::onTransferEvent), I2C_EVENT_ALL);
+#else
+    int result = 0;
+    if (txLength > 0) {
+        result = i2c.write(address, txBuffer, txLength, rxLength > 0);
+    }
+    if (result == 0 && rxLength > 0) {
+        result = i2c.read(address, rxBuffer, rxLength);
+    }
+    callback(result == 0 ? EVENT_COMPLETE : EVENT_ERROR);
+    return 0;
+#endif
+}
+
+#if DEVICE_I2C_ASYNCH
+void MbedI2C::onTransferEvent(int event) {
+    const int errors = I2C_EVENT_ERROR | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK;
+    transferCallback((event & errors) ? EVENT_ERROR : EVENT_COMPLETE);
+}
+#endif
+
+}
+
+#endif
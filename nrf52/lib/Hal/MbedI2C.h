@@ -0,0 +1,40 @@
+#ifndef HAL_MBED_I2C_H
+#define HAL_MBED_I2C_H
+
+#ifndef HAL_NATIVE
+
+#include <mbed.h>
+
+#include "HalI2C.h"
+
+namespace hal {
+
+/**
+ * I2C master on an mbed::I2C peripheral. transfer() is interrupt driven on targets with
+ * DEVICE_I2C_ASYNCH and falls back to a blocking transfer elsewhere.
+ */
+class MbedI2C : public I2C {
+public:
+    MbedI2C(PinName sda, PinName scl);
+
+    int write(int address, const char *data, int length, bool repeated = false) override;
+
+    int read(int address, char *data, int length, bool repeated = false) override;
+
+    int transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const Callback<void(int)> &callback) override;
+
+private:
+#if DEVICE_I2C_ASYNCH
+    void onTransferEvent(int event);
+#endif
+
+    mbed::I2C i2c;
+    Callback<void(int)> transferCallback;
+};
+
+}
+
+#endif
+
+#endif // HAL_MBED_I2C_H
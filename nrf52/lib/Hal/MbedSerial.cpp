@@ -0,0 +1,59 @@
+#ifndef HAL_NATIVE
+
+#include "MbedSerial.h"
+
+namespace hal {
+
+MbedSerial::MbedSerial(PinName tx, PinName rx, int baud) : serial(tx, rx, baud) {}
+
+bool MbedSerial::writeable() {
+    return serial.writeable();
+}
+
+int MbedSerial::write(const uint8_t *buffer, int length, const Callback<void(int)> &callback) {
+    writeCallback = callback;
+    return serial.write(buffer, length, mbed::callback(this, &MbedSerial::onWriteEvent), SERIAL_EVENT_TX_ALL);
+}
+
+void MbedSerial::abortWrite() {
+    serial.abort_write();
+}
+
+void MbedSerial::setReceiveHandler(const Callback<void(uint8_t)> &handler) {
+    receiveHandler = handler;
+    attachReceive();
+}
+
+void MbedSerial::setEnabled(bool enabled) {
+    if (enabled == this->enabled) {
+        return;
+    }
+    this->enabled = enabled;
+#if MBED_VERSION >= MBED_ENCODE_VERSION(5, 13, 0)
+    serial.enable_input(enabled);
+    serial.enable_output(enabled);
+#endif
+    attachReceive();
+}
+
+void MbedSerial::attachReceive() {
+    if (enabled && receiveHandler) {
+        serial.attach(mbed::callback(this, &MbedSerial::onReceive), mbed::SerialBase::RxIrq);
+    } else {
+        serial.attach(nullptr, mbed::SerialBase::RxIrq);
+    }
+}
+
+void MbedSerial::onWriteEvent(int event) {
+    writeCallback(event & SERIAL_EVENT_TX_COMPLETE ? EVENT_TX_COMPLETE : 0);
+}
+
+void MbedSerial::onReceive() {
+    while (serial.readable()) {
+        receiveHandler(uint8_t(serial.getc()));
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HAL_MBED_SERIAL_H
+#define HAL_MBED_SERIAL_H
+
+#ifndef HAL_NATIVE
+
+#include <mbed.h>
+
+#include "HalSerial.h"
+
+namespace hal {
+
+/**
+ * UART on an mbed::RawSerial with asynchronous writes and interrupt driven reception. On nRF52
+ * the mbed driver receives through UARTE EasyDMA into its own buffers, the interrupt drains them.
+ * Disabling the UART frees the peripheral on mbed OS 5.13 and later, before that it only detaches
+ * the receive interrupt and its deep sleep lock.
+ */
+class MbedSerial : public Serial {
+public:
+    MbedSerial(PinName tx, PinName rx, int baud);
+
+    bool writeable() override;
+
+    int write(const uint8_t *buffer, int length, const Callback<void(int)> &callback) override;
+
+    void abortWrite() override;
+
+    void setReceiveHandler(const Callback<void(uint8_t)> &handler) override;
+
+    void setEnabled(bool enabled) override;
+
+private:
+    void onWriteEvent(int event);
+
+    void onReceive();
+
+    /** The receive interrupt is attached only while there is a handler and the UART is enabled */
+    void attachReceive();
+
+    mbed::RawSerial serial;
+    Callback<void(int)> writeCallback;
+    Callback<void(uint8_t)> receiveHandler;
+    bool enabled = true;
+};
+
+}
+
+#endif
+
+#endif // HAL_MBED_SERIAL_H
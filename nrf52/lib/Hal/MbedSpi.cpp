@@ -0,0 +1,48 @@
+#ifndef HAL_NATIVE
+
+#include <algorithm>
+
+#include "MbedSpi.h"
+
+namespace hal {
+
+MbedSpi::MbedSpi(PinName mosi, PinName miso, PinName sclk, PinName chipSelect, int frequencyHz)
+        : spi(mosi, miso, sclk), chipSelect(chipSelect, 1) {
+    spi.format(8, 0);
+    spi.frequency(frequencyHz);
+}
+
+int MbedSpi::write(const char *txBuffer, int txLength, char *rxBuffer, int rxLength) {
+    chipSelect = 0;
+    int length = spi.write(txBuffer, txLength, rxBuffer, rxLength);
+    chipSelect = 1;
+    return length == std::max(txLength, rxLength) ? 0 : -1;
+}
+
+int MbedSpi::transfer(const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                      const Callback<void(int)> &callback) {
+#if DEVICE_SPI_ASYNCH
+    transferCallback = callback;
+    chipSelect = 0;
+    if (spi.transfer(txBuffer, txLength, rxBuffer, rxLength, mbed::callback(this, &MbedSpi::onTransferEvent),
+                     SPI_EVENT_COMPLETE | SPI_EVENT_ERROR) != 0) {
+        chipSelect = 1;
+        return -1;
+    }
+    return 0;
+#else
+    callback(write(txBuffer, txLength, rxBuffer, rxLength) == 0 ? EVENT_COMPLETE : EVENT_ERROR);
+    return 0;
+#endif
+}
+
+#if DEVICE_SPI_ASYNCH
+void MbedSpi::onTransferEvent(int event) {
+    chipSelect = 1;
+    transferCallback((event & SPI_EVENT_ERROR) ? EVENT_ERROR : EVENT_COMPLETE);
+}
+#endif
+
+}
+
+#endif
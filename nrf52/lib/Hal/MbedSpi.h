@@ -0,0 +1,40 @@
+#ifndef HAL_MBED_SPI_H
+#define HAL_MBED_SPI_H
+
+#ifndef HAL_NATIVE
+
+#include <mbed.h>
+
+#include "HalSpi.h"
+
+namespace hal {
+
+/**
+ * SPI master on an mbed::SPI peripheral in mode 0, the chip select is a GPIO driven around every
+ * transaction. transfer() is interrupt driven on targets with DEVICE_SPI_ASYNCH and falls back to
+ * a blocking transaction elsewhere.
+ */
+class MbedSpi : public Spi {
+public:
+    MbedSpi(PinName mosi, PinName miso, PinName sclk, PinName chipSelect, int frequencyHz = 8000000);
+
+    int write(const char *txBuffer, int txLength, char *rxBuffer, int rxLength) override;
+
+    int transfer(const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const Callback<void(int)> &callback) override;
+
+private:
+#if DEVICE_SPI_ASYNCH
+    void onTransferEvent(int event);
+#endif
+
+    mbed::SPI spi;
+    mbed::DigitalOut chipSelect;
+    Callback<void(int)> transferCallback;
+};
+
+}
+
+#endif
+
+#endif // HAL_MBED_SPI_H
@@ -0,0 +1,238 @@
+#ifdef HAL_NATIVE
+
+#include "NativeEventQueue.h"
+#include "HalStaticEvent.h"
+#include "HalTime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace hal {
+
+static uint64_t clockUs = 0;
+static uint64_t awakeNs = 0;
+
+uint64_t uptimeMs() {
+    return clockUs / 1000;
+}
+
+CpuTime cpuTime() {
+    uint64_t awakeUs = std::min(awakeNs / 1000, clockUs);
+    return {awakeUs, 0, clockUs - awakeUs};
+}
+
+static std::chrono::steady_clock::time_point handlerStart;
+
+uint32_t cycleCount() {
+    auto inHandler = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - handlerStart).count();
+    return uint32_t(clockUs * 1000 + uint64_t(inHandler));
+}
+
+const size_t NativeEventQueue::STATIC_EVENTS;
+constexpr uint64_t NativeEventQueue::UNSTAMPED;
+
+NativeEventQueue::NativeEventQueue(size_t size) : capacity(size / EVENTS_EVENT_SIZE) {
+    events.reserve(capacity);
+}
+
+int NativeEventQueue::post(int delayMs, int periodMs, std::function<void()> &&function) {
+    if (events.size() + staticEventCount * StaticEvent::SLOTS >= capacity) {
+        ++statistics.dropped;
+        return 0;
+    }
+    if (++lastId <= 0) {
+        lastId = 1;
+    }
+    events.push_back(Event{lastId, clockUs + uint64_t(std::max(delayMs, 0)) * 1000, periodMs, ++lastSequence,
+                           std::move(function), stamp(delayMs)});
+    statistics.highWaterMark = std::max(statistics.highWaterMark, events.size() + pendingStaticEvents);
+    return lastId;
+}
+
+NativeEventQueue::WorkStamp NativeEventQueue::stamp(int delayMs) const {
+    if (delayMs > 0) {
+        return {};
+    }
+    uint64_t inHandler = dispatching ? uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - handlerStart).count()) : 0;
+    return {statistics.hostNanoseconds + inHandler,
+            backgroundNanoseconds + (dispatchingBackground ? inHandler : 0)};
+}
+
+void NativeEventQueue::recordWait(const WorkStamp &posted) {
+    const WorkStamp &due = posted.nanoseconds == UNSTAMPED ? tickStamp : posted;
+    statistics.maxWaitCycles = std::max(statistics.maxWaitCycles, statistics.hostNanoseconds - due.nanoseconds);
+    statistics.maxWaitBackgroundCycles = std::max(statistics.maxWaitBackgroundCycles,
+                                                  backgroundNanoseconds - due.backgroundNanoseconds);
+}
+
+bool NativeEventQueue::cancel(int id) {
+    auto it = std::find_if(events.begin(), events.end(), [id](const Event &event) {
+        return event.id == id;
+    });
+    if (it == events.end()) {
+        return false;
+    }
+    events.erase(it);
+    return true;
+}
+
+void NativeEventQueue::dispatch(int ms) {
+    broken = false;
+    const uint64_t deadlineUs = ms < 0 ? std::numeric_limits<uint64_t>::max() : clockUs + uint64_t(ms) * 1000;
+
+    while (!broken) {
+        uint64_t dueUs = std::numeric_limits<uint64_t>::max();
+        for (const Event &event : events) {
+            dueUs = std::min(dueUs, event.dueUs);
+        }
+        for (StaticEvent *event = staticEvents; event != nullptr; event = event->next) {
+            if (event->pending) {
+                dueUs = std::min(dueUs, event->dueUs);
+            }
+        }
+        if (dueUs > clockUs && idleHandler && !idle) {
+            idle = true;
+            idleHandler();
+            continue;
+        }
+        if (dueUs > deadlineUs || dueUs == std::numeric_limits<uint64_t>::max()) {
+            if (ms >= 0) {
+                clockUs = std::max(clockUs, deadlineUs);
+            }
+            return;
+        }
+        if (dueUs > clockUs) {
+            clockUs = dueUs;
+            tickStamp = {statistics.hostNanoseconds, backgroundNanoseconds};
+        }
+        idle = false;
+
+        // Of the events due now, high-priority ones in the order they became due, then background ones
+        auto next = events.end();
+        for (auto it = events.begin(); it != events.end(); ++it) {
+            if (it->dueUs <= clockUs && (next == events.end() || it->dueUs < next->dueUs
+                                         || (it->dueUs == next->dueUs && it->sequence < next->sequence))) {
+                next = it;
+            }
+        }
+        StaticEvent *nextStatic = nullptr;
+        for (StaticEvent *event = staticEvents; event != nullptr; event = event->next) {
+            if (event->pending && event->dueUs <= clockUs
+                && (nextStatic == nullptr || event->priority < nextStatic->priority
+                    || (event->priority == nextStatic->priority && (event->dueUs < nextStatic->dueUs
+                        || (event->dueUs == nextStatic->dueUs && event->sequence < nextStatic->sequence))))) {
+                nextStatic = event;
+            }
+        }
+        if (nextStatic != nullptr && next != events.end()
+            && (nextStatic->priority == StaticEvent::BACKGROUND || next->dueUs < nextStatic->dueUs
+                || (next->dueUs == nextStatic->dueUs && next->sequence < nextStatic->sequence))) {
+            nextStatic = nullptr;
+        }
+
+        std::function<void()> function;
+        bool background = false;
+        if (nextStatic != nullptr) {
+            // The event may be posted again by its own handler
+            nextStatic->pending = false;
+            --pendingStaticEvents;
+            background = nextStatic->priority == StaticEvent::BACKGROUND;
+            if (!background) {
+                recordWait(nextStatic->posted);
+            }
+            function = [nextStatic]() {
+                nextStatic->callback();
+            };
+        } else if (next->periodMs >= 0) {
+            recordWait(WorkStamp{});
+            function = next->function;
+            next->dueUs = clockUs + uint64_t(next->periodMs) * 1000;
+            next->sequence = ++lastSequence;
+        } else {
+            recordWait(next->posted);
+            function = std::move(next->function);
+            events.erase(next);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        handlerStart = start;
+        dispatching = true;
+        dispatchingBackground = background;
+        function();
+        dispatching = false;
+        dispatchingBackground = false;
+        auto elapsed = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+
+        ++statistics.dispatched;
+        statistics.hostNanoseconds += elapsed;
+        awakeNs += elapsed;
+        statistics.maxHostNanoseconds = std::max(statistics.maxHostNanoseconds, elapsed);
+        if (background) {
+            ++statistics.backgroundDispatched;
+            backgroundNanoseconds += elapsed;
+            statistics.maxBackgroundCycles = std::max(statistics.maxBackgroundCycles, elapsed);
+        }
+    }
+}
+
+void NativeEventQueue::break_dispatch() {
+    broken = true;
+}
+
+unsigned NativeEventQueue::tick() const {
+    return unsigned(clockUs / 1000);
+}
+
+constexpr size_t StaticEvent::SLOTS;
+constexpr size_t StaticEvent::SLOT_SIZE;
+
+StaticEvent::StaticEvent(EventQueue &eventQueue, const Callback<void()> &callback, Priority priority)
+        : eventQueue(eventQueue), callback(callback), priority(priority), next(eventQueue.staticEvents) {
+    eventQueue.staticEvents = this;
+    ++eventQueue.staticEventCount;
+}
+
+StaticEvent::~StaticEvent() {
+    cancel();
+    for (StaticEvent **link = &eventQueue.staticEvents; *link != nullptr; link = &(*link)->next) {
+        if (*link == this) {
+            *link = next;
+            --eventQueue.staticEventCount;
+            break;
+        }
+    }
+}
+
+void StaticEvent::postIn(int ms) {
+    if (pending) {
+        return;
+    }
+    pending = true;
+    dueUs = clockUs + uint64_t(std::max(ms, 0)) * 1000;
+    sequence = ++eventQueue.lastSequence;
+    posted = eventQueue.stamp(ms);
+    ++eventQueue.pendingStaticEvents;
+    eventQueue.statistics.highWaterMark = std::max(eventQueue.statistics.highWaterMark,
+                                                   eventQueue.events.size() + eventQueue.pendingStaticEvents);
+}
+
+bool StaticEvent::cancel() {
+    if (!pending) {
+        return false;
+    }
+    pending = false;
+    --eventQueue.pendingStaticEvents;
+    return true;
+}
+
+bool StaticEvent::isPending() const {
+    return pending;
+}
+
+}
+
+#endif
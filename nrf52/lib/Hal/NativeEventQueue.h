@@ -0,0 +1,167 @@
+#ifndef HAL_NATIVE_EVENT_QUEUE_H
+#define HAL_NATIVE_EVENT_QUEUE_H
+
+#ifdef HAL_NATIVE
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#ifndef EVENTS_EVENT_SIZE
+/** Size accounted per queued event, mirrors the mbed macro so queue sizes are written the same way */
+#define EVENTS_EVENT_SIZE 64
+#endif
+
+namespace hal {
+
+class StaticEvent;
+
+/**
+ * Host implementation of the events::EventQueue subset used by the firmware.
+ *
+ * Time is virtual: dispatching jumps straight to the next due event, so hours of firmware
+ * operation run in a fraction of a second. Like the mbed queue it has a fixed capacity,
+ * and posting to a full queue fails and returns 0. Every StaticEvent on the queue takes
+ * StaticEvent::SLOTS of the capacity. Host CPU time spent in every handler is
+ * recorded in stats().
+ *
+ * Calls are high-priority, static events dispatch by their priority. Handlers take no virtual time, so
+ * waits are counted in host time: the handlers that ran between the moment an event was due, posted or
+ * its time came, and its dispatch.
+ */
+class NativeEventQueue {
+public:
+    /** Reserved for the background dispatch of MbedEventQueue, so queue sizes are written the same way */
+    static const size_t STATIC_EVENTS = 1;
+
+    /** Times are in hal::cycleCount() units, nanoseconds on the host */
+    struct Stats {
+        uint64_t dispatched = 0;
+        uint64_t dropped = 0;
+        /** Posts of static events among the dropped ones, none here: they are kept outside the queue */
+        uint64_t staticDropped = 0;
+        uint64_t hostNanoseconds = 0;
+        uint64_t maxHostNanoseconds = 0;
+        size_t highWaterMark = 0;
+        uint64_t backgroundDispatched = 0;
+        /** Longest time a high-priority event waited for other handlers once it was due */
+        uint64_t maxWaitCycles = 0;
+        /** Longest part of such a wait spent in a background handler, at most maxBackgroundCycles */
+        uint64_t maxWaitBackgroundCycles = 0;
+        uint64_t maxBackgroundCycles = 0;
+    };
+
+    /** Host time spent in handlers and in background ones when an event was due */
+    struct WorkStamp {
+        uint64_t nanoseconds = UNSTAMPED;
+        uint64_t backgroundNanoseconds = 0;
+    };
+
+    explicit NativeEventQueue(size_t size = 32 * EVENTS_EVENT_SIZE);
+
+    template<typename F, typename... Args>
+    int call(F f, Args... args) {
+        return post(0, -1, bind(f, args...));
+    }
+
+    template<typename F, typename... Args>
+    int call_in(int ms, F f, Args... args) {
+        return post(ms, -1, bind(f, args...));
+    }
+
+    template<typename F, typename... Args>
+    int call_every(int ms, F f, Args... args) {
+        return post(ms, ms, bind(f, args...));
+    }
+
+    bool cancel(int id);
+
+    /**
+     * Dispatch events for ms milliseconds of virtual time, or until break_dispatch() if ms is negative.
+     * Returns early if the queue runs out of events.
+     */
+    void dispatch(int ms = -1);
+
+    void dispatch_forever() {
+        dispatch(-1);
+    }
+
+    void break_dispatch();
+
+    /**
+     * Host only: called whenever dispatching is about to wait for the next event, where the device
+     * would switch to its idle or low-priority threads.
+     */
+    void setIdleHandler(std::function<void()> handler) {
+        idleHandler = std::move(handler);
+    }
+
+    /** Virtual time in milliseconds */
+    unsigned tick() const;
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    friend class StaticEvent;
+
+    static constexpr uint64_t UNSTAMPED = UINT64_MAX;
+
+    struct Event {
+        int id;
+        uint64_t dueUs;
+        int periodMs;
+        uint64_t sequence;
+        std::function<void()> function;
+        WorkStamp posted;
+    };
+
+    template<typename F, typename... Args>
+    static std::function<void()> bind(F f, Args... args) {
+        return [f, args...]() mutable {
+            std::invoke(f, args...);
+        };
+    }
+
+    template<typename T, typename M, typename... Args,
+            typename = typename std::enable_if<std::is_member_function_pointer<M>::value>::type>
+    static std::function<void()> bind(T *object, M method, Args... args) {
+        return [object, method, args...]() mutable {
+            std::invoke(method, object, args...);
+        };
+    }
+
+    int post(int delayMs, int periodMs, std::function<void()> &&function);
+
+    /** Stamp of an event posted now, unstamped if it is not due at once: it is due when its time comes */
+    WorkStamp stamp(int delayMs) const;
+
+    /** Records the wait of an event dispatched now */
+    void recordWait(const WorkStamp &posted);
+
+    const size_t capacity;
+    std::vector<Event> events;
+    StaticEvent *staticEvents = nullptr;
+    size_t staticEventCount = 0;
+    size_t pendingStaticEvents = 0;
+    int lastId = 0;
+    uint64_t lastSequence = 0;
+    bool broken = false;
+    std::function<void()> idleHandler;
+    bool idle = false;
+    bool dispatching = false;
+    bool dispatchingBackground = false;
+    uint64_t backgroundNanoseconds = 0;
+    /** When the virtual clock reached its current time */
+    WorkStamp tickStamp{0, 0};
+    Stats statistics;
+};
+
+}
+
+#endif
+
+#endif // HAL_NATIVE_EVENT_QUEUE_H
@@ -0,0 +1,129 @@
+#include <cstring>
+
+#include "History.h"
+
+const int16_t History::TEMPERATURE_UNKNOWN;
+const uint16_t History::HUMIDITY_UNKNOWN;
+const uint16_t History::PRESSURE_UNKNOWN;
+const uint16_t History::CO2_UNKNOWN;
+const size_t History::BLOCKS;
+const size_t History::BLOCK_LENGTH;
+const size_t History::MIN_CAPACITY;
+
+void History::append(uint32_t time, const Record &record) {
+    const timeseries::Sample sample{time, {uint16_t(record.temperature), record.humidity, record.pressure,
+                                           record.co2}};
+    if (usedBlocks == 0 || !encoder.append(sample)) {
+        // The oldest block makes room, the sample starts it over and always fits an empty one
+        activeBlock = usedBlocks == 0 ? 0 : (activeBlock + 1) % BLOCKS;
+        if (usedBlocks < BLOCKS) {
+            ++usedBlocks;
+        }
+        encoder = timeseries::Encoder{blocks[activeBlock], BLOCK_LENGTH};
+        encoder.begin(nextSeq, time);
+        encoder.append(sample);
+    }
+    lengths[activeBlock] = uint16_t(encoder.length());
+    ++nextSeq;
+}
+
+History::Cursor History::seek(uint32_t sequence) const {
+    Cursor cursor{nextSeq, 0, 0, false, {}};
+    if (usedBlocks == 0) {
+        return cursor;
+    }
+    open(cursor, logBlock(findBlock([this, sequence](size_t block) {
+        return blockSequence(block) <= sequence;
+    })));
+    timeseries::Sample sample;
+    while (cursor.sequence < sequence && step(cursor, sample)) {
+    }
+    return cursor;
+}
+
+History::Cursor History::seekTime(uint32_t time) const {
+    Cursor cursor{nextSeq, 0, 0, false, {}};
+    if (usedBlocks == 0) {
+        return cursor;
+    }
+    // Times may repeat, a block that starts at the time may follow samples at it
+    open(cursor, logBlock(findBlock([this, time](size_t block) {
+        return blockTime(block) < time;
+    })));
+    timeseries::Sample sample;
+    Cursor following = cursor;
+    while (step(following, sample) && sample.time < time) {
+        cursor = following;
+    }
+    return cursor;
+}
+
+bool History::read(Cursor &cursor, Record &record) const {
+    if (!cursor.positioned || cursor.sequence < firstSequence()
+        || cursor.decoder.header().sequence != blockSequence(cursor.block)) {
+        // The block was dropped and maybe started over
+        cursor = seek(cursor.sequence < firstSequence() ? firstSequence() : cursor.sequence);
+        if (!cursor.positioned) {
+            return false;
+        }
+    }
+    timeseries::Sample sample;
+    if (!step(cursor, sample)) {
+        return false;
+    }
+    record = {0, int16_t(sample.values[0]), sample.values[1], sample.values[2], sample.values[3]};
+    return true;
+}
+
+uint32_t History::blockSequence(size_t block) const {
+    uint32_t sequence;
+    memcpy(&sequence, &blocks[block][0], sizeof(sequence));
+    return sequence;
+}
+
+uint32_t History::blockTime(size_t block) const {
+    uint32_t time;
+    memcpy(&time, &blocks[block][4], sizeof(time));
+    return time;
+}
+
+template<typename Before>
+size_t History::findBlock(Before before) const {
+    size_t low = 0;
+    size_t high = usedBlocks;
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (before(logBlock(middle))) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void History::open(Cursor &cursor, size_t block) const {
+    cursor.block = uint32_t(block);
+    cursor.positioned = true;
+    cursor.decoder.open(blocks[block], lengths[block]);
+    cursor.sequence = cursor.decoder.header().sequence;
+    cursor.time = cursor.decoder.header().time;
+}
+
+bool History::step(Cursor &cursor, timeseries::Sample &sample) const {
+    // The active block grows after the cursor opened it
+    cursor.decoder.extend(lengths[cursor.block]);
+    if (!cursor.decoder.next(sample)) {
+        if (cursor.sequence == nextSeq) {
+            return false;
+        }
+        // Samples of a block are consecutive, the next one starts the following block
+        open(cursor, (cursor.block + 1) % BLOCKS);
+        if (!cursor.decoder.next(sample)) {
+            return false;
+        }
+    }
+    ++cursor.sequence;
+    cursor.time = sample.time;
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <TimeSeries.h>
+
+/** RAM for the samples, in blocks of HISTORY_BLOCK_LENGTH bytes */
+#ifndef HISTORY_BLOCKS
+#define HISTORY_BLOCKS 40
+#endif
+
+#ifndef HISTORY_BLOCK_LENGTH
+#define HISTORY_BLOCK_LENGTH 256
+#endif
+
+/**
+ * Measurement history in statically allocated RAM, the oldest samples are dropped when it is full.
+ * Samples are numbered from 0 since boot, so a client can resume a download from the sequence number
+ * it saw last.
+ *
+ * Samples are stored compressed, in a ring of lib/TimeSeries blocks: a block is appended to until
+ * the next sample does not fit, then the oldest block is dropped and starts over with that sample.
+ * A sample of slowly changing readings takes a few bytes instead of the 10 of a Record, and even
+ * a sample that changes every value as much as possible takes at most timeseries::MAX_SAMPLE_LENGTH,
+ * so the history holds at least MIN_CAPACITY samples.
+ */
+class History {
+public:
+    /** Transmitted as is, little-endian */
+    struct Record {
+        uint16_t timeDelta; /* seconds since the previous sample */
+        int16_t temperature; /* 0.01 C */
+        uint16_t humidity; /* 0.01 % */
+        uint16_t pressure; /* 2 Pa */
+        uint16_t co2; /* ppm */
+    };
+
+    static const int16_t TEMPERATURE_UNKNOWN = INT16_MIN;
+    static const uint16_t HUMIDITY_UNKNOWN = UINT16_MAX;
+    static const uint16_t PRESSURE_UNKNOWN = UINT16_MAX;
+    static const uint16_t CO2_UNKNOWN = 0;
+
+    static const size_t BLOCKS = HISTORY_BLOCKS;
+    static const size_t BLOCK_LENGTH = HISTORY_BLOCK_LENGTH;
+    /** Samples kept even if each one encodes to the longest sample there is, the active block may be nearly empty */
+    static const size_t MIN_CAPACITY =
+            (BLOCKS - 1) * ((BLOCK_LENGTH - timeseries::HEADER_LENGTH) / timeseries::MAX_SAMPLE_LENGTH);
+
+    /**
+     * Read position. Stays valid when the samples it points to are dropped,
+     * reading continues from the oldest sample then.
+     */
+    struct Cursor {
+        uint32_t sequence;
+        uint32_t time; /* of the sample read last, the base time of the block before the first one */
+        /** Block the decoder reads, positioned is false until seek() finds it */
+        uint32_t block;
+        bool positioned;
+        timeseries::Decoder decoder;
+    };
+
+    /**
+     * Continue numbering from a persistent log, only before the first append.
+     */
+    void setNextSequence(uint32_t sequence) {
+        if (usedBlocks == 0) {
+            nextSeq = sequence;
+        }
+    }
+
+    /**
+     * @param time seconds, not less than the time of the previous sample
+     * @param record values of the sample, timeDelta is ignored
+     */
+    void append(uint32_t time, const Record &record);
+
+    /** Sequence number of the oldest stored sample */
+    uint32_t firstSequence() const {
+        return usedBlocks == 0 ? nextSeq : blockSequence(logBlock(0));
+    }
+
+    /** Sequence number the next appended sample gets */
+    uint32_t nextSequence() const {
+        return nextSeq;
+    }
+
+    /**
+     * Cursor at the given sample, or at the oldest one if it was dropped.
+     * Finds the block by binary search and decodes it up to the sample.
+     */
+    Cursor seek(uint32_t sequence) const;
+
+    /** Cursor at the first sample taken at or after the given time, same cost as seek() */
+    Cursor seekTime(uint32_t time) const;
+
+    /**
+     * Read the sample at the cursor and advance it, the cursor has the time of the sample then.
+     * @param record values of the sample, timeDelta is 0
+     * @return false if there are no samples at or after the cursor
+     */
+    bool read(Cursor &cursor, Record &record) const;
+
+private:
+    uint32_t blockSequence(size_t block) const;
+
+    uint32_t blockTime(size_t block) const;
+
+    /** Physical block of the index-th block of the history, counting from the oldest */
+    size_t logBlock(size_t index) const {
+        return (usedBlocks < BLOCKS ? index : activeBlock + 1 + index) % BLOCKS;
+    }
+
+    /** Index of the last block whose first sample passes the test, the oldest block if none does */
+    template<typename Before>
+    size_t findBlock(Before before) const;
+
+    void open(Cursor &cursor, size_t block) const;
+
+    /** Decodes the sample at a positioned cursor, moving on to the next block at the end of one */
+    bool step(Cursor &cursor, timeseries::Sample &sample) const;
+
+    uint8_t blocks[BLOCKS][BLOCK_LENGTH];
+    uint16_t lengths[BLOCKS]{};
+    timeseries::Encoder encoder{blocks[0], BLOCK_LENGTH};
+    size_t activeBlock = 0;
+    size_t usedBlocks = 0;
+    uint32_t nextSeq = 0;
+};
+
+static_assert(sizeof(History::Record) == 10, "History::Record must be packed");
+static_assert(History::BLOCKS >= 2, "History needs a block to drop and one to keep");
+static_assert(History::BLOCK_LENGTH >= timeseries::HEADER_LENGTH + timeseries::MAX_SAMPLE_LENGTH
+              && History::BLOCK_LENGTH <= UINT16_MAX, "Every sample must fit an empty history block");
+
+#endif // HISTORY_H
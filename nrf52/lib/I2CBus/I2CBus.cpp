@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "I2CBus.h"
+
+const size_t I2CBus::MAX_PENDING;
+const size_t I2CBus::STATIC_EVENTS;
+
+I2CBus::I2CBus(hal::I2C &bus, hal::EventQueue &eventQueue)
+        : bus(bus), nextEvent(eventQueue, {this, &I2CBus::startNext}) {}
+
+int I2CBus::write(int address, const char *data, int length, bool repeated) {
+    if (isBusy()) {
+        ++statistics.rejected;
+        return -1;
+    }
+    return bus.write(address, data, length, repeated);
+}
+
+int I2CBus::read(int address, char *data, int length, bool repeated) {
+    if (isBusy()) {
+        ++statistics.rejected;
+        return -1;
+    }
+    return bus.read(address, data, length, repeated);
+}
+
+int I2CBus::transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                     const hal::Callback<void(int)> &callback) {
+    if (!pending.push({address, txBuffer, txLength, rxBuffer, rxLength, callback})) {
+        ++statistics.rejected;
+        return -1;
+    }
+    ++statistics.transfers;
+    statistics.maxPending = std::max(statistics.maxPending, uint32_t(pending.size()));
+    if (active.load()) {
+        ++statistics.queued;
+        return 0;
+    }
+    startNext();
+    return 0;
+}
+
+void I2CBus::startNext() {
+    Request request;
+    while (!active.load() && pending.pop(request)) {
+        callback = request.callback;
+        active.store(true);
+        if (bus.transfer(request.address, request.txBuffer, request.txLength, request.rxBuffer, request.rxLength,
+                         {this, &I2CBus::onComplete}) != 0) {
+            // The driver learns it the same way as of a failed transfer, the next request gets the bus
+            active.store(false);
+            ++statistics.errors;
+            request.callback(hal::I2C::EVENT_ERROR);
+        }
+    }
+}
+
+void I2CBus::onComplete(int event) {
+    // Interrupt context. The callback runs first: the next transfer replaces it once the bus is free.
+    if (!(event & hal::I2C::EVENT_COMPLETE)) {
+        ++statistics.errors;
+    }
+    callback(event);
+    active.store(false);
+    // A transfer that comes after this check finds the bus free and starts on its own
+    if (!pending.empty()) {
+        nextEvent.post();
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+#include <RingBuffer.h>
+
+/** Transfers waiting for the bus, a power of two */
+#ifndef I2C_BUS_MAX_PENDING
+#define I2C_BUS_MAX_PENDING 4
+#endif
+
+/**
+ * @class I2CBus
+ * @brief Shares one I2C peripheral between several drivers, e.g. BME280s at both addresses.
+ *
+ * The peripheral runs one transfer at a time and refuses another one while it is busy. The bus takes
+ * every transfer() and starts it when the previous one is over, in the order they came, so drivers
+ * never see the peripheral busy and never wait for each other. The completion interrupt of a transfer
+ * only posts the static event that starts the next one: the peripheral is not started from interrupt context.
+ *
+ * Blocking read() and write() pass straight through while no transfer is running or queued, they are meant
+ * for initialization. They fail while the bus is taken rather than interleave with a transfer.
+ *
+ * transfer(), read() and write() are for the thread that dispatches the queue. The class is final, so drivers
+ * templated on it (BME280) call it directly.
+ */
+class I2CBus final : public hal::I2C {
+public:
+    static const size_t MAX_PENDING = I2C_BUS_MAX_PENDING;
+    /** Events the bus keeps on the queue, see hal::StaticEvent */
+    static const size_t STATIC_EVENTS = 1;
+
+    struct Stats {
+        uint32_t transfers = 0;
+        /** Transfers that had to wait for another one */
+        uint32_t queued = 0;
+        /** Transfers and blocking calls refused because the queue was full or the bus taken */
+        uint32_t rejected = 0;
+        uint32_t errors = 0;
+        uint32_t maxPending = 0;
+    };
+
+    I2CBus(hal::I2C &bus, hal::EventQueue &eventQueue);
+
+    int write(int address, const char *data, int length, bool repeated = false) override;
+
+    int read(int address, char *data, int length, bool repeated = false) override;
+
+    /** @return 0 if the transfer was started or queued, -1 if MAX_PENDING transfers are waiting already */
+    int transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const hal::Callback<void(int)> &callback) override;
+
+    /** Whether a transfer is running or waiting */
+    bool isBusy() const {
+        return active.load() || !pending.empty();
+    }
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    struct Request {
+        int address;
+        const char *txBuffer;
+        int txLength;
+        char *rxBuffer;
+        int rxLength;
+        hal::Callback<void(int)> callback;
+    };
+
+    /** Starts the oldest waiting transfer if the bus is free */
+    void startNext();
+
+    /** Interrupt context */
+    void onComplete(int event);
+
+    hal::I2C &bus;
+    RingBuffer<Request, MAX_PENDING> pending;
+    /** Set from start to completion of a transfer, cleared in interrupt context */
+    std::atomic<bool> active{false};
+    /** Of the running transfer */
+    hal::Callback<void(int)> callback;
+    hal::StaticEvent nextEvent;
+    Stats statistics;
+};
+
+#endif // I2C_BUS_H
@@ -0,0 +1,109 @@
+#include <atomic>
+
+#include "Log.h"
+
+static_assert((Log::CAPACITY & (Log::CAPACITY - 1)) == 0, "LOG_CAPACITY must be a power of two");
+
+const size_t Log::MAX_ARGS;
+const size_t Log::CAPACITY;
+const uint8_t Log::FRAME_START;
+const size_t Log::MAX_FRAME_LENGTH;
+
+namespace {
+
+/**
+ * Bounded queue of many writers and one reader. A slot's sequence number tells whether it is free
+ * for the writer at a position or holds an entry for the reader: writers claim a position with
+ * compare-and-swap, fill the slot and publish it by advancing its sequence. Sequences count from
+ * the first position of the round, so the zero-initialized slots are free for the first one.
+ */
+struct Slot {
+    std::atomic<uint32_t> sequence;
+    Log::Entry entry;
+};
+
+Slot slots[Log::CAPACITY];
+std::atomic<uint32_t> writePosition{0};
+uint32_t readPosition = 0;
+std::atomic<uint32_t> droppedCount{0};
+uint32_t reportedDropped = 0;
+hal::Callback<void()> notifyReader;
+
+inline uint32_t roundOf(uint32_t position) {
+    return position - position % Log::CAPACITY;
+}
+
+}
+
+void Log::push(const Entry &entry) {
+    uint32_t position = writePosition.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+        slot = &slots[position % CAPACITY];
+        int32_t difference = int32_t(slot->sequence.load(std::memory_order_acquire) - roundOf(position));
+        if (difference == 0) {
+            if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->entry = entry;
+    slot->sequence.store(roundOf(position) + 1, std::memory_order_release);
+    if (notifyReader) {
+        notifyReader();
+    }
+}
+
+bool Log::pop(Entry &entry) {
+    uint32_t dropped = droppedCount.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped) {
+        entry = {uint32_t(hal::uptimeMs()), uint16_t(LogMessage::LOG_DROPPED), 1, 0,
+                 {int32_t(dropped - reportedDropped)}};
+        reportedDropped = dropped;
+        return true;
+    }
+    Slot &slot = slots[readPosition % CAPACITY];
+    if (slot.sequence.load(std::memory_order_acquire) != roundOf(readPosition) + 1) {
+        return false;
+    }
+    entry = slot.entry;
+    slot.sequence.store(roundOf(readPosition) + CAPACITY, std::memory_order_release);
+    ++readPosition;
+    return true;
+}
+
+size_t Log::encode(const Entry &entry, uint8_t *frame) {
+    size_t length = 0;
+    frame[length++] = FRAME_START;
+    frame[length++] = uint8_t(entry.id);
+    frame[length++] = uint8_t(entry.id >> 8);
+    for (int shift = 0; shift < 32; shift += 8) {
+        frame[length++] = uint8_t(entry.timeMs >> shift);
+    }
+    uint8_t argCount = entry.argCount < MAX_ARGS ? entry.argCount : uint8_t(MAX_ARGS);
+    frame[length++] = argCount;
+    for (uint8_t i = 0; i < argCount; ++i) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            frame[length++] = uint8_t(uint32_t(entry.args[i]) >> shift);
+        }
+    }
+    uint8_t check = 0;
+    for (size_t i = 1; i < length; ++i) {
+        check ^= frame[i];
+    }
+    frame[length++] = check;
+    return length;
+}
+
+void Log::setNotify(const hal::Callback<void()> &notify) {
+    notifyReader = notify;
+}
+
+uint32_t Log::dropped() {
+    return droppedCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,85 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+
+#include "LogMessages.h"
+
+/** Entries buffered until the console drains them, 24 bytes each */
+#ifndef LOG_CAPACITY
+#define LOG_CAPACITY 64
+#endif
+
+enum class LogMessage : uint16_t {
+#define LOG_MESSAGE_ID(name, format) name,
+    LOG_MESSAGES(LOG_MESSAGE_ID)
+#undef LOG_MESSAGE_ID
+    COUNT
+};
+
+/**
+ * Logs a message from LogMessages.h with up to Log::MAX_ARGS integer arguments, e.g.
+ * LOG(FLASH_LOG_APPEND_FAILED, error). Safe in any context, interrupt handlers included.
+ */
+#define LOG(message, ...) Log::write(LogMessage::message, ##__VA_ARGS__)
+
+/**
+ * @class Log
+ * @brief Binary log: a message id and its arguments, formatted only by the reader.
+ *
+ * Writers never block. Entries go into a lock-free ring of LOG_CAPACITY slots that any number of
+ * threads and interrupt handlers may fill; if it is full the entry is dropped and counted, the reader
+ * gets a LOG_DROPPED entry in its place. A single reader takes entries out when the system is idle,
+ * see LogConsole.
+ *
+ * On the wire an entry is a frame: FRAME_START, uint16 id, uint32 time in ms, uint8 argument count,
+ * int32 arguments, all little-endian, and the XOR of the bytes after FRAME_START.
+ */
+class Log {
+public:
+    static const size_t MAX_ARGS = 4;
+    static const size_t CAPACITY = LOG_CAPACITY;
+    static const uint8_t FRAME_START = 0xA5;
+    static const size_t MAX_FRAME_LENGTH = 1 + 2 + 4 + 1 + 4 * MAX_ARGS + 1;
+
+    struct Entry {
+        uint32_t timeMs;
+        uint16_t id;
+        uint8_t argCount;
+        uint8_t reserved;
+        int32_t args[MAX_ARGS];
+    };
+
+    template<typename... Args>
+    static void write(LogMessage message, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+        Entry entry{uint32_t(hal::uptimeMs()), uint16_t(message), uint8_t(sizeof...(Args)), 0, {int32_t(args)...}};
+        push(entry);
+    }
+
+    /**
+     * Reader side.
+     * @return false if there is nothing to read
+     */
+    static bool pop(Entry &entry);
+
+    /** @return frame length, at most MAX_FRAME_LENGTH */
+    static size_t encode(const Entry &entry, uint8_t *frame);
+
+    /**
+     * Called after every entry from the writer's context, e.g. to wake the reader.
+     * Set it before anything is logged.
+     */
+    static void setNotify(const hal::Callback<void()> &notify);
+
+    /** Entries lost because the ring was full */
+    static uint32_t dropped();
+
+private:
+    static void push(const Entry &entry);
+};
+
+#endif // LOG_H
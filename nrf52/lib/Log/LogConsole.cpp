@@ -0,0 +1,34 @@
+#ifndef HAL_NATIVE
+
+#include "LogConsole.h"
+
+const uint32_t LogConsole::FLAG_ENTRY;
+
+LogConsole::LogConsole(PinName tx, PinName rx, int baud)
+        : serial(tx, rx, baud),
+          thread(osPriorityLow, LOG_CONSOLE_STACK_SIZE, nullptr, "log") {}
+
+void LogConsole::start() {
+    Log::setNotify({this, &LogConsole::notify});
+    thread.start({this, &LogConsole::run});
+}
+
+void LogConsole::notify() {
+    flags.set(FLAG_ENTRY);
+}
+
+void LogConsole::run() {
+    uint8_t frame[Log::MAX_FRAME_LENGTH];
+    Log::Entry entry{};
+    for (;;) {
+        flags.wait_any(FLAG_ENTRY);
+        while (Log::pop(entry)) {
+            size_t length = Log::encode(entry, frame);
+            for (size_t i = 0; i < length; ++i) {
+                serial.putc(frame[i]);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef LOG_CONSOLE_H
+#define LOG_CONSOLE_H
+
+#ifndef HAL_NATIVE
+
+#include <mbed.h>
+
+#include "Log.h"
+
+/** Stack of the thread that drains the log, it only encodes frames */
+#ifndef LOG_CONSOLE_STACK_SIZE
+#define LOG_CONSOLE_STACK_SIZE 512
+#endif
+
+/**
+ * @class LogConsole
+ * @brief Sends the log to a UART as binary frames, decode them with tools/logdecode.py.
+ *
+ * A thread below the priority of the event queue drains the log, so the UART is written only when
+ * handlers have nothing else to do. On nRF52832 the console shares the only UARTE with MH-Z19B,
+ * the mbed driver switches the pins between them.
+ */
+class LogConsole {
+public:
+    LogConsole(PinName tx, PinName rx, int baud);
+
+    void start();
+
+private:
+    static const uint32_t FLAG_ENTRY = 1;
+
+    void notify();
+
+    void run();
+
+    mbed::RawSerial serial;
+    rtos::EventFlags flags;
+    rtos::Thread thread;
+};
+
+#endif
+
+#endif // LOG_CONSOLE_H
@@ -0,0 +1,61 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+/**
+ * Every message the firmware logs, LOG_MESSAGE(name, format). The id of a message is its position
+ * in the list and only the id goes into the log, the formats are used by the decoders:
+ * tools/logdecode.py on the host and the text console of the simulation. Formats are printf-like
+ * with %d, %u, %x, %% and %F, a value in hundredths printed with two decimals.
+ * Add new messages at the end so that logs of older builds still decode.
+ */
+#define LOG_MESSAGES(LOG_MESSAGE) \
+    LOG_MESSAGE(LOG_DROPPED, "%u log entries dropped") \
+    LOG_MESSAGE(BLE_INIT_FAILED, "BLE init failed, error %d") \
+    LOG_MESSAGE(BLE_BEACON_START_FAILED, "BLE beacon start failed, error %d") \
+    LOG_MESSAGE(BLE_INITIALIZED, "BLE initialized successfully") \
+    LOG_MESSAGE(BLE_CONNECTED, "Someone connected") \
+    LOG_MESSAGE(BLE_DISCONNECTED, "Someone disconnected") \
+    LOG_MESSAGE(REPORT_HEADER, "============ %u") \
+    LOG_MESSAGE(REPORT_TEMPERATURE, "Temperature: %F C") \
+    LOG_MESSAGE(REPORT_PRESSURE, "Pressure:    %F hPa") \
+    LOG_MESSAGE(REPORT_HUMIDITY, "Humidity:    %F%%") \
+    LOG_MESSAGE(REPORT_CO2, "CO2:         %u PPM") \
+    LOG_MESSAGE(REPORT_CONNECTED, "Gap is connected") \
+    LOG_MESSAGE(REPORT_NOT_CONNECTED, "Gap is not connected") \
+    LOG_MESSAGE(REPORT_ENERGY, "Energy:      %u uA nRF52, %u uA total, awake %u of %u ms") \
+    LOG_MESSAGE(BME280_BUSY, "BME280 measurement is already in progress") \
+    LOG_MESSAGE(BME280_READ_FAILED, "BME280 read failed") \
+    LOG_MESSAGE(MHZ19B_NOT_WRITEABLE, "MH-Z19B serial is not writeable") \
+    LOG_MESSAGE(MHZ19B_NO_RESPONSE, "MH-Z19B did not respond") \
+    LOG_MESSAGE(FLASH_LOG_MOUNT_FAILED, "Flash log mount failed, error %d, history is not kept over resets") \
+    LOG_MESSAGE(FLASH_LOG_MOUNTED, "Flash log: samples %u..%u, max erase count %u") \
+    LOG_MESSAGE(FLASH_LOG_APPEND_FAILED, "Flash log append failed, error %d") \
+    LOG_MESSAGE(TRIGGER_SETTING_UNSUPPORTED, "Unsupported ES trigger setting of %u bytes") \
+    LOG_MESSAGE(BEACON_UPDATE_FAILED, "Beacon payload update failed, error %d") \
+    LOG_MESSAGE(BEACON_RESTART_FAILED, "Beacon advertising restart failed, error %d") \
+    LOG_MESSAGE(CONFIG_BAD_PERIODS, "Configuration: bad measurement periods of %u bytes") \
+    LOG_MESSAGE(HISTORY_NOT_SUBSCRIBED, "History: client is not subscribed to data") \
+    LOG_MESSAGE(HISTORY_BAD_CONTROL, "History: bad control write of %u bytes") \
+    LOG_MESSAGE(HISTORY_NOTIFY_FAILED, "History: notification failed, error %d") \
+    LOG_MESSAGE(REPORT_QUEUE, "Queue:       high-water %u events, %u dropped") \
+    LOG_MESSAGE(REPORT_PROBE, "Probe %u:     %u times, mean %u us, max %u us") \
+    LOG_MESSAGE(REPORT_STATIC_DROPPED, "Queue:       %u static event posts dropped, the queue is too small") \
+    LOG_MESSAGE(HISTORY_BUSY, "History: transfer to connection %u in progress") \
+    LOG_MESSAGE(BLE_TOO_MANY_CONNECTIONS, "Connection %u is not tracked, it gets no notifications") \
+    LOG_MESSAGE(BLE_CONNECTED_MULTI, "Someone connected, connection %u, %u connected") \
+    LOG_MESSAGE(BLE_DISCONNECTED_MULTI, "Someone disconnected, connection %u, %u connected") \
+    LOG_MESSAGE(REPORT_CONNECTED_MULTI, "Gap is connected, %u of %u connections") \
+    LOG_MESSAGE(CONNECTION_MODE, "Connection %u: mode %u, interval from %F ms, latency %u") \
+    LOG_MESSAGE(CONNECTION_UPDATE_REFUSED, "Connection %u: parameter request refused, error %d") \
+    LOG_MESSAGE(REPORT_CONNECTION, "Connection %u: interval %F ms, latency %u, PHY %u") \
+    LOG_MESSAGE(REPORT_CONNECTION_MODES, "Modes:       %u to bulk, %u to idle, %u refused, %u PHY updates") \
+    LOG_MESSAGE(BME280_NOT_FOUND, "BME280 at 0x%x: not found") \
+    LOG_MESSAGE(REPORT_SENSOR, "Sensor %u:    %F C, %F hPa, %F%%") \
+    LOG_MESSAGE(REPORT_I2C_BUS, "I2C bus:     %u transfers, %u queued, %u rejected, %u errors") \
+    LOG_MESSAGE(BME280_SENSOR_BUSY, "BME280 %u: measurement is already in progress") \
+    LOG_MESSAGE(BME280_SENSOR_READ_FAILED, "BME280 %u: read failed") \
+    LOG_MESSAGE(REPORT_PRIORITIES, "Priorities:  %u background runs, wait max %u us (%u us background), background max %u us") \
+    LOG_MESSAGE(WARM_START, "Warm start: %u sensors, CO2 sensor up %u s, next sample %u") \
+    LOG_MESSAGE(HISTORY_MTU_TOO_SMALL, "History: compressed transfer needs ATT MTU %u, got %u")
+
+#endif // LOG_MESSAGES_H
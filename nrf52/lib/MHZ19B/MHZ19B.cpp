@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstring>
+
+#include <Log.h>
+
+#include "MHZ19B.h"
+
+const uint8_t MHZ19B::FRAME_LENGTH;
+const uint8_t MHZ19B::START_BYTE;
+const uint8_t MHZ19B::COMMAND_READ_CO2;
+const int MHZ19B::RESPONSE_TIMEOUT_MS;
+const uint8_t MHZ19B::MAX_RETRIES;
+const uint32_t MHZ19B::WARMUP_MS;
+const size_t MHZ19B::STATIC_EVENTS;
+
+const uint8_t MHZ19B::requestBuffer[FRAME_LENGTH] = {
+        0xFF,  // 0 constant
+        0x01,  // 1 sensor number, probably constant
+        0x86,  // 2 read command
+        0x00,  // 3
+        0x00,  // 4
+        0x00,  // 5
+        0x00,  // 6
+        0x00,  // 7
+        0x79,  // 8 checksum
+};
+
+MHZ19B::MHZ19B(hal::EventQueue &eventQueue, hal::Serial &mhz19bSerial, hal::Callback<void(uint16_t)> &&co2handler)
+        : mhz19bSerial(mhz19bSerial),
+          co2handler{co2handler},
+          drainEvent(eventQueue, hal::callback(this, &MHZ19B::drain)),
+          timeoutEvent(eventQueue, hal::callback(this, &MHZ19B::onTimeout)) {
+    mhz19bSerial.setReceiveHandler({this, &MHZ19B::onByteReceived});
+}
+
+MHZ19B::Stats MHZ19B::stats() const {
+    Stats result = statistics;
+    result.skippedBytes += received.getOverflows();
+    return result;
+}
+
+void MHZ19B::sendRequest() {
+    if (waiting) {
+        // The previous request is still being retried, it is superseded
+        ++statistics.failures;
+        finish();
+    }
+    mhz19bSerial.setEnabled(true);
+    received.clear();
+    framePosition = 0;
+    retriesLeft = MAX_RETRIES;
+    waiting = true;
+    transmit();
+}
+
+void MHZ19B::resume(bool warmedUp, uint64_t uptimeMs) {
+    poweredSinceMs = std::min(poweredSinceMs, int64_t(hal::uptimeMs()) - int64_t(uptimeMs));
+    propagateData = propagateData || warmedUp;
+}
+
+void MHZ19B::transmit() {
+    if (!mhz19bSerial.writeable()) {
+        mhz19bSerial.abortWrite();
+    }
+    ++statistics.requests;
+    if (mhz19bSerial.write(requestBuffer, sizeof(requestBuffer), {this, &MHZ19B::onWritten}) != 0) {
+        LOG(MHZ19B_NOT_WRITEABLE);
+    }
+    // 9 bytes take 10 ms at 9600 baud
+    timeoutEvent.postIn(10 + RESPONSE_TIMEOUT_MS);
+}
+
+void MHZ19B::onWritten(int event) {
+    if (!(event & hal::Serial::EVENT_TX_COMPLETE)) {
+        ++statistics.writeErrors;
+    }
+}
+
+void MHZ19B::onByteReceived(uint8_t byte) {
+    received.push(byte);
+    drainEvent.post();
+}
+
+void MHZ19B::drain() {
+    uint8_t byte;
+    while (received.pop(byte)) {
+        parse(byte);
+    }
+}
+
+void MHZ19B::parse(uint8_t byte) {
+    if (framePosition == 0 && byte != START_BYTE) {
+        ++statistics.skippedBytes;
+        return;
+    }
+    if (framePosition == 1 && byte != COMMAND_READ_CO2) {
+        // Noise before the frame, the byte may start the real one
+        ++statistics.skippedBytes;
+        framePosition = byte == START_BYTE ? 1 : 0;
+        return;
+    }
+    frame[framePosition++] = byte;
+    if (framePosition < FRAME_LENGTH) {
+        return;
+    }
+    framePosition = 0;
+    if (checksum(frame, 1) != frame[8]) {
+        // A lost byte shifts the next frame into this one, its start is among the bytes after the header
+        ++statistics.checksumErrors;
+        ++statistics.skippedBytes;
+        uint8_t rest[FRAME_LENGTH - 1];
+        memcpy(rest, &frame[1], sizeof(rest));
+        for (uint8_t b : rest) {
+            parse(b);
+        }
+        return;
+    }
+    onFrame();
+}
+
+void MHZ19B::onFrame() {
+    if (!waiting) {
+        return;
+    }
+    finish();
+    ++statistics.readings;
+    uint16_t co2ppm = (static_cast<uint16_t>(frame[2]) << 8u) + frame[3];
+    // At start sensor returns outputs 429, then 410 and only after near a two minutes
+    // sensor starts working correctly.
+    // But it is not known if sensor was powered before program start (reboot) or both
+    // CPU and sensor was powered off, unless resume() tells.
+    if (!propagateData
+        && ((co2ppm != 429 && co2ppm != 410) || poweredSinceMs + WARMUP_MS <= int64_t(hal::uptimeMs()))) {
+        propagateData = true;
+    }
+    if (propagateData) {
+        co2handler(co2ppm);
+    }
+}
+
+void MHZ19B::onTimeout() {
+    if (!waiting) {
+        return;
+    }
+    ++statistics.timeouts;
+    if (retriesLeft > 0) {
+        --retriesLeft;
+        framePosition = 0;
+        transmit();
+        return;
+    }
+    ++statistics.failures;
+    finish();
+    LOG(MHZ19B_NO_RESPONSE);
+}
+
+void MHZ19B::finish() {
+    waiting = false;
+    timeoutEvent.cancel();
+    mhz19bSerial.abortWrite();
+    mhz19bSerial.setEnabled(false);
+}
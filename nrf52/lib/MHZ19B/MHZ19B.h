@@ -0,0 +1,117 @@
+#ifndef MHZ19B_H
+#define MHZ19B_H
+
+#include <cstdint>
+
+#include <Hal.h>
+#include <RingBuffer.h>
+
+/**
+ * NB:
+ * MHZ19B requires 5V Vin, it responds with 3.3V incorrect values.
+ *
+ * The UART is enabled only from a request until its response, so the CPU sleeps deeply in between.
+ * Received bytes go through a ring buffer to a parser on the event queue, which finds the response
+ * header anywhere in the stream and skips noise, partial and corrupted frames. A request without
+ * a valid response within RESPONSE_TIMEOUT_MS is repeated right away, up to MAX_RETRIES times.
+ */
+class MHZ19B {
+public:
+    static const uint8_t FRAME_LENGTH = 9;
+    static const uint8_t START_BYTE = 0xFF;
+    static const uint8_t COMMAND_READ_CO2 = 0x86;
+    /** After the request is sent; the sensor answers within a few milliseconds */
+    static const int RESPONSE_TIMEOUT_MS = 100;
+    static const uint8_t MAX_RETRIES = 1;
+    /** After power-on the sensor reports 429 and 410 ppm for up to this long */
+    static const uint32_t WARMUP_MS = 120000;
+    /** Events the driver keeps on the queue, see hal::StaticEvent */
+    static const size_t STATIC_EVENTS = 2;
+
+    struct Stats {
+        uint32_t requests = 0;
+        uint32_t readings = 0;
+        uint32_t timeouts = 0;
+        /** Requests that got no reading even after the retries */
+        uint32_t failures = 0;
+        uint32_t checksumErrors = 0;
+        /** Requests the UART failed to send, the response times out and they are retried */
+        uint32_t writeErrors = 0;
+        /** Bytes outside of valid frames */
+        uint32_t skippedBytes = 0;
+    };
+
+    /**
+     * @param mhz19bSerial UART connected to the sensor, 9600 baud 8N1
+     */
+    MHZ19B(hal::EventQueue &eventQueue, hal::Serial &mhz19bSerial, hal::Callback<void(uint16_t)> &&co2handler);
+
+    /** Asks for a reading, the handler gets it once it is there */
+    void sendRequest();
+
+    /** Whether readings go to the handler, they don't while the sensor warms up */
+    bool isWarmedUp() const {
+        return propagateData;
+    }
+
+    /** How long the sensor has been powered, as far as the driver knows: at least since the driver started */
+    uint64_t sensorUptimeMs() const {
+        return uint64_t(int64_t(hal::uptimeMs()) - poweredSinceMs);
+    }
+
+    /**
+     * Continues the state of an earlier run, e.g. before a reset that did not cut the sensor's power.
+     * @param uptimeMs sensorUptimeMs() then, or less
+     */
+    void resume(bool warmedUp, uint64_t uptimeMs);
+
+    Stats stats() const;
+
+private:
+    static const uint8_t requestBuffer[FRAME_LENGTH];
+
+    template<class T>
+    static uint8_t checksum(const T buffer, unsigned int offset) {
+        uint8_t result = 0;
+        for (unsigned int i = offset; i < offset + 7; ++i) {
+            result += buffer[i];
+        }
+        return 0xFF - result + 1;
+    }
+
+    void transmit();
+
+    /** Interrupt context */
+    void onWritten(int event);
+
+    /** Interrupt context */
+    void onByteReceived(uint8_t byte);
+
+    void drain();
+
+    void parse(uint8_t byte);
+
+    void onFrame();
+
+    void onTimeout();
+
+    /** Ends the request, with or without a reading */
+    void finish();
+
+    hal::Serial &mhz19bSerial;
+    hal::Callback<void(uint16_t)> co2handler;
+    RingBuffer<uint8_t, 32> received;
+    /** Posted for every received byte, it runs once for all the bytes received until then */
+    hal::StaticEvent drainEvent;
+    uint8_t frame[FRAME_LENGTH]{0};
+    uint8_t framePosition = 0;
+    bool waiting = false;
+    uint8_t retriesLeft = 0;
+    hal::StaticEvent timeoutEvent;
+    /** Negative if the sensor was powered before the program started */
+    int64_t poweredSinceMs{int64_t(hal::uptimeMs())};
+    bool propagateData{false};
+    Stats statistics;
+};
+
+#endif // MHZ19B_H
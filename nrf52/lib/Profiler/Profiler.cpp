@@ -0,0 +1,33 @@
+#include "Profiler.h"
+
+const size_t Profiler::BUCKETS;
+
+namespace {
+
+Profiler::Stats probes[size_t(Probe::COUNT)];
+
+}
+
+void Profiler::record(Probe probe, uint32_t us) {
+    Stats &stats = probes[size_t(probe)];
+    if (stats.count == 0 || us < stats.minUs) {
+        stats.minUs = us;
+    }
+    if (us > stats.maxUs) {
+        stats.maxUs = us;
+    }
+    ++stats.count;
+    stats.totalUs += us;
+
+    size_t bucket = 0;
+    for (uint32_t limit = 4; bucket + 1 < BUCKETS && us >= limit; limit *= 4) {
+        ++bucket;
+    }
+    if (stats.histogram[bucket] != UINT16_MAX) {
+        ++stats.histogram[bucket];
+    }
+}
+
+const Profiler::Stats &Profiler::stats(Probe probe) {
+    return probes[size_t(probe)];
+}
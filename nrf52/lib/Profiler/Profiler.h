@@ -0,0 +1,95 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+
+#include "ProfilerProbes.h"
+
+/** Build with -D PROFILING=1 to time the probes, otherwise they compile to nothing */
+#ifndef PROFILING
+#define PROFILING 0
+#endif
+
+enum class Probe : uint8_t {
+#define PROFILER_PROBE_ID(name) name,
+    PROFILER_PROBES(PROFILER_PROBE_ID)
+#undef PROFILER_PROBE_ID
+    COUNT
+};
+
+/** Times the rest of the enclosing scope */
+#define PROFILE_SCOPE(probe) Profiler::Scope profileScope{Probe::probe}
+
+/**
+ * @class Profiler
+ * @brief Durations of code paths: count, minimum, maximum, mean and a histogram per probe.
+ *
+ * Time comes from hal::cycleCount(), the DWT cycle counter on the device, and is kept in microseconds.
+ * A duration is either the scope of a PROFILE_SCOPE or spans several handlers, from start() to stop().
+ * Probes are recorded from the event queue thread only.
+ */
+class Profiler {
+public:
+    /** Bucket i counts durations below 4^(i+1) us, the last one all longer ones */
+    static const size_t BUCKETS = 8;
+
+    struct Stats {
+        uint32_t count;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        /** Saturating */
+        uint16_t histogram[BUCKETS];
+
+        uint32_t meanUs() const {
+            return count == 0 ? 0 : uint32_t(totalUs / count);
+        }
+    };
+
+    class Scope {
+    public:
+#if PROFILING
+        explicit Scope(Probe probe) : probe(probe), startCycles(start()) {}
+
+        ~Scope() {
+            stop(probe, startCycles);
+        }
+
+    private:
+        const Probe probe;
+        const uint32_t startCycles;
+#else
+        explicit Scope(Probe) {}
+#endif
+    };
+
+    static bool isEnabled() {
+        return PROFILING != 0;
+    }
+
+    /** @return timestamp to pass to stop() */
+    static uint32_t start() {
+#if PROFILING
+        return hal::cycleCount();
+#else
+        return 0;
+#endif
+    }
+
+#if PROFILING
+    static void stop(Probe probe, uint32_t startCycles) {
+        record(probe, (hal::cycleCount() - startCycles) / hal::cyclesPerUs());
+    }
+#else
+    static void stop(Probe, uint32_t) {}
+#endif
+
+    static void record(Probe probe, uint32_t us);
+
+    static const Stats &stats(Probe probe);
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,19 @@
+#ifndef PROFILER_PROBES_H
+#define PROFILER_PROBES_H
+
+/**
+ * Code paths that are timed, PROFILER_PROBE(name). The id of a probe is its position in the list,
+ * it identifies the probe on the console and in the diagnostics service.
+ */
+#define PROFILER_PROBES(PROFILER_PROBE) \
+    PROFILER_PROBE(BLE_STACK) /* BLE::processEvents, device only */ \
+    PROFILER_PROBE(BLE_CALLBACKS) /* connection and GATT callbacks of the application */ \
+    PROFILER_PROBE(SCHEDULER_WAKEUP) /* all tasks that run on a scheduler wakeup */ \
+    PROFILER_PROBE(BME280_READ) /* from the request to the compensated measurement */ \
+    PROFILER_PROBE(MHZ19B_ROUND_TRIP) /* from the request to the reading */ \
+    PROFILER_PROBE(GATT_WRITE) /* a characteristic value update or notification */ \
+    PROFILER_PROBE(HISTORY_APPEND) /* a sample into the RAM history and the flash log */ \
+    PROFILER_PROBE(STATISTICS) /* samples into the reading statistics, or the summary for the GATT server */ \
+    PROFILER_PROBE(HISTORY_ENCODE) /* a compressed block of the history for a notification */
+
+#endif // PROFILER_PROBES_H
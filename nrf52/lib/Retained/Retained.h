@@ -0,0 +1,63 @@
+#ifndef RETAINED_H
+#define RETAINED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <Crc32.h>
+
+/**
+ * @class Retained
+ * @brief A value that survives resets in HAL_RETAINED RAM, with a header and a CRC-32 to tell it from garbage.
+ *
+ * Declare it HAL_RETAINED at namespace scope: the class has no constructor, nothing touches it at start-up.
+ * After a power-on the CRC fails and load() returns false. MAGIC is the layout of T: change it along with T,
+ * so a firmware update does not take the value of another layout, the size check catches most of those anyway.
+ *
+ * @tparam T trivially copyable
+ * @tparam MAGIC identifies T and its version
+ */
+template<typename T, uint32_t MAGIC>
+class Retained {
+    static_assert(std::is_trivially_copyable<T>::value, "The value is kept and compared as bytes");
+
+public:
+    /** @return false if there is no value stored by a previous run, value is unchanged then */
+    bool load(T &value) const {
+        if (header.magic != MAGIC || header.length != sizeof(T) || crc != checksum()) {
+            return false;
+        }
+        memcpy(&value, &stored, sizeof(T));
+        return true;
+    }
+
+    void store(const T &value) {
+        header.magic = MAGIC;
+        header.length = sizeof(T);
+        memcpy(&stored, &value, sizeof(T));
+        crc = checksum();
+    }
+
+    /** The next run starts cold */
+    void invalidate() {
+        header.magic = 0;
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t length;
+    };
+
+    uint32_t checksum() const {
+        return crc32(&stored, sizeof(T), crc32(&header, sizeof(header)));
+    }
+
+    Header header;
+    T stored;
+    uint32_t crc;
+};
+
+#endif // RETAINED_H
@@ -0,0 +1,74 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class RingBuffer
+ * @brief Lock-free queue of one producer and one consumer, e.g. an interrupt handler and the event queue.
+ *
+ * Capacity is a power of two, the indices run freely and wrap around on their own.
+ * A push to a full buffer fails and is counted, nothing already queued is overwritten.
+ */
+template<typename T, size_t N>
+class RingBuffer {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+    static_assert(N <= UINT32_MAX / 2, "RingBuffer capacity must fit the index type");
+
+public:
+    static const size_t CAPACITY = N;
+
+    /** Producer side. @return false if the buffer is full */
+    bool push(const T &value) {
+        uint32_t head = this->head.load(std::memory_order_relaxed);
+        if (head - tail.load(std::memory_order_acquire) == N) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[head % N] = value;
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side. @return false if the buffer is empty */
+    bool pop(T &value) {
+        uint32_t tail = this->tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == tail) {
+            return false;
+        }
+        value = items[tail % N];
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    /** Consumer side, drops everything queued */
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /** Pushes that failed because the buffer was full */
+    uint32_t getOverflows() const {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+private:
+    T items[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> overflows{0};
+};
+
+template<typename T, size_t N>
+const size_t RingBuffer<T, N>::CAPACITY;
+
+#endif // RING_BUFFER_H
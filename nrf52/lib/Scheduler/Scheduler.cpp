@@ -0,0 +1,122 @@
+#include <Profiler.h>
+
+#include "Scheduler.h"
+
+const size_t Scheduler::MAX_TASKS;
+const uint32_t Scheduler::COALESCE_DIVISOR;
+const uint32_t Scheduler::MIN_PERIOD_MS;
+
+const size_t Scheduler::STATIC_EVENTS;
+
+Scheduler::Scheduler(hal::EventQueue &eventQueue)
+        : timer(eventQueue, hal::callback(this, &Scheduler::wakeup), hal::StaticEvent::BACKGROUND) {}
+
+int Scheduler::add(const hal::Callback<void()> &task, uint32_t fastMs, uint32_t slowMs) {
+    if (taskCount == MAX_TASKS || fastMs < MIN_PERIOD_MS || slowMs < fastMs) {
+        return -1;
+    }
+    uint64_t now = hal::uptimeMs();
+    tasks[taskCount] = {task, fastMs, slowMs, fastMs, now, now};
+    int id = int(taskCount++);
+    if (started) {
+        reschedule();
+    }
+    return id;
+}
+
+bool Scheduler::setPeriods(int id, uint32_t fastMs, uint32_t slowMs) {
+    if (fastMs < MIN_PERIOD_MS || slowMs < fastMs) {
+        return false;
+    }
+    Task &task = tasks[id];
+    task.fastMs = fastMs;
+    task.slowMs = slowMs;
+    if (task.periodMs > slowMs) {
+        task.periodMs = slowMs;
+    }
+    if (task.periodMs < fastMs) {
+        task.periodMs = fastMs;
+    }
+    // Runs at the new period from the last run, which may be right now
+    task.dueMs = task.lastMs + task.periodMs;
+    if (started) {
+        reschedule();
+    }
+    return true;
+}
+
+void Scheduler::activity(int id) {
+    speedUp(tasks[id]);
+    if (started) {
+        reschedule();
+    }
+}
+
+void Scheduler::setBoost(bool boost) {
+    if (boost == boosted) {
+        return;
+    }
+    boosted = boost;
+    if (!boost) {
+        // Tasks slow down by themselves
+        return;
+    }
+    for (size_t i = 0; i < taskCount; ++i) {
+        speedUp(tasks[i]);
+    }
+    if (started) {
+        reschedule();
+    }
+}
+
+void Scheduler::start() {
+    started = true;
+    reschedule();
+}
+
+void Scheduler::speedUp(Task &task) {
+    task.periodMs = task.fastMs;
+    if (task.dueMs > task.lastMs + task.periodMs) {
+        task.dueMs = task.lastMs + task.periodMs;
+    }
+}
+
+void Scheduler::wakeup() {
+    PROFILE_SCOPE(SCHEDULER_WAKEUP);
+    ++statistics.wakeups;
+    uint64_t now = hal::uptimeMs();
+    for (size_t i = 0; i < taskCount; ++i) {
+        Task &task = tasks[i];
+        if (task.dueMs > now + task.periodMs / COALESCE_DIVISOR) {
+            continue;
+        }
+        task.lastMs = now;
+        task.dueMs = now + task.periodMs;
+        // The next period is longer unless something keeps the task busy until then
+        if (!boosted && task.periodMs < task.slowMs) {
+            task.periodMs = task.periodMs > task.slowMs / 2 ? task.slowMs : task.periodMs * 2;
+        }
+        ++statistics.runs;
+        task.callback();
+    }
+    reschedule();
+}
+
+void Scheduler::reschedule() {
+    if (taskCount == 0) {
+        return;
+    }
+    uint64_t due = tasks[0].dueMs;
+    for (size_t i = 1; i < taskCount; ++i) {
+        if (tasks[i].dueMs < due) {
+            due = tasks[i].dueMs;
+        }
+    }
+    if (timer.isPending() && timerDueMs == due) {
+        return;
+    }
+    timer.cancel();
+    uint64_t now = hal::uptimeMs();
+    timerDueMs = due;
+    timer.postIn(int(due > now ? due - now : 0));
+}
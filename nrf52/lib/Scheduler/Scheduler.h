@@ -0,0 +1,110 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+
+/** Number of periodic tasks */
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 4
+#endif
+
+/**
+ * @class Scheduler
+ * @brief Runs periodic tasks from a single timer event on the queue.
+ *
+ * Every task has a fast and a slow period. A task runs at the fast period while it reports activity,
+ * e.g. its readings change, or while the scheduler is boosted, e.g. a client is subscribed. Otherwise
+ * the period doubles after every run until it reaches the slow one.
+ *
+ * There is one pending timer for all tasks. When it fires, every task due within a quarter of its period
+ * runs too, so tasks with different periods share wakeups instead of waking the CPU one by one.
+ * The timer is a background event: tasks never delay the BLE events and completions waiting on the queue.
+ */
+class Scheduler {
+public:
+    static const size_t MAX_TASKS = SCHEDULER_MAX_TASKS;
+    /** A task runs early if it is due within period / COALESCE_DIVISOR */
+    static const uint32_t COALESCE_DIVISOR = 4;
+    static const uint32_t MIN_PERIOD_MS = 100;
+    /** Events the scheduler keeps on the queue, see hal::StaticEvent */
+    static const size_t STATIC_EVENTS = 1;
+
+    struct Stats {
+        uint64_t wakeups = 0;
+        uint64_t runs = 0;
+    };
+
+    explicit Scheduler(hal::EventQueue &eventQueue);
+
+    /**
+     * The task first runs at start(), or at once if the scheduler is already started.
+     * @return task id, or -1 if there are MAX_TASKS already
+     */
+    int add(const hal::Callback<void()> &task, uint32_t fastMs, uint32_t slowMs);
+
+    /**
+     * @return false if the periods are out of order or shorter than MIN_PERIOD_MS, nothing changes then
+     */
+    bool setPeriods(int id, uint32_t fastMs, uint32_t slowMs);
+
+    uint32_t getFastPeriod(int id) const {
+        return tasks[id].fastMs;
+    }
+
+    uint32_t getSlowPeriod(int id) const {
+        return tasks[id].slowMs;
+    }
+
+    /** Period the task runs at now */
+    uint32_t getPeriod(int id) const {
+        return tasks[id].periodMs;
+    }
+
+    size_t getTaskCount() const {
+        return taskCount;
+    }
+
+    /** The task is busy, it runs at the fast period again */
+    void activity(int id);
+
+    /** While boosted, every task runs at its fast period */
+    void setBoost(bool boost);
+
+    void start();
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    struct Task {
+        hal::Callback<void()> callback;
+        uint32_t fastMs;
+        uint32_t slowMs;
+        uint32_t periodMs;
+        uint64_t lastMs;
+        uint64_t dueMs;
+    };
+
+    /** Runs the tasks that are due, or nearly so */
+    void wakeup();
+
+    /** Brings the task's next run forward if its period has become shorter */
+    void speedUp(Task &task);
+
+    /** Replaces the pending timer event with one for the earliest due task */
+    void reschedule();
+
+    hal::StaticEvent timer;
+    Task tasks[MAX_TASKS];
+    size_t taskCount = 0;
+    bool started = false;
+    bool boosted = false;
+    uint64_t timerDueMs = 0;
+    Stats statistics;
+};
+
+#endif // SCHEDULER_H
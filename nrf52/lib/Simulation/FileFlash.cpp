@@ -0,0 +1,117 @@
+#ifdef HAL_NATIVE
+
+#include <algorithm>
+
+#include "FileFlash.h"
+
+FileFlash::FileFlash(const char *path, uint32_t size, uint32_t sectorSize, uint32_t programSize)
+        : file(nullptr),
+          size(size),
+          sectorSize(sectorSize),
+          programSize(programSize),
+          sectorErases(size / sectorSize) {
+    if (path == nullptr) {
+        file = tmpfile();
+    } else {
+        file = fopen(path, "r+b");
+        if (file == nullptr) {
+            file = fopen(path, "w+b");
+        }
+    }
+    if (file == nullptr) {
+        return;
+    }
+    // A missing or short file is extended with erased sectors
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    for (long i = length; i < long(size); ++i) {
+        fputc(0xFF, file);
+    }
+    fflush(file);
+}
+
+FileFlash::~FileFlash() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+int FileFlash::init() {
+    return file != nullptr ? 0 : -1;
+}
+
+uint32_t FileFlash::getProgramSize() const {
+    return programSize;
+}
+
+uint32_t FileFlash::getSectorSize() const {
+    return sectorSize;
+}
+
+uint32_t FileFlash::getSize() const {
+    return size;
+}
+
+int FileFlash::read(uint32_t address, void *buffer, uint32_t length) {
+    if (file == nullptr || powerOff || address + length > size) {
+        return -1;
+    }
+    ++statistics.reads;
+    fseek(file, address, SEEK_SET);
+    return fread(buffer, 1, length, file) == length ? 0 : -1;
+}
+
+int FileFlash::program(uint32_t address, const void *data, uint32_t length) {
+    if (file == nullptr || powerOff || address + length > size
+        || address % programSize != 0 || length % programSize != 0) {
+        return -1;
+    }
+    if (powerCutPending) {
+        powerCutPending = false;
+        powerOff = true;
+        length = std::min(length, bytesBeforeCut);
+    }
+    std::vector<uint8_t> cells(length);
+    fseek(file, address, SEEK_SET);
+    if (fread(cells.data(), 1, length, file) != length) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+        cells[i] &= static_cast<const uint8_t *>(data)[i];
+    }
+    fseek(file, address, SEEK_SET);
+    fwrite(cells.data(), 1, length, file);
+    fflush(file);
+    ++statistics.programs;
+    statistics.programmedBytes += length;
+    return powerOff ? -1 : 0;
+}
+
+int FileFlash::erase(uint32_t address, uint32_t length) {
+    if (file == nullptr || powerOff || address + length > size
+        || address % sectorSize != 0 || length % sectorSize != 0) {
+        return -1;
+    }
+    std::vector<uint8_t> erased(sectorSize, 0xFF);
+    for (uint32_t sector = address; sector < address + length; sector += sectorSize) {
+        fseek(file, sector, SEEK_SET);
+        fwrite(erased.data(), 1, sectorSize, file);
+        uint64_t &count = sectorErases[sector / sectorSize];
+        statistics.maxSectorErases = std::max(statistics.maxSectorErases, ++count);
+        ++statistics.erases;
+    }
+    fflush(file);
+    return 0;
+}
+
+void FileFlash::cutPower(uint32_t programmedBytes) {
+    powerCutPending = true;
+    bytesBeforeCut = programmedBytes;
+}
+
+void FileFlash::restorePower() {
+    powerCutPending = false;
+    powerOff = false;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef FILE_FLASH_H
+#define FILE_FLASH_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <Hal.h>
+
+/**
+ * NOR flash backed by a plain file, with nRF52 geometry by default. Programming ANDs data into
+ * the file like real flash does. A power cut can be injected: the next program call writes only
+ * a prefix of its data and every call fails until power is restored.
+ */
+class FileFlash : public hal::Flash {
+public:
+    struct Stats {
+        uint64_t reads = 0;
+        uint64_t programs = 0;
+        uint64_t programmedBytes = 0;
+        uint64_t erases = 0;
+        uint64_t maxSectorErases = 0;
+    };
+
+    /**
+     * @param path backing file, created erased if it is missing; a temporary file if null
+     */
+    explicit FileFlash(const char *path, uint32_t size = 64 * 1024, uint32_t sectorSize = 4096,
+                       uint32_t programSize = 4);
+
+    ~FileFlash() override;
+
+    int init() override;
+
+    uint32_t getProgramSize() const override;
+
+    uint32_t getSectorSize() const override;
+
+    uint32_t getSize() const override;
+
+    int read(uint32_t address, void *buffer, uint32_t size) override;
+
+    int program(uint32_t address, const void *data, uint32_t size) override;
+
+    int erase(uint32_t address, uint32_t size) override;
+
+    /** The next program call writes only the first bytes of its data, later calls fail */
+    void cutPower(uint32_t programmedBytes);
+
+    void restorePower();
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    FILE *file;
+    uint32_t size;
+    uint32_t sectorSize;
+    uint32_t programSize;
+    bool powerCutPending = false;
+    bool powerOff = false;
+    uint32_t bytesBeforeCut = 0;
+    std::vector<uint64_t> sectorErases;
+    Stats statistics;
+};
+
+#endif
+
+#endif // FILE_FLASH_H
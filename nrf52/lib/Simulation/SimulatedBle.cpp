@@ -0,0 +1,428 @@
+#ifdef HAL_NATIVE
+
+#include <algorithm>
+#include <iterator>
+
+#include "SimulatedBle.h"
+
+namespace {
+
+const uint16_t UUID_PRIMARY_SERVICE = 0x2800;
+const uint16_t UUID_CHARACTERISTIC = 0x2803;
+const uint16_t UUID_CCCD = 0x2902;
+
+}
+
+SimulatedBle::SimulatedBle(hal::EventQueue &eventQueue) : eventQueue(eventQueue) {}
+
+int SimulatedBle::init(const hal::Callback<void(int)> &initComplete) {
+    if (initialized) {
+        return hal::BLE_ERROR_INVALID_STATE;
+    }
+    initialized = true;
+    eventQueue.call(initComplete, int(hal::BLE_ERROR_NONE));
+    return hal::BLE_ERROR_NONE;
+}
+
+hal::Gap &SimulatedBle::gap() {
+    return *this;
+}
+
+hal::GattServer &SimulatedBle::gattServer() {
+    return *this;
+}
+
+const char *SimulatedBle::errorToString(int error) const {
+    switch (error) {
+        case hal::BLE_ERROR_NONE:
+            return "BLE_ERROR_NONE";
+        case hal::BLE_ERROR_BUFFER_OVERFLOW:
+            return "BLE_ERROR_BUFFER_OVERFLOW";
+        case hal::BLE_ERROR_NOT_IMPLEMENTED:
+            return "BLE_ERROR_NOT_IMPLEMENTED";
+        case hal::BLE_ERROR_PARAM_OUT_OF_RANGE:
+            return "BLE_ERROR_PARAM_OUT_OF_RANGE";
+        case hal::BLE_ERROR_INVALID_PARAM:
+            return "BLE_ERROR_INVALID_PARAM";
+        case hal::BLE_ERROR_INVALID_STATE:
+            return "BLE_ERROR_INVALID_STATE";
+        case hal::BLE_ERROR_NO_MEM:
+            return "BLE_ERROR_NO_MEM";
+        default:
+            return "BLE_ERROR_UNSPECIFIED";
+    }
+}
+
+uint8_t SimulatedBle::getConnectionCount() const {
+    return uint8_t(connections.size());
+}
+
+uint8_t SimulatedBle::getMaxConnections() const {
+    return MAX_CONNECTIONS;
+}
+
+int SimulatedBle::setAdvertisingPayload(const hal::AdvertisingData &data) {
+    advertisingData = data;
+    ++statistics.advertisingPayloads;
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::setScanResponse(const hal::AdvertisingData &data) {
+    scanResponse = data;
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::startAdvertising(uint16_t intervalMs, bool connectable) {
+    if (!initialized || advertising || (connections.size() == MAX_CONNECTIONS && connectable)) {
+        return hal::BLE_ERROR_INVALID_STATE;
+    }
+    if (intervalMs < 20 || (!connectable && intervalMs < 100)) {
+        return hal::BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+    advertising = true;
+    advertisingConnectable = connectable;
+    advertisingIntervalMs = intervalMs;
+    advertisingSinceMs = eventQueue.tick();
+    ++statistics.advertisingStarts;
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::stopAdvertising() {
+    if (!advertising) {
+        return hal::BLE_ERROR_INVALID_STATE;
+    }
+    advertising = false;
+    statistics.advertisingEvents += (eventQueue.tick() - advertisingSinceMs) / advertisingIntervalMs;
+    return hal::BLE_ERROR_NONE;
+}
+
+SimulatedBle::Stats SimulatedBle::stats() const {
+    Stats current = statistics;
+    if (advertising) {
+        current.advertisingEvents += (eventQueue.tick() - advertisingSinceMs) / advertisingIntervalMs;
+    }
+    return current;
+}
+
+void SimulatedBle::onConnection(const hal::Callback<void(hal::ConnectionHandle)> &callback) {
+    connectionCallback = callback;
+}
+
+void SimulatedBle::onDisconnection(const hal::Callback<void(hal::ConnectionHandle)> &callback) {
+    disconnectionCallback = callback;
+}
+
+int SimulatedBle::updateConnectionParameters(hal::ConnectionHandle connection,
+                                             const hal::ConnectionParameters &parameters) {
+    Connection *client = findConnection(connection);
+    if (client == nullptr) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    if (parameters.minInterval < 6 || parameters.maxInterval > 3200 || parameters.minInterval > parameters.maxInterval
+        || parameters.slaveLatency > 499 || parameters.supervisionTimeout < 10 || parameters.supervisionTimeout > 3200
+        || uint32_t(parameters.supervisionTimeout) * 4 <= (1u + parameters.slaveLatency) * parameters.maxInterval) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    if (client->updating) {
+        return hal::BLE_ERROR_INVALID_STATE;
+    }
+    client->updating = true;
+    hal::ConnectionParameters accepted = parameters;
+    // The central takes the shortest interval of the range it supports
+    accepted.minInterval = std::min(std::max(parameters.minInterval, uint16_t(CENTRAL_MIN_INTERVAL)),
+                                    parameters.maxInterval);
+    accepted.maxInterval = accepted.minInterval;
+    eventQueue.call_in(int(UPDATE_EVENTS * intervalMs(*client)), this, &SimulatedBle::completeUpdate, connection,
+                       accepted);
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::getConnectionParameters(hal::ConnectionHandle connection,
+                                          hal::ConnectionParameters &parameters) const {
+    const Connection *client = findConnection(connection);
+    if (client == nullptr) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    parameters = client->parameters;
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::setPreferredPhy(hal::ConnectionHandle connection, hal::Phy phy) {
+    Connection *client = findConnection(connection);
+    if (client == nullptr) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    if (phy == hal::PHY_CODED) {
+        return hal::BLE_ERROR_NOT_IMPLEMENTED;
+    }
+    eventQueue.call_in(int(UPDATE_EVENTS * intervalMs(*client)), this, &SimulatedBle::completePhyUpdate, connection,
+                       phy);
+    return hal::BLE_ERROR_NONE;
+}
+
+hal::Phy SimulatedBle::getPhy(hal::ConnectionHandle connection) const {
+    const Connection *client = findConnection(connection);
+    return client != nullptr ? client->phy : hal::PHY_1M;
+}
+
+void SimulatedBle::onConnectionUpdated(const hal::Callback<void(hal::ConnectionHandle)> &callback) {
+    connectionUpdatedCallback = callback;
+}
+
+void SimulatedBle::completeUpdate(hal::ConnectionHandle connection, hal::ConnectionParameters parameters) {
+    Connection *client = findConnection(connection);
+    if (client == nullptr) {
+        return;
+    }
+    client->parameters = parameters;
+    client->updating = false;
+    ++statistics.parameterUpdates;
+    if (connectionUpdatedCallback) {
+        connectionUpdatedCallback(connection);
+    }
+}
+
+void SimulatedBle::completePhyUpdate(hal::ConnectionHandle connection, hal::Phy phy) {
+    Connection *client = findConnection(connection);
+    if (client == nullptr || client->phy == phy) {
+        return;
+    }
+    client->phy = phy;
+    ++statistics.phyUpdates;
+    if (connectionUpdatedCallback) {
+        connectionUpdatedCallback(connection);
+    }
+}
+
+int SimulatedBle::addService(const hal::Uuid &uuid, Characteristic *characteristics, size_t count) {
+    std::vector<uint8_t> declaration;
+    if (uuid.isShort()) {
+        declaration = {uint8_t(uuid.getShort()), uint8_t(uuid.getShort() >> 8)};
+    } else {
+        declaration.assign(std::make_reverse_iterator(uuid.getLong() + hal::Uuid::LONG_LENGTH),
+                           std::make_reverse_iterator(uuid.getLong()));
+    }
+    attributeTable.push_back({UUID_PRIMARY_SERVICE, ++lastHandle, 0, declaration});
+    for (size_t i = 0; i < count; ++i) {
+        Characteristic &characteristic = characteristics[i];
+        attributeTable.push_back({UUID_CHARACTERISTIC, ++lastHandle, 0, {}});
+        characteristic.valueHandle = ++lastHandle;
+        attributeTable.push_back({characteristic.uuid, characteristic.valueHandle, characteristic.properties,
+                                  {characteristic.value, characteristic.value + characteristic.length}});
+        if (characteristic.properties & (PROPERTY_NOTIFY | PROPERTY_INDICATE)) {
+            attributeTable.push_back({UUID_CCCD, ++lastHandle, 0, {0, 0}});
+        }
+        for (uint8_t d = 0; d < characteristic.descriptorCount; ++d) {
+            Descriptor &descriptor = characteristic.descriptors[d];
+            descriptor.handle = ++lastHandle;
+            attributeTable.push_back({descriptor.uuid, descriptor.handle,
+                                      uint8_t(PROPERTY_READ | (descriptor.writable ? PROPERTY_WRITE : 0)),
+                                      {descriptor.value, descriptor.value + descriptor.length}});
+        }
+    }
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::write(Handle handle, const uint8_t *value, uint16_t length, bool localOnly) {
+    Attribute *attribute = findAttribute(handle);
+    if (attribute == nullptr) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    attribute->value.assign(value, value + length);
+    ++statistics.writes;
+    int result = hal::BLE_ERROR_NONE;
+    for (size_t i = 0; !localOnly && i < connections.size(); ++i) {
+        // A client that misses the notification reads the value later, the others get it
+        if (int error = notify(connections[i], *attribute, value, length); error != hal::BLE_ERROR_NONE) {
+            result = error;
+        }
+    }
+    return result;
+}
+
+int SimulatedBle::write(hal::ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length) {
+    Attribute *attribute = findAttribute(handle);
+    Connection *target = findConnection(connection);
+    if (attribute == nullptr || target == nullptr) {
+        return hal::BLE_ERROR_INVALID_PARAM;
+    }
+    if (int error = notify(*target, *attribute, value, length); error != hal::BLE_ERROR_NONE) {
+        return error;
+    }
+    attribute->value.assign(value, value + length);
+    ++statistics.writes;
+    return hal::BLE_ERROR_NONE;
+}
+
+int SimulatedBle::notify(Connection &connection, const Attribute &attribute, const uint8_t *value,
+                         uint16_t length) {
+    if (!(attribute.properties & PROPERTY_NOTIFY) || !areUpdatesEnabled(connection.handle, attribute.handle)) {
+        return hal::BLE_ERROR_NONE;
+    }
+    if (length > connection.attMtu - NOTIFICATION_HEADER_LENGTH) {
+        return hal::BLE_ERROR_PARAM_OUT_OF_RANGE;
+    }
+    if (connection.txPending == (connection.phy == hal::PHY_2M ? 2 * TX_BUFFERS : TX_BUFFERS)) {
+        ++statistics.txBufferFull;
+        return hal::BLE_ERROR_NO_MEM;
+    }
+    if (connection.txPending++ == 0) {
+        eventQueue.call_in(int(intervalMs(connection)), this, &SimulatedBle::connectionEvent, connection.handle);
+    }
+    ++statistics.notifications;
+    statistics.notifiedBytes += length;
+    if (clientNotificationCallback) {
+        clientNotificationCallback(connection.handle, attribute.handle, value, length);
+    }
+    return hal::BLE_ERROR_NONE;
+}
+
+bool SimulatedBle::areUpdatesEnabled(hal::ConnectionHandle connection, Handle handle) {
+    const Connection *client = findConnection(connection);
+    return client != nullptr
+           && std::find(client->subscriptions.begin(), client->subscriptions.end(), handle)
+              != client->subscriptions.end();
+}
+
+uint16_t SimulatedBle::getAttMtu(hal::ConnectionHandle connection) const {
+    const Connection *client = findConnection(connection);
+    return client != nullptr ? client->attMtu : DEFAULT_ATT_MTU;
+}
+
+void SimulatedBle::onDataWritten(
+        const hal::Callback<void(hal::ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) {
+    dataWrittenCallback = callback;
+}
+
+void SimulatedBle::onUpdatesChanged(const hal::Callback<void(Handle)> &callback) {
+    updatesChangedCallback = callback;
+}
+
+void SimulatedBle::onDataSent(const hal::Callback<void(unsigned)> &callback) {
+    dataSentCallback = callback;
+}
+
+hal::ConnectionHandle SimulatedBle::connect(uint16_t attMtu, bool subscribeAll) {
+    if (!advertising || !advertisingConnectable || connections.size() == MAX_CONNECTIONS) {
+        return INVALID_CONNECTION;
+    }
+    stopAdvertising();
+    Connection connection{lastConnection++, attMtu, 0, {}, {CENTRAL_INTERVAL, CENTRAL_INTERVAL, 0, 72}, hal::PHY_1M,
+                          false};
+    if (subscribeAll) {
+        for (const Attribute &attribute : attributeTable) {
+            if (attribute.properties & (PROPERTY_NOTIFY | PROPERTY_INDICATE)) {
+                connection.subscriptions.push_back(attribute.handle);
+            }
+        }
+    }
+    connections.push_back(connection);
+    ++statistics.connections;
+    if (connectionCallback) {
+        connectionCallback(connection.handle);
+    }
+    return connection.handle;
+}
+
+void SimulatedBle::disconnect(hal::ConnectionHandle connection) {
+    auto it = std::find_if(connections.begin(), connections.end(), [connection](const Connection &c) {
+        return c.handle == connection;
+    });
+    if (it == connections.end()) {
+        return;
+    }
+    // Subscriptions of a client without bonding do not survive the connection
+    connections.erase(it);
+    if (disconnectionCallback) {
+        disconnectionCallback(connection);
+    }
+}
+
+void SimulatedBle::subscribe(hal::ConnectionHandle connection, Handle valueHandle, bool enabled) {
+    Connection *client = findConnection(connection);
+    Attribute *attribute = findAttribute(valueHandle);
+    if (client == nullptr || attribute == nullptr || !(attribute->properties & (PROPERTY_NOTIFY | PROPERTY_INDICATE))) {
+        return;
+    }
+    std::vector<Handle> &subscriptions = client->subscriptions;
+    subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), valueHandle), subscriptions.end());
+    if (enabled) {
+        subscriptions.push_back(valueHandle);
+    }
+    if (updatesChangedCallback) {
+        eventQueue.call([this, valueHandle]() {
+            updatesChangedCallback(valueHandle);
+        });
+    }
+}
+
+SimulatedBle::Handle SimulatedBle::findHandle(const hal::Uuid &uuid, Handle after) const {
+    for (const Attribute &attribute : attributeTable) {
+        if (attribute.handle > after && attribute.uuid == uuid) {
+            return attribute.handle;
+        }
+    }
+    return 0;
+}
+
+const std::vector<uint8_t> *SimulatedBle::readAttribute(Handle handle) {
+    Attribute *attribute = findAttribute(handle);
+    return attribute != nullptr ? &attribute->value : nullptr;
+}
+
+void SimulatedBle::clientWrite(hal::ConnectionHandle connection, Handle handle, const uint8_t *value,
+                               uint16_t length) {
+    Attribute *attribute = findAttribute(handle);
+    if (findConnection(connection) == nullptr || attribute == nullptr
+        || !(attribute->properties & (PROPERTY_WRITE | PROPERTY_WRITE_WITHOUT_RESPONSE))) {
+        return;
+    }
+    attribute->value.assign(value, value + length);
+    if (dataWrittenCallback) {
+        eventQueue.call([this, connection, handle, data = attribute->value]() {
+            dataWrittenCallback(connection, handle, data.data(), uint16_t(data.size()));
+        });
+    }
+}
+
+void SimulatedBle::connectionEvent(hal::ConnectionHandle connection) {
+    // Queued notifications are lost with the connection, like in a real stack
+    Connection *client = findConnection(connection);
+    if (client == nullptr) {
+        return;
+    }
+    unsigned sent = client->txPending;
+    client->txPending = 0;
+    if (sent != 0 && dataSentCallback) {
+        dataSentCallback(sent);
+    }
+}
+
+SimulatedBle::Attribute *SimulatedBle::findAttribute(Handle handle) {
+    for (Attribute &attribute : attributeTable) {
+        if (attribute.handle == handle) {
+            return &attribute;
+        }
+    }
+    return nullptr;
+}
+
+SimulatedBle::Connection *SimulatedBle::findConnection(hal::ConnectionHandle handle) {
+    for (Connection &connection : connections) {
+        if (connection.handle == handle) {
+            return &connection;
+        }
+    }
+    return nullptr;
+}
+
+const SimulatedBle::Connection *SimulatedBle::findConnection(hal::ConnectionHandle handle) const {
+    for (const Connection &connection : connections) {
+        if (connection.handle == handle) {
+            return &connection;
+        }
+    }
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef SIMULATED_BLE_H
+#define SIMULATED_BLE_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+#include <vector>
+
+#include <Hal.h>
+
+/**
+ * BLE stack with scripted centrals. The attribute table is laid out the way a real stack does it,
+ * subscriptions are kept per connection like CCCD values of clients without bonding. Notifications take
+ * one of the TX buffers of their connection, the buffers are released once per connection interval,
+ * the way the SoftDevice does it. Centrals connect at CENTRAL_INTERVAL and accept parameter and PHY
+ * requests UPDATE_EVENTS connection events later, intervals no shorter than CENTRAL_MIN_INTERVAL,
+ * like phones do. At 2M PHY twice as many notifications fit a connection event.
+ */
+class SimulatedBle : public hal::Ble, public hal::Gap, public hal::GattServer {
+public:
+    struct Stats {
+        uint64_t writes = 0;
+        uint64_t notifications = 0;
+        uint64_t notifiedBytes = 0;
+        uint64_t connections = 0;
+        uint64_t advertisingStarts = 0;
+        uint64_t advertisingEvents = 0;
+        uint64_t advertisingPayloads = 0;
+        uint64_t txBufferFull = 0;
+        uint64_t parameterUpdates = 0;
+        uint64_t phyUpdates = 0;
+    };
+
+    /** Notifications the stack queues per connection event */
+    static const unsigned TX_BUFFERS = 6;
+
+    /** Peripheral links, like a SoftDevice configured for a phone and a gateway */
+    static const uint8_t MAX_CONNECTIONS = 2;
+
+    /** Connection interval a central starts with, 30 ms */
+    static const uint16_t CENTRAL_INTERVAL = 24;
+
+    /** Shortest interval a central accepts, 15 ms */
+    static const uint16_t CENTRAL_MIN_INTERVAL = 12;
+
+    /** Connection events from a parameter or PHY request till the new ones are in use */
+    static const unsigned UPDATE_EVENTS = 6;
+
+    struct Attribute {
+        hal::Uuid uuid;
+        Handle handle;
+        uint8_t properties;
+        std::vector<uint8_t> value;
+    };
+
+    explicit SimulatedBle(hal::EventQueue &eventQueue);
+
+    int init(const hal::Callback<void(int)> &initComplete) override;
+
+    hal::Gap &gap() override;
+
+    hal::GattServer &gattServer() override;
+
+    const char *errorToString(int error) const override;
+
+    uint8_t getConnectionCount() const override;
+
+    uint8_t getMaxConnections() const override;
+
+    int setAdvertisingPayload(const hal::AdvertisingData &data) override;
+
+    int setScanResponse(const hal::AdvertisingData &data) override;
+
+    int startAdvertising(uint16_t intervalMs, bool connectable = true) override;
+
+    int stopAdvertising() override;
+
+    void onConnection(const hal::Callback<void(hal::ConnectionHandle)> &callback) override;
+
+    void onDisconnection(const hal::Callback<void(hal::ConnectionHandle)> &callback) override;
+
+    int updateConnectionParameters(hal::ConnectionHandle connection,
+                                   const hal::ConnectionParameters &parameters) override;
+
+    int getConnectionParameters(hal::ConnectionHandle connection,
+                                hal::ConnectionParameters &parameters) const override;
+
+    int setPreferredPhy(hal::ConnectionHandle connection, hal::Phy phy) override;
+
+    hal::Phy getPhy(hal::ConnectionHandle connection) const override;
+
+    void onConnectionUpdated(const hal::Callback<void(hal::ConnectionHandle)> &callback) override;
+
+    int addService(const hal::Uuid &uuid, Characteristic *characteristics, size_t count) override;
+
+    int write(Handle handle, const uint8_t *value, uint16_t length, bool localOnly = false) override;
+
+    int write(hal::ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length) override;
+
+    bool areUpdatesEnabled(hal::ConnectionHandle connection, Handle handle) override;
+
+    uint16_t getAttMtu(hal::ConnectionHandle connection) const override;
+
+    void onDataWritten(
+            const hal::Callback<void(hal::ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) override;
+
+    void onUpdatesChanged(const hal::Callback<void(Handle)> &callback) override;
+
+    void onDataSent(const hal::Callback<void(unsigned)> &callback) override;
+
+    /**
+     * A central connects, the peripheral must be advertising connectable.
+     * @param subscribeAll the central subscribes to every characteristic at once, as if it was bonded
+     * @return connection handle, INVALID_CONNECTION if it could not connect
+     */
+    hal::ConnectionHandle connect(uint16_t attMtu = DEFAULT_ATT_MTU, bool subscribeAll = true);
+
+    void disconnect(hal::ConnectionHandle connection);
+
+    /** The central writes the CCCD of a characteristic, the server is notified from the event queue */
+    void subscribe(hal::ConnectionHandle connection, Handle valueHandle, bool enabled = true);
+
+    /** Handle of the first attribute with the given UUID after the given handle, 0 if there is none */
+    Handle findHandle(const hal::Uuid &uuid, Handle after = 0) const;
+
+    /** Current value of an attribute as the central reads it */
+    const std::vector<uint8_t> *readAttribute(Handle handle);
+
+    /** A central writes a characteristic or a descriptor, the server is notified from the event queue */
+    void clientWrite(hal::ConnectionHandle connection, Handle handle, const uint8_t *value, uint16_t length);
+
+    /** Called for every notification a central receives */
+    void onClientNotification(
+            const hal::Callback<void(hal::ConnectionHandle, Handle, const uint8_t *, uint16_t)> &callback) {
+        clientNotificationCallback = callback;
+    }
+
+    const std::vector<Attribute> &attributes() const {
+        return attributeTable;
+    }
+
+    /** Payload a scanner receives now, empty if not advertising */
+    const hal::AdvertisingData *scan() const {
+        return advertising ? &advertisingData : nullptr;
+    }
+
+    /** Statistics, advertising events are counted up to the current time */
+    Stats stats() const;
+
+    static const hal::ConnectionHandle INVALID_CONNECTION = 0xFFFF;
+
+private:
+    struct Connection {
+        hal::ConnectionHandle handle;
+        uint16_t attMtu;
+        unsigned txPending;
+        /** Value handles of the characteristics with notifications enabled */
+        std::vector<Handle> subscriptions;
+        hal::ConnectionParameters parameters;
+        hal::Phy phy;
+        /** A parameter update is in progress, the stack refuses another one */
+        bool updating;
+    };
+
+    void connectionEvent(hal::ConnectionHandle connection);
+
+    /** The update requested earlier takes effect */
+    void completeUpdate(hal::ConnectionHandle connection, hal::ConnectionParameters parameters);
+
+    void completePhyUpdate(hal::ConnectionHandle connection, hal::Phy phy);
+
+    static uint32_t intervalMs(const Connection &connection) {
+        return connection.parameters.maxInterval * 5u / 4;
+    }
+
+    /** Notifies one connection if it is subscribed */
+    int notify(Connection &connection, const Attribute &attribute, const uint8_t *value, uint16_t length);
+
+    Attribute *findAttribute(Handle handle);
+
+    Connection *findConnection(hal::ConnectionHandle handle);
+
+    const Connection *findConnection(hal::ConnectionHandle handle) const;
+
+    hal::EventQueue &eventQueue;
+    bool initialized = false;
+    bool advertising = false;
+    bool advertisingConnectable = false;
+    uint16_t advertisingIntervalMs = 0;
+    uint64_t advertisingSinceMs = 0;
+    std::vector<Connection> connections;
+    hal::ConnectionHandle lastConnection = 0;
+    hal::AdvertisingData advertisingData;
+    hal::AdvertisingData scanResponse;
+    hal::Callback<void(hal::ConnectionHandle)> connectionCallback;
+    hal::Callback<void(hal::ConnectionHandle)> disconnectionCallback;
+    hal::Callback<void(hal::ConnectionHandle)> connectionUpdatedCallback;
+    hal::Callback<void(hal::ConnectionHandle, Handle, const uint8_t *, uint16_t)> dataWrittenCallback;
+    hal::Callback<void(Handle)> updatesChangedCallback;
+    hal::Callback<void(unsigned)> dataSentCallback;
+    hal::Callback<void(hal::ConnectionHandle, Handle, const uint8_t *, uint16_t)> clientNotificationCallback;
+    std::vector<Attribute> attributeTable;
+    Handle lastHandle = 0;
+    Stats statistics;
+};
+
+#endif
+
+#endif // SIMULATED_BLE_H
@@ -0,0 +1,195 @@
+#ifdef HAL_NATIVE
+
+#include "SimulatedBme280.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+enum Register : uint8_t {
+    CALIB_T_P = 0x88,
+    CALIB_H1 = 0xA1,
+    CHIP_ID = 0xD0,
+    RESET = 0xE0,
+    CALIB_H2 = 0xE1,
+    CTRL_HUM = 0xF2,
+    STATUS = 0xF3,
+    CTRL_MEAS = 0xF4,
+    CONFIG = 0xF5,
+    PRESS_MSB = 0xF7,
+    TEMP_MSB = 0xFA,
+    HUM_MSB = 0xFD,
+};
+
+const uint8_t STATUS_MEASURING = 0x08;
+
+// dig_T1..dig_T3, dig_P1..dig_P9 from the datasheet compensation example
+const uint16_t calibrationTP[12] = {27504, 26435, (uint16_t) -1000, 36477, (uint16_t) -10685, 3024,
+                                    2855, 140, (uint16_t) -7, 15500, (uint16_t) -14600, 6000};
+
+// dig_H1 = 75, dig_H2 = 362, dig_H3 = 0, dig_H4 = 313, dig_H5 = 50, dig_H6 = 30
+const uint8_t calibrationH1 = 75;
+const uint8_t calibrationH2[7] = {0x6A, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1E};
+
+const double pi = 3.14159265358979323846;
+
+uint32_t oversampling(uint8_t setting) {
+    setting &= 0x07;
+    return setting == 0 ? 0 : 1u << (std::min<uint8_t>(setting, 5) - 1);
+}
+
+}
+
+SimulatedBme280::SimulatedBme280(hal::EventQueue &eventQueue, int address, unsigned seed)
+        : eventQueue(eventQueue), address(address), random(seed) {
+    for (int i = 0; i < 12; ++i) {
+        registers[CALIB_T_P + 2 * i] = uint8_t(calibrationTP[i]);
+        registers[CALIB_T_P + 2 * i + 1] = uint8_t(calibrationTP[i] >> 8);
+    }
+    registers[CALIB_H1] = calibrationH1;
+    for (int i = 0; i < 7; ++i) {
+        registers[CALIB_H2 + i] = calibrationH2[i];
+    }
+    registers[CHIP_ID] = 0x60;
+    registers[PRESS_MSB] = registers[TEMP_MSB] = registers[HUM_MSB] = 0x80;
+}
+
+int SimulatedBme280::write(int address, const char *data, int length, bool) {
+    if (address != this->address) {
+        return -1;
+    }
+    ++statistics.transactions;
+    statistics.bytes += length;
+    update();
+
+    // Register address and value pairs, a trailing register address only moves the pointer
+    int i = 0;
+    for (; i + 1 < length; i += 2) {
+        writeRegister(uint8_t(data[i]), uint8_t(data[i + 1]));
+    }
+    if (i < length) {
+        pointer = uint8_t(data[i]);
+    }
+    return 0;
+}
+
+int SimulatedBme280::read(int address, char *data, int length, bool) {
+    if (address != this->address) {
+        return -1;
+    }
+    ++statistics.transactions;
+    statistics.bytes += length;
+    update();
+
+    for (int i = 0; i < length; ++i) {
+        data[i] = char(registers[pointer++]);
+    }
+    return 0;
+}
+
+int SimulatedBme280::transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                              const hal::Callback<void(int)> &callback) {
+    int result = 0;
+    if (txLength > 0) {
+        result = write(address, txBuffer, txLength, rxLength > 0);
+    }
+    if (result == 0 && rxLength > 0) {
+        result = read(address, rxBuffer, rxLength);
+    }
+    // Completion interrupt fires after the current handler returns
+    eventQueue.call(callback, result == 0 ? EVENT_COMPLETE : EVENT_ERROR);
+    return 0;
+}
+
+void SimulatedBme280::writeRegister(uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case RESET:
+            if (value == 0xB6) {
+                registers[CTRL_HUM] = registers[CTRL_MEAS] = registers[CONFIG] = 0;
+                converting = false;
+            }
+            break;
+        case CTRL_HUM:
+            registers[CTRL_HUM] = value & 0x07;
+            break;
+        case CTRL_MEAS:
+            registers[CTRL_MEAS] = value;
+            if ((value & 0x03) == 0x01 || (value & 0x03) == 0x02) {
+                startConversion();
+            } else if ((value & 0x03) == 0x03) {
+                nextNormalConversionMs = hal::uptimeMs();
+            }
+            break;
+        case CONFIG:
+            registers[CONFIG] = value & 0xFD;
+            break;
+        default:
+            break;
+    }
+}
+
+void SimulatedBme280::update() {
+    const uint64_t now = hal::uptimeMs();
+    if (converting && now >= conversionEndMs) {
+        converting = false;
+        latchSample();
+        if ((registers[CTRL_MEAS] & 0x03) != 0x03) {
+            registers[CTRL_MEAS] &= 0xFC;   // forced mode returns to sleep
+        }
+    }
+    if ((registers[CTRL_MEAS] & 0x03) == 0x03 && !converting && now >= nextNormalConversionMs) {
+        static const uint32_t standbyMs[8] = {1, 63, 125, 250, 500, 1000, 10, 20};
+        startConversion();
+        nextNormalConversionMs = conversionEndMs + standbyMs[registers[CONFIG] >> 5];
+    }
+    registers[STATUS] = converting ? STATUS_MEASURING : 0;
+}
+
+void SimulatedBme280::startConversion() {
+    converting = true;
+    conversionEndMs = hal::uptimeMs() + conversionTimeMs();
+    registers[STATUS] = STATUS_MEASURING;
+}
+
+uint32_t SimulatedBme280::conversionTimeMs() const {
+    const uint32_t temperature = oversampling(registers[CTRL_MEAS] >> 5);
+    const uint32_t pressure = oversampling(registers[CTRL_MEAS] >> 2);
+    const uint32_t humidity = oversampling(registers[CTRL_HUM]);
+    uint32_t timeUs = 1250;
+    timeUs += temperature ? 2300 * temperature : 0;
+    timeUs += pressure ? 2300 * pressure + 575 : 0;
+    timeUs += humidity ? 2300 * humidity + 575 : 0;
+    return (timeUs + 999) / 1000;
+}
+
+void SimulatedBme280::latchSample() {
+    ++statistics.conversions;
+
+    const double hours = hal::uptimeMs() / 3600000.0;
+    std::uniform_int_distribution<int32_t> noise(-16, 16);
+
+    // 25 C and 1006.5 hPa at the datasheet example point, around 45 %RH
+    const int32_t temperature = int32_t(519888 + 6000 * std::sin(2 * pi * hours / 24)) + noise(random);
+    const int32_t pressure = int32_t(415148 + 3000 * std::sin(2 * pi * hours / 30)) + noise(random);
+    const int32_t humidity = int32_t(0x6C00 + 1500 * std::sin(2 * pi * hours / 9)) + noise(random);
+
+    const bool temperatureEnabled = (registers[CTRL_MEAS] >> 5) != 0;
+    const bool pressureEnabled = ((registers[CTRL_MEAS] >> 2) & 0x07) != 0;
+    const bool humidityEnabled = registers[CTRL_HUM] != 0;
+
+    const uint32_t pressureRaw = pressureEnabled ? uint32_t(pressure) : 0x80000;
+    const uint32_t temperatureRaw = temperatureEnabled ? uint32_t(temperature) : 0x80000;
+    const uint32_t humidityRaw = humidityEnabled ? uint32_t(humidity) : 0x8000;
+
+    registers[PRESS_MSB] = uint8_t(pressureRaw >> 12);
+    registers[PRESS_MSB + 1] = uint8_t(pressureRaw >> 4);
+    registers[PRESS_MSB + 2] = uint8_t(pressureRaw << 4);
+    registers[TEMP_MSB] = uint8_t(temperatureRaw >> 12);
+    registers[TEMP_MSB + 1] = uint8_t(temperatureRaw >> 4);
+    registers[TEMP_MSB + 2] = uint8_t(temperatureRaw << 4);
+    registers[HUM_MSB] = uint8_t(humidityRaw >> 8);
+    registers[HUM_MSB + 1] = uint8_t(humidityRaw);
+}
+
+#endif
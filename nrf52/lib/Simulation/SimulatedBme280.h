@@ -0,0 +1,66 @@
+#ifndef SIMULATED_BME280_H
+#define SIMULATED_BME280_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+#include <random>
+
+#include <Hal.h>
+
+/**
+ * I2C bus with a single BME280 behind it. The register file follows the datasheet: calibration
+ * data are the datasheet example values, forced and normal modes convert with the datasheet
+ * worst-case timing, skipped channels read as 0x80000. Raw values follow slow daily and
+ * weather-like drifts with a little noise.
+ */
+class SimulatedBme280 : public hal::I2C {
+public:
+    struct Stats {
+        uint64_t transactions = 0;
+        uint64_t bytes = 0;
+        uint64_t conversions = 0;
+    };
+
+    explicit SimulatedBme280(hal::EventQueue &eventQueue, int address = 0x76 << 1, unsigned seed = 1);
+
+    int write(int address, const char *data, int length, bool repeated = false) override;
+
+    int read(int address, char *data, int length, bool repeated = false) override;
+
+    int transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const hal::Callback<void(int)> &callback) override;
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+    int getAddress() const {
+        return address;
+    }
+
+private:
+    void writeRegister(uint8_t reg, uint8_t value);
+
+    void update();
+
+    void startConversion();
+
+    void latchSample();
+
+    uint32_t conversionTimeMs() const;
+
+    hal::EventQueue &eventQueue;
+    const int address;
+    std::minstd_rand random;
+    uint8_t registers[256]{0};
+    uint8_t pointer = 0;
+    bool converting = false;
+    uint64_t conversionEndMs = 0;
+    uint64_t nextNormalConversionMs = 0;
+    Stats statistics;
+};
+
+#endif
+
+#endif // SIMULATED_BME280_H
@@ -0,0 +1,51 @@
+#ifdef HAL_NATIVE
+
+#include "SimulatedBme280Spi.h"
+
+#include <algorithm>
+
+namespace {
+
+const uint8_t READ = 0x80;
+
+}
+
+SimulatedBme280Spi::SimulatedBme280Spi(hal::EventQueue &eventQueue, SimulatedBme280 &sensor, uint32_t clockHz)
+        : eventQueue(eventQueue), sensor(sensor), clockHz(clockHz) {}
+
+int SimulatedBme280Spi::write(const char *txBuffer, int txLength, char *rxBuffer, int rxLength) {
+    const int length = std::max(txLength, rxLength);
+    ++statistics.transactions;
+    statistics.bytes += length;
+    statistics.busyNs += uint64_t(length) * 8 * 1000000000 / clockHz;
+    if (txLength < 1) {
+        return -1;
+    }
+
+    const int address = sensor.getAddress();
+    if (uint8_t(txBuffer[0]) & READ) {
+        // The register data follow the command byte, the auto-incremented reads need no more commands
+        if (rxLength > 0) {
+            rxBuffer[0] = char(0xFF);
+        }
+        return sensor.write(address, txBuffer, 1) == 0
+               && (rxLength <= 1 || sensor.read(address, rxBuffer + 1, rxLength - 1) == 0) ? 0 : -1;
+    }
+    for (int i = 0; i + 1 < txLength; i += 2) {
+        const char pair[2] = {char(uint8_t(txBuffer[i]) | READ), txBuffer[i + 1]};
+        if (sensor.write(address, pair, 2) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int SimulatedBme280Spi::transfer(const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                                 const hal::Callback<void(int)> &callback) {
+    int result = write(txBuffer, txLength, rxBuffer, rxLength);
+    // Completion interrupt fires after the current handler returns
+    eventQueue.call(callback, result == 0 ? EVENT_COMPLETE : EVENT_ERROR);
+    return 0;
+}
+
+#endif
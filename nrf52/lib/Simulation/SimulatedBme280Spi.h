@@ -0,0 +1,49 @@
+#ifndef SIMULATED_BME280_SPI_H
+#define SIMULATED_BME280_SPI_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+
+#include <Hal.h>
+
+#include "SimulatedBme280.h"
+
+/**
+ * SPI port of a SimulatedBme280, the sensor behind the chip select. Commands are decoded as in the datasheet
+ * (section 6.3): bit 7 of the first byte selects a read of the registers from that address on, otherwise
+ * the bytes are register and value pairs with bit 7 of the addresses cleared. The register file is the one
+ * of the I2C side. The byte received during a read command is 0xFF.
+ *
+ * transfer() completes after the current handler, the bytes take microseconds at the clock rate.
+ */
+class SimulatedBme280Spi : public hal::Spi {
+public:
+    struct Stats {
+        uint64_t transactions = 0;
+        uint64_t bytes = 0;
+        uint64_t busyNs = 0;
+    };
+
+    /** The sensor must outlive the port */
+    SimulatedBme280Spi(hal::EventQueue &eventQueue, SimulatedBme280 &sensor, uint32_t clockHz = 8000000);
+
+    int write(const char *txBuffer, int txLength, char *rxBuffer, int rxLength) override;
+
+    int transfer(const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const hal::Callback<void(int)> &callback) override;
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    hal::EventQueue &eventQueue;
+    SimulatedBme280 &sensor;
+    const uint32_t clockHz;
+    Stats statistics;
+};
+
+#endif
+
+#endif // SIMULATED_BME280_SPI_H
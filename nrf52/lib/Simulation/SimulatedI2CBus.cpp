@@ -0,0 +1,75 @@
+#ifdef HAL_NATIVE
+
+#include "SimulatedI2CBus.h"
+
+#include <algorithm>
+
+const uint32_t SimulatedI2CBus::BITS_PER_BYTE;
+const uint32_t SimulatedI2CBus::CLOCK_HZ;
+
+SimulatedI2CBus::SimulatedI2CBus(hal::EventQueue &eventQueue) : eventQueue(eventQueue) {}
+
+void SimulatedI2CBus::attach(hal::I2C &device) {
+    devices.push_back(&device);
+}
+
+int SimulatedI2CBus::write(int address, const char *data, int length, bool repeated) {
+    if (busy) {
+        ++statistics.collisions;
+        return -1;
+    }
+    for (hal::I2C *device : devices) {
+        if (device->write(address, data, length, repeated) == 0) {
+            statistics.bytes += length + 1;
+            return 0;
+        }
+    }
+    ++statistics.nacks;
+    return -1;
+}
+
+int SimulatedI2CBus::read(int address, char *data, int length, bool repeated) {
+    if (busy) {
+        ++statistics.collisions;
+        return -1;
+    }
+    for (hal::I2C *device : devices) {
+        if (device->read(address, data, length, repeated) == 0) {
+            statistics.bytes += length + 1;
+            return 0;
+        }
+    }
+    ++statistics.nacks;
+    return -1;
+}
+
+int SimulatedI2CBus::transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                              const hal::Callback<void(int)> &callback) {
+    if (busy) {
+        ++statistics.collisions;
+        return -1;
+    }
+    // Bytes move at once, the completion comes when they would have been clocked out
+    int result = 0;
+    if (txLength > 0) {
+        result = write(address, txBuffer, txLength, rxLength > 0);
+    }
+    if (result == 0 && rxLength > 0) {
+        result = read(address, rxBuffer, rxLength);
+    }
+    ++statistics.transfers;
+    busy = true;
+    const uint32_t bytes = uint32_t(txLength + rxLength) + (txLength > 0) + (rxLength > 0);
+    const uint32_t durationUs = bytes * BITS_PER_BYTE * 1000000 / CLOCK_HZ;
+    statistics.busyUs += durationUs;
+    eventQueue.call_in(int(std::max<uint32_t>(1, (durationUs + 999) / 1000)), this, &SimulatedI2CBus::complete,
+                       callback, result == 0 ? EVENT_COMPLETE : EVENT_ERROR);
+    return 0;
+}
+
+void SimulatedI2CBus::complete(hal::Callback<void(int)> callback, int event) {
+    busy = false;
+    callback(event);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SIMULATED_I2C_BUS_H
+#define SIMULATED_I2C_BUS_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+#include <vector>
+
+#include <Hal.h>
+
+/**
+ * I2C peripheral with several devices on its bus, e.g. SimulatedBme280s at different addresses.
+ * A device that does not answer to the address refuses the call, the first one that does takes it.
+ *
+ * transfer() keeps the bus busy for the time the bytes take at 100 kHz, at least a millisecond,
+ * and completes after it. Like the nRF52 TWI, it refuses another transfer and blocking calls meanwhile.
+ */
+class SimulatedI2CBus : public hal::I2C {
+public:
+    /** Clock cycles per byte: 8 data bits and the acknowledge */
+    static const uint32_t BITS_PER_BYTE = 9;
+    static const uint32_t CLOCK_HZ = 100000;
+
+    struct Stats {
+        uint64_t transfers = 0;
+        uint64_t bytes = 0;
+        /** Calls refused because a transfer was running */
+        uint64_t collisions = 0;
+        /** Calls no device answered */
+        uint64_t nacks = 0;
+        uint64_t busyUs = 0;
+    };
+
+    explicit SimulatedI2CBus(hal::EventQueue &eventQueue);
+
+    /** The device must outlive the bus */
+    void attach(hal::I2C &device);
+
+    int write(int address, const char *data, int length, bool repeated = false) override;
+
+    int read(int address, char *data, int length, bool repeated = false) override;
+
+    int transfer(int address, const char *txBuffer, int txLength, char *rxBuffer, int rxLength,
+                 const hal::Callback<void(int)> &callback) override;
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    void complete(hal::Callback<void(int)> callback, int event);
+
+    hal::EventQueue &eventQueue;
+    std::vector<hal::I2C *> devices;
+    bool busy = false;
+    Stats statistics;
+};
+
+#endif
+
+#endif // SIMULATED_I2C_BUS_H
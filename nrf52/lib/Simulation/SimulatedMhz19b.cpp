@@ -0,0 +1,139 @@
+#ifdef HAL_NATIVE
+
+#include "SimulatedMhz19b.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+uint8_t checksum(const uint8_t *frame) {
+    uint8_t result = 0;
+    for (int i = 1; i < 8; ++i) {
+        result += frame[i];
+    }
+    return 0xFF - result + 1;
+}
+
+}
+
+SimulatedMhz19b::SimulatedMhz19b(hal::EventQueue &eventQueue, bool coldStart, unsigned seed)
+        : eventQueue(eventQueue), coldStart(coldStart), random(seed) {}
+
+bool SimulatedMhz19b::writeable() {
+    return writeEvent == 0;
+}
+
+int SimulatedMhz19b::transferTimeMs(int length) {
+    return (length * 10 * 1000 + 9599) / 9600;
+}
+
+int SimulatedMhz19b::write(const uint8_t *buffer, int length, const hal::Callback<void(int)> &callback) {
+    if (writeEvent != 0 || !enabled) {
+        return -1;
+    }
+    if (length == 9 && buffer[0] == 0xFF && buffer[2] == 0x86 && checksum(buffer) == buffer[8]) {
+        ++statistics.requests;
+        eventQueue.call_in(transferTimeMs(length) + 2, this, &SimulatedMhz19b::respond);
+    }
+    writeEvent = eventQueue.call_in(transferTimeMs(length), [this, callback]() {
+        writeEvent = 0;
+        callback(EVENT_TX_COMPLETE);
+    });
+    return 0;
+}
+
+void SimulatedMhz19b::abortWrite() {
+    if (writeEvent != 0) {
+        eventQueue.cancel(writeEvent);
+        writeEvent = 0;
+    }
+}
+
+void SimulatedMhz19b::setReceiveHandler(const hal::Callback<void(uint8_t)> &handler) {
+    receiveHandler = handler;
+}
+
+void SimulatedMhz19b::setEnabled(bool enabled) {
+    if (enabled == this->enabled) {
+        return;
+    }
+    this->enabled = enabled;
+    if (enabled) {
+        enabledSinceMs = hal::uptimeMs();
+    } else {
+        statistics.enabledMs += hal::uptimeMs() - enabledSinceMs;
+    }
+}
+
+SimulatedMhz19b::Stats SimulatedMhz19b::stats() const {
+    Stats result = statistics;
+    if (enabled) {
+        result.enabledMs += hal::uptimeMs() - enabledSinceMs;
+    }
+    return result;
+}
+
+void SimulatedMhz19b::respond() {
+    const uint16_t value = co2ppm();
+    uint8_t frame[12] = {0xFF, 0x86, uint8_t(value >> 8), uint8_t(value), 0x47, 0x00, 0x00, 0x00, 0x00};
+    frame[8] = checksum(frame);
+    int length = 9;
+
+    std::uniform_real_distribution<double> chance(0, 1);
+    if (chance(random) < faultRate) {
+        ++statistics.faults;
+        std::uniform_int_distribution<int> pick(0, 8);
+        switch (pick(random) % 4) {
+            case 0: // no response
+                return;
+            case 1: // noise before the frame, with a false start among it
+                memmove(&frame[3], frame, 9);
+                frame[0] = 0x5A;
+                frame[1] = 0xFF;
+                frame[2] = 0x00;
+                length = 12;
+                break;
+            case 2: { // a byte is lost
+                int lost = pick(random);
+                memmove(&frame[lost], &frame[lost + 1], size_t(8 - lost));
+                length = 8;
+                break;
+            }
+            default: // a bit flips
+                frame[pick(random)] ^= 0x10;
+                break;
+        }
+    }
+    ++statistics.responses;
+    eventQueue.call_in(transferTimeMs(length), [this, frame, length]() {
+        receive(frame, length);
+    });
+}
+
+void SimulatedMhz19b::receive(const uint8_t *bytes, int length) {
+    for (int i = 0; i < length; ++i) {
+        if (!enabled || !receiveHandler) {
+            ++statistics.lostBytes;
+            continue;
+        }
+        receiveHandler(bytes[i]);
+    }
+}
+
+uint16_t SimulatedMhz19b::co2ppm() {
+    const uint64_t now = hal::uptimeMs();
+    if (coldStart && now < 10000) {
+        return 429;
+    }
+    if (coldStart && now < 90000) {
+        return 410;
+    }
+    const double hours = now / 3600000.0;
+    std::uniform_int_distribution<int> noise(-5, 5);
+    return uint16_t(700 + 250 * std::sin(2 * pi * hours / 24) + noise(random));
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SIMULATED_MHZ19B_H
+#define SIMULATED_MHZ19B_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdint>
+#include <random>
+
+#include <Hal.h>
+
+/**
+ * UART with an MH-Z19B behind it, 9600 baud. Answers the "read CO2" command with a 9-byte frame,
+ * reports 429 and then 410 ppm during the warm-up after a cold start like the real sensor.
+ * Bytes that arrive while the UART is disabled are lost.
+ *
+ * With a fault rate set, some responses get garbage in front, lose or corrupt a byte, or do not come at all.
+ */
+class SimulatedMhz19b : public hal::Serial {
+public:
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t responses = 0;
+        uint64_t lostBytes = 0;
+        uint64_t faults = 0;
+        /** Time the UART was enabled */
+        uint64_t enabledMs = 0;
+    };
+
+    /**
+     * @param coldStart whether the sensor is powered up together with the firmware
+     */
+    SimulatedMhz19b(hal::EventQueue &eventQueue, bool coldStart = true, unsigned seed = 1);
+
+    bool writeable() override;
+
+    int write(const uint8_t *buffer, int length, const hal::Callback<void(int)> &callback) override;
+
+    void abortWrite() override;
+
+    void setReceiveHandler(const hal::Callback<void(uint8_t)> &handler) override;
+
+    void setEnabled(bool enabled) override;
+
+    /** @param probability of a fault per response */
+    void setFaultRate(double probability) {
+        faultRate = probability;
+    }
+
+    Stats stats() const;
+
+private:
+    /** Time to transfer length bytes at 9600 baud 8N1, rounded up */
+    static int transferTimeMs(int length);
+
+    void respond();
+
+    /** Bytes reach the handler together, the way the driver drains them from its DMA buffer */
+    void receive(const uint8_t *bytes, int length);
+
+    uint16_t co2ppm();
+
+    hal::EventQueue &eventQueue;
+    const bool coldStart;
+    std::minstd_rand random;
+    int writeEvent = 0;
+    hal::Callback<void(uint8_t)> receiveHandler;
+    double faultRate = 0;
+    bool enabled = true;
+    uint64_t enabledSinceMs = 0;
+    Stats statistics;
+};
+
+#endif
+
+#endif // SIMULATED_MHZ19B_H
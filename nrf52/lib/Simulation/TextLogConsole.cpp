@@ -0,0 +1,77 @@
+#ifdef HAL_NATIVE
+
+#include "TextLogConsole.h"
+
+#include <cstdlib>
+
+namespace {
+
+const char *const formats[] = {
+#define LOG_MESSAGE_FORMAT(name, format) format,
+        LOG_MESSAGES(LOG_MESSAGE_FORMAT)
+#undef LOG_MESSAGE_FORMAT
+};
+
+}
+
+TextLogConsole::TextLogConsole(hal::EventQueue &eventQueue, std::ostream &text, FILE *binary)
+        : text(text), binary(binary) {
+    eventQueue.setIdleHandler([this]() {
+        drain();
+    });
+}
+
+std::string TextLogConsole::format(const Log::Entry &entry) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "[%u.%03u] ", entry.timeMs / 1000, entry.timeMs % 1000);
+    std::string line = buffer;
+    if (entry.id >= uint16_t(LogMessage::COUNT)) {
+        snprintf(buffer, sizeof(buffer), "unknown message %u", entry.id);
+        return line + buffer;
+    }
+
+    int arg = 0;
+    for (const char *c = formats[entry.id]; *c != '\0'; ++c) {
+        if (*c != '%' || c[1] == '\0') {
+            line += *c;
+            continue;
+        }
+        char conversion = *++c;
+        if (conversion == '%') {
+            line += '%';
+            continue;
+        }
+        int32_t value = arg < entry.argCount ? entry.args[arg] : 0;
+        ++arg;
+        switch (conversion) {
+            case 'u':
+                snprintf(buffer, sizeof(buffer), "%u", uint32_t(value));
+                break;
+            case 'x':
+                snprintf(buffer, sizeof(buffer), "%x", uint32_t(value));
+                break;
+            case 'F':
+                snprintf(buffer, sizeof(buffer), "%s%d.%02d", value < 0 ? "-" : "", abs(value / 100),
+                         abs(value % 100));
+                break;
+            default:
+                snprintf(buffer, sizeof(buffer), "%d", value);
+                break;
+        }
+        line += buffer;
+    }
+    return line;
+}
+
+void TextLogConsole::drain() {
+    Log::Entry entry{};
+    while (Log::pop(entry)) {
+        text << format(entry) << '\n';
+        if (binary != nullptr) {
+            uint8_t frame[Log::MAX_FRAME_LENGTH];
+            fwrite(frame, 1, Log::encode(entry, frame), binary);
+        }
+    }
+}
+
+#endif
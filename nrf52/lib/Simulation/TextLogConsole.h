@@ -0,0 +1,37 @@
+#ifndef TEXT_LOG_CONSOLE_H
+#define TEXT_LOG_CONSOLE_H
+
+#ifdef HAL_NATIVE
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+#include <Hal.h>
+#include <Log.h>
+
+/**
+ * Drains the log whenever the event queue goes idle, like LogConsole does on the device. Entries are
+ * printed as text with the formats of LogMessages.h; the binary frames can also be written to a file
+ * to try tools/logdecode.py on.
+ */
+class TextLogConsole {
+public:
+    /**
+     * @param binary file for the frames, may be null
+     */
+    TextLogConsole(hal::EventQueue &eventQueue, std::ostream &text, FILE *binary = nullptr);
+
+    /** Entry as a line of text, without the line end */
+    static std::string format(const Log::Entry &entry);
+
+private:
+    void drain();
+
+    std::ostream &text;
+    FILE *binary;
+};
+
+#endif
+
+#endif // TEXT_LOG_CONSOLE_H
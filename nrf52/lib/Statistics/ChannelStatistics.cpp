@@ -0,0 +1,66 @@
+#include <cmath>
+
+#include "ChannelStatistics.h"
+
+const size_t ChannelStatistics::WINDOWS;
+const uint32_t ChannelStatistics::WINDOW_MS[WINDOWS] = {5 * 60 * 1000, 60 * 60 * 1000, 24 * 60 * 60 * 1000};
+const size_t ChannelStatistics::PERCENTILES;
+const float ChannelStatistics::PERCENTILE_QUANTILES[PERCENTILES] = {0.1f, 0.5f, 0.9f};
+
+ChannelStatistics::ChannelStatistics()
+        : windows{RollingWindow{WINDOW_MS[0]}, RollingWindow{WINDOW_MS[1]}, RollingWindow{WINDOW_MS[2]}},
+          sketches{
+                  {0, {QuantileEstimator{PERCENTILE_QUANTILES[0]}, QuantileEstimator{PERCENTILE_QUANTILES[1]},
+                       QuantileEstimator{PERCENTILE_QUANTILES[2]}}},
+                  {0, {QuantileEstimator{PERCENTILE_QUANTILES[0]}, QuantileEstimator{PERCENTILE_QUANTILES[1]},
+                       QuantileEstimator{PERCENTILE_QUANTILES[2]}}},
+          } {}
+
+void ChannelStatistics::add(uint64_t nowMs, int32_t value) {
+    for (RollingWindow &window : windows) {
+        window.add(nowMs, value);
+    }
+
+    const uint32_t sketchMs = WINDOW_MS[WINDOWS - 1];
+    if (!started) {
+        started = true;
+        average = float(value);
+        sketches[0].startMs = nowMs;
+        sketches[1].startMs = nowMs + sketchMs / 2;
+    } else {
+        average += (float(value) - average) * (1 - std::exp(-float(nowMs - lastMs) / EMA_TIME_CONSTANT_MS));
+    }
+    lastMs = nowMs;
+
+    for (Sketch &sketch : sketches) {
+        if (nowMs < sketch.startMs) {
+            continue;
+        }
+        if (nowMs - sketch.startMs >= sketchMs) {
+            sketch.startMs += (nowMs - sketch.startMs) / sketchMs * sketchMs;
+            for (QuantileEstimator &estimator : sketch.estimators) {
+                estimator.reset();
+            }
+        }
+        for (QuantileEstimator &estimator : sketch.estimators) {
+            estimator.add(float(value));
+        }
+    }
+}
+
+ChannelStatistics::Summary ChannelStatistics::summary(uint64_t nowMs) {
+    Summary summary{};
+    for (size_t i = 0; i < WINDOWS; ++i) {
+        summary.windows[i] = windows[i].summary(nowMs);
+    }
+    if (!started) {
+        return summary;
+    }
+    summary.average = int32_t(std::lround(average));
+    // The sketch that started first has seen more samples, a restart makes it the younger one
+    const Sketch &older = sketches[0].startMs <= sketches[1].startMs ? sketches[0] : sketches[1];
+    for (size_t i = 0; i < PERCENTILES; ++i) {
+        summary.percentiles[i] = int32_t(std::lround(older.estimators[i].value()));
+    }
+    return summary;
+}
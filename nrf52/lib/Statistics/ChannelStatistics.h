@@ -0,0 +1,57 @@
+#ifndef CHANNEL_STATISTICS_H
+#define CHANNEL_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "QuantileEstimator.h"
+#include "RollingWindow.h"
+
+/**
+ * @class ChannelStatistics
+ * @brief Streaming aggregates of one reading: rolling windows, an exponential moving average and percentiles.
+ *
+ * Every sample updates all of them at a constant cost, nothing is recomputed from the history.
+ * The moving average weighs samples by time, so it means the same at the fast and the slow
+ * measurement period. Percentiles come from two sets of P² estimators that restart every
+ * half of the longest window in turns, the older one is reported: it covers 12 to 24 hours.
+ */
+class ChannelStatistics {
+public:
+    static const size_t WINDOWS = 3;
+    /** 5 minutes, 1 hour, 24 hours */
+    static const uint32_t WINDOW_MS[WINDOWS];
+    static const uint32_t EMA_TIME_CONSTANT_MS = 5 * 60 * 1000;
+
+    static const size_t PERCENTILES = 3;
+    /** 10th, 50th and 90th */
+    static const float PERCENTILE_QUANTILES[PERCENTILES];
+
+    struct Summary {
+        RollingWindow::Summary windows[WINDOWS];
+        /** Zero for all values if there are no samples */
+        int32_t average;
+        int32_t percentiles[PERCENTILES];
+    };
+
+    ChannelStatistics();
+
+    void add(uint64_t nowMs, int32_t value);
+
+    /** nowMs must not go back */
+    Summary summary(uint64_t nowMs);
+
+private:
+    struct Sketch {
+        uint64_t startMs;
+        QuantileEstimator estimators[PERCENTILES];
+    };
+
+    RollingWindow windows[WINDOWS];
+    bool started = false;
+    float average = 0;
+    uint64_t lastMs = 0;
+    Sketch sketches[2];
+};
+
+#endif // CHANNEL_STATISTICS_H
@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "QuantileEstimator.h"
+
+const int QuantileEstimator::MARKERS;
+
+QuantileEstimator::QuantileEstimator(float quantile) : quantile(quantile) {}
+
+void QuantileEstimator::add(float value) {
+    if (count < MARKERS) {
+        heights[count++] = value;
+        if (count == MARKERS) {
+            std::sort(heights, heights + MARKERS);
+            const float p = quantile;
+            for (int i = 0; i < MARKERS; ++i) {
+                positions[i] = i;
+            }
+            desired[0] = 0;
+            desired[1] = 2 * p;
+            desired[2] = 4 * p;
+            desired[3] = 2 + 2 * p;
+            desired[4] = 4;
+            increments[0] = 0;
+            increments[1] = p / 2;
+            increments[2] = p;
+            increments[3] = (1 + p) / 2;
+            increments[4] = 1;
+        }
+        return;
+    }
+    ++count;
+
+    // Cell of the sample, the extreme markers follow new extremes
+    int cell;
+    if (value < heights[0]) {
+        heights[0] = value;
+        cell = 0;
+    } else if (value >= heights[MARKERS - 1]) {
+        heights[MARKERS - 1] = value;
+        cell = MARKERS - 2;
+    } else {
+        cell = 0;
+        while (value >= heights[cell + 1]) {
+            ++cell;
+        }
+    }
+    for (int i = cell + 1; i < MARKERS; ++i) {
+        ++positions[i];
+    }
+    for (int i = 0; i < MARKERS; ++i) {
+        desired[i] += increments[i];
+    }
+
+    for (int i = 1; i < MARKERS - 1; ++i) {
+        float offset = desired[i] - float(positions[i]);
+        if ((offset >= 1 && positions[i + 1] - positions[i] > 1)
+            || (offset <= -1 && positions[i - 1] - positions[i] < -1)) {
+            int direction = offset > 0 ? 1 : -1;
+            float height = parabolic(i, direction);
+            if (heights[i - 1] < height && height < heights[i + 1]) {
+                heights[i] = height;
+            } else {
+                heights[i] = linear(i, direction);
+            }
+            positions[i] += direction;
+        }
+    }
+}
+
+float QuantileEstimator::value() const {
+    if (count == 0) {
+        return 0;
+    }
+    if (count < uint32_t(MARKERS)) {
+        float sorted[MARKERS];
+        std::copy(heights, heights + count, sorted);
+        std::sort(sorted, sorted + count);
+        return sorted[size_t(quantile * float(count - 1) + 0.5f)];
+    }
+    return heights[2];
+}
+
+float QuantileEstimator::parabolic(int i, int direction) const {
+    const float d = float(direction);
+    const float below = float(positions[i] - positions[i - 1]);
+    const float above = float(positions[i + 1] - positions[i]);
+    return heights[i] + d / float(positions[i + 1] - positions[i - 1])
+                        * ((below + d) * (heights[i + 1] - heights[i]) / above
+                           + (above - d) * (heights[i] - heights[i - 1]) / below);
+}
+
+float QuantileEstimator::linear(int i, int direction) const {
+    return heights[i] + float(direction) * (heights[i + direction] - heights[i])
+                        / float(positions[i + direction] - positions[i]);
+}
@@ -0,0 +1,49 @@
+#ifndef QUANTILE_ESTIMATOR_H
+#define QUANTILE_ESTIMATOR_H
+
+#include <cstdint>
+
+/**
+ * @class QuantileEstimator
+ * @brief Approximate quantile of a stream in fixed memory, the P² algorithm of Jain and Chlamtac.
+ *
+ * Five markers track the minimum, the quantile, the maximum and two points halfway between.
+ * Every sample moves the marker positions, and a marker that drifts from its desired position by
+ * a sample or more is adjusted with a parabolic, failing that a linear, prediction of its height.
+ * The first five samples are kept as they are and give the exact quantile.
+ */
+class QuantileEstimator {
+public:
+    /** @param quantile between 0 and 1, e.g. 0.5 for the median */
+    explicit QuantileEstimator(float quantile);
+
+    void add(float value);
+
+    /** 0 if there are no samples */
+    float value() const;
+
+    uint32_t getCount() const {
+        return count;
+    }
+
+    void reset() {
+        count = 0;
+    }
+
+private:
+    static const int MARKERS = 5;
+
+    float parabolic(int i, int direction) const;
+
+    float linear(int i, int direction) const;
+
+    float quantile;
+    uint32_t count = 0;
+    /** Marker heights, the estimate is heights[2] */
+    float heights[MARKERS]{};
+    int32_t positions[MARKERS]{};
+    float desired[MARKERS]{};
+    float increments[MARKERS]{};
+};
+
+#endif // QUANTILE_ESTIMATOR_H
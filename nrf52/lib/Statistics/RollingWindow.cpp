@@ -0,0 +1,81 @@
+#include <cmath>
+
+#include "RollingWindow.h"
+
+const size_t RollingWindow::BUCKETS;
+
+RollingWindow::RollingWindow(uint32_t lengthMs) : bucketMs(lengthMs / uint32_t(BUCKETS)) {}
+
+void RollingWindow::add(uint64_t nowMs, int32_t value) {
+    advance(uint32_t(nowMs / bucketMs));
+    Bucket &bucket = buckets[current % BUCKETS];
+    ++bucket.count;
+    bucket.sum += value;
+    bucket.squares += uint64_t(int64_t(value) * value);
+    ++count;
+    sum += value;
+    squares += uint64_t(int64_t(value) * value);
+    minima.push(current, value);
+    maxima.push(current, -value);
+}
+
+RollingWindow::Summary RollingWindow::summary(uint64_t nowMs) {
+    advance(uint32_t(nowMs / bucketMs));
+    if (count == 0) {
+        return Summary{0, 0, 0, 0, 0};
+    }
+    // Sums are exact, doubles keep the difference of the squares precise for 16-bit values
+    double mean = double(sum) / count;
+    double variance = double(squares) / count - mean * mean;
+    return Summary{
+            count,
+            minima.front(),
+            -maxima.front(),
+            int32_t(std::lround(mean)),
+            uint32_t(std::lround(variance > 0 ? std::sqrt(variance) : 0)),
+    };
+}
+
+void RollingWindow::advance(uint32_t bucket) {
+    if (!started) {
+        started = true;
+        current = bucket;
+        buckets[current % BUCKETS] = Bucket{0, 0, 0};
+        return;
+    }
+    if (bucket <= current) {
+        return;
+    }
+    // Buckets skipped while no samples came are empty, at most a window of them needs clearing
+    uint32_t first = bucket - current > BUCKETS ? bucket - uint32_t(BUCKETS) + 1 : current + 1;
+    for (uint32_t number = first; number <= bucket; ++number) {
+        Bucket &slot = buckets[number % BUCKETS];
+        count -= slot.count;
+        sum -= slot.sum;
+        squares -= slot.squares;
+        slot = Bucket{0, 0, 0};
+    }
+    current = bucket;
+    uint32_t oldest = current >= BUCKETS - 1 ? current - uint32_t(BUCKETS - 1) : 0;
+    minima.expire(oldest);
+    maxima.expire(oldest);
+}
+
+void RollingWindow::MonotonicDeque::push(uint32_t bucket, int32_t value) {
+    while (size != 0 && items[(head + size - 1) % BUCKETS].value >= value) {
+        --size;
+    }
+    // A smaller value of the same bucket stays as long as this one would
+    if (size != 0 && items[(head + size - 1) % BUCKETS].bucket == bucket) {
+        return;
+    }
+    items[(head + size) % BUCKETS] = Item{bucket, value};
+    ++size;
+}
+
+void RollingWindow::MonotonicDeque::expire(uint32_t firstBucket) {
+    while (size != 0 && items[head].bucket < firstBucket) {
+        head = (head + 1) % BUCKETS;
+        --size;
+    }
+}
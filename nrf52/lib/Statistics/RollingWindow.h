@@ -0,0 +1,102 @@
+#ifndef ROLLING_WINDOW_H
+#define ROLLING_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+
+/** Steps a window slides in, its memory and its resolution */
+#ifndef STATISTICS_BUCKETS
+#define STATISTICS_BUCKETS 12
+#endif
+
+/**
+ * @class RollingWindow
+ * @brief Minimum, maximum, mean and standard deviation of the samples of a recent period.
+ *
+ * The window is divided into BUCKETS buckets of equal length and slides a bucket at a time, so it covers
+ * between BUCKETS - 1 and BUCKETS bucket lengths of samples. Every bucket keeps the count, the sum and
+ * the sum of squares of its samples, the window keeps their totals: a bucket leaving the window is
+ * subtracted exactly, the totals do not drift.
+ *
+ * Values are 16-bit, like the fields of History::Record.
+ *
+ * Minimum and maximum come from monotonic deques with at most one entry per bucket. A sample drops
+ * the entries it makes irrelevant from the back, entries of buckets that left the window go from the front.
+ * A sample costs O(1) amortized, memory is fixed.
+ */
+class RollingWindow {
+public:
+    static const size_t BUCKETS = STATISTICS_BUCKETS;
+
+    struct Summary {
+        /** Zero for all values if there are no samples */
+        uint32_t count;
+        int32_t min;
+        int32_t max;
+        int32_t mean;
+        uint32_t deviation;
+    };
+
+    /** @param lengthMs a multiple of BUCKETS */
+    explicit RollingWindow(uint32_t lengthMs);
+
+    void add(uint64_t nowMs, int32_t value);
+
+    /** Samples of the window that ends at nowMs, nowMs must not go back */
+    Summary summary(uint64_t nowMs);
+
+    uint32_t getLength() const {
+        return bucketMs * uint32_t(BUCKETS);
+    }
+
+private:
+    /** Sums of 16-bit values fit 32 bits for 32768 samples a bucket */
+    struct Bucket {
+        uint32_t count;
+        int32_t sum;
+        uint64_t squares;
+    };
+
+    /** Ascending values of the buckets in the window, the front is the smallest one */
+    class MonotonicDeque {
+    public:
+        void push(uint32_t bucket, int32_t value);
+
+        /** Drops the entries of buckets before the given one */
+        void expire(uint32_t firstBucket);
+
+        int32_t front() const {
+            return items[head].value;
+        }
+
+        bool empty() const {
+            return size == 0;
+        }
+
+    private:
+        struct Item {
+            uint32_t bucket;
+            int32_t value;
+        };
+
+        Item items[BUCKETS]{};
+        size_t head = 0;
+        size_t size = 0;
+    };
+
+    /** Slides the window so that its last bucket is the given one */
+    void advance(uint32_t bucket);
+
+    const uint32_t bucketMs;
+    Bucket buckets[BUCKETS]{};
+    bool started = false;
+    uint32_t current = 0;
+    uint32_t count = 0;
+    int64_t sum = 0;
+    uint64_t squares = 0;
+    MonotonicDeque minima;
+    /** Negated values, the front is the largest one */
+    MonotonicDeque maxima;
+};
+
+#endif // ROLLING_WINDOW_H
@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include "TimeSeries.h"
+
+namespace timeseries {
+
+namespace {
+
+uint32_t zigZag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t unZigZag(uint32_t value) {
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+size_t putVarint(uint8_t *out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = uint8_t(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = uint8_t(value);
+    return length;
+}
+
+/** @return false if the varint does not end before the end of the data or is longer than 32 bits */
+bool getVarint(const uint8_t *data, size_t length, size_t &position, uint32_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35 && position < length; shift += 7) {
+        uint8_t byte = data[position++];
+        value |= uint32_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+Encoder::Encoder(uint8_t *buffer, size_t capacity) : buffer(buffer), capacity(capacity) {}
+
+void Encoder::begin(uint32_t sequence, uint32_t time) {
+    Header header{sequence, time};
+    memcpy(buffer, &header.sequence, sizeof(header.sequence));
+    memcpy(buffer + 4, &header.time, sizeof(header.time));
+    used = HEADER_LENGTH;
+    samples = 0;
+    previousTime = time;
+    previousDelta = 0;
+    memset(previous, 0, sizeof(previous));
+}
+
+bool Encoder::append(const Sample &sample) {
+    // Encoded aside first: a sample that does not fit leaves the block as it was
+    uint8_t encoded[MAX_SAMPLE_LENGTH];
+    size_t length = 1;
+    uint8_t mask = 0;
+    uint32_t delta = sample.time - previousTime;
+    int32_t deltaOfDelta = int32_t(delta - previousDelta);
+    if (deltaOfDelta != 0) {
+        mask |= 1;
+        length += putVarint(&encoded[length], zigZag(deltaOfDelta));
+    }
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        int16_t change = int16_t(sample.values[i] - previous[i]);
+        if (change != 0) {
+            mask |= uint8_t(2 << i);
+            length += putVarint(&encoded[length], zigZag(change));
+        }
+    }
+    encoded[0] = mask;
+    if (used + length > capacity) {
+        return false;
+    }
+    memcpy(buffer + used, encoded, length);
+    used += length;
+    ++samples;
+    previousTime = sample.time;
+    previousDelta = delta;
+    memcpy(previous, sample.values, sizeof(previous));
+    return true;
+}
+
+bool Decoder::open(const uint8_t *block, size_t blockLength) {
+    if (blockLength < HEADER_LENGTH) {
+        return false;
+    }
+    data = block;
+    length = blockLength;
+    position = HEADER_LENGTH;
+    samples = 0;
+    memcpy(&blockHeader.sequence, block, sizeof(blockHeader.sequence));
+    memcpy(&blockHeader.time, block + 4, sizeof(blockHeader.time));
+    previousTime = blockHeader.time;
+    previousDelta = 0;
+    memset(previous, 0, sizeof(previous));
+    return true;
+}
+
+bool Decoder::next(Sample &sample) {
+    if (position >= length) {
+        return false;
+    }
+    // Decoded aside, the state moves on only with a complete sample
+    size_t at = position;
+    uint8_t mask = data[at++];
+    uint32_t value;
+    uint32_t delta = previousDelta;
+    if (mask & 1) {
+        if (!getVarint(data, length, at, value)) {
+            return false;
+        }
+        delta += uint32_t(unZigZag(value));
+    }
+    uint16_t values[CHANNELS];
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        values[i] = previous[i];
+        if (mask & (2 << i)) {
+            if (!getVarint(data, length, at, value)) {
+                return false;
+            }
+            values[i] = uint16_t(values[i] + unZigZag(value));
+        }
+    }
+    position = at;
+    ++samples;
+    previousDelta = delta;
+    previousTime += delta;
+    memcpy(previous, values, sizeof(previous));
+    sample.time = previousTime;
+    memcpy(sample.values, values, sizeof(values));
+    return true;
+}
+
+}
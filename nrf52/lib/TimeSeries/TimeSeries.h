@@ -0,0 +1,130 @@
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compressed blocks of samples: a time in seconds and CHANNELS 16-bit values, e.g. the temperature,
+ * humidity, pressure and CO2 of History::Record. Samples change slowly, so a block stores differences:
+ *
+ *   uint32 sequence number of the first sample
+ *   uint32 time in seconds the first time delta counts from
+ *   samples, each
+ *     uint8 mask: bit 0 for the time, bit 1 + i for channel i, set if the difference is not zero
+ *     zig-zag varint for every set bit, in the order of the bits:
+ *       time: delta of delta, the change of the time delta to the previous sample, 32-bit
+ *       channels: delta to the value of the previous sample, 16-bit
+ *
+ * A steady sample interval costs no bytes, a value that did not change costs none either, small changes a byte.
+ * Differences wrap around, so any value round-trips, e.g. the unknown-value markers of History::Record.
+ * The block's own length delimits it, e.g. a notification or a length stored before it.
+ *
+ * Every block starts from zero values and a zero time delta, so it decodes on its own: the header finds a block
+ * by sequence number or time without decoding the ones before. Samples of a block have consecutive sequence
+ * numbers. Multi-byte header fields are little-endian.
+ *
+ * Encoder and decoder take fixed memory and no heap, the same code runs on the device and on the host,
+ * see tools/codecbench.cpp.
+ */
+namespace timeseries {
+
+constexpr size_t CHANNELS = 4;
+constexpr size_t HEADER_LENGTH = 8;
+/** Mask, a time and a 16-bit varint per channel */
+constexpr size_t MAX_SAMPLE_LENGTH = 1 + 5 + 3 * CHANNELS;
+
+struct Header {
+    uint32_t sequence;
+    uint32_t time;
+};
+
+struct Sample {
+    uint32_t time;
+    uint16_t values[CHANNELS];
+};
+
+/**
+ * @class Encoder
+ * @brief Writes one block at a time into a buffer of the caller.
+ */
+class Encoder {
+public:
+    /** @param capacity at least HEADER_LENGTH + MAX_SAMPLE_LENGTH, so every sample fits an empty block */
+    Encoder(uint8_t *buffer, size_t capacity);
+
+    /**
+     * Starts a block, the previous one is dropped.
+     * @param time the first sample's time delta counts from it
+     */
+    void begin(uint32_t sequence, uint32_t time);
+
+    /**
+     * Adds the sample with the next sequence number.
+     * @return false if it does not fit, the block is unchanged then
+     */
+    bool append(const Sample &sample);
+
+    /** Bytes of the block, header included */
+    size_t length() const {
+        return used;
+    }
+
+    /** Samples in the block */
+    uint32_t count() const {
+        return samples;
+    }
+
+private:
+    uint8_t *buffer;
+    size_t capacity;
+    size_t used = 0;
+    uint32_t samples = 0;
+    uint32_t previousTime = 0;
+    uint32_t previousDelta = 0;
+    uint16_t previous[CHANNELS]{};
+};
+
+/**
+ * @class Decoder
+ * @brief Reads the samples of a block in place.
+ */
+class Decoder {
+public:
+    /** @return false if the block is shorter than its header */
+    bool open(const uint8_t *block, size_t length);
+
+    const Header &header() const {
+        return blockHeader;
+    }
+
+    /**
+     * Reads the next sample.
+     * @return false at the end of the block or at a truncated sample
+     */
+    bool next(Sample &sample);
+
+    /** The block grew since open(), e.g. an encoder still appends to it */
+    void extend(size_t blockLength) {
+        length = blockLength;
+    }
+
+    /** Sequence number of the sample next() returns */
+    uint32_t sequence() const {
+        return blockHeader.sequence + samples;
+    }
+
+private:
+    const uint8_t *data = nullptr;
+    size_t length = 0;
+    size_t position = 0;
+    uint32_t samples = 0;
+    Header blockHeader{};
+    uint32_t previousTime = 0;
+    uint32_t previousDelta = 0;
+    uint16_t previous[CHANNELS]{};
+};
+
+}
+
+#endif // TIME_SERIES_H
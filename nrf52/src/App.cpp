@@ -0,0 +1,347 @@
+#include "App.h"
+#include "Readings.h"
+
+HAL_RETAINED Retained<App::WarmState, App::WARM_STATE_MAGIC> App::retainedState;
+
+App::App(hal::EventQueue &eventQueue, hal::Ble &bluetooth, hal::I2C &sensorI2C, hal::Serial &mhz19bSerial,
+         hal::Flash &historyFlash)
+        : eventQueue(eventQueue),
+          bluetooth(bluetooth),
+          subscriptions{bluetooth.gattServer()},
+          connectionPolicy{eventQueue, bluetooth.gap()},
+          scheduler{eventQueue},
+          flashLog{historyFlash},
+          mhz19b{eventQueue, mhz19bSerial, {this, &App::onCO2Change}},
+          sensorBus{sensorI2C, eventQueue},
+          recordEvent{eventQueue, {this, &App::onPrimaryMeasured}, hal::StaticEvent::BACKGROUND} {
+    warmStart = retainedState.load(warmState) && warmState.sensorCount <= BME280_COUNT;
+    for (int address : BME280_ADDRESSES) {
+        const WarmState::Sensor *warm = nullptr;
+        for (size_t i = 0; warmStart && i < warmState.sensorCount; ++i) {
+            if (warmState.sensors[i].address == address) {
+                warm = &warmState.sensors[i];
+            }
+        }
+        auto bme280 = std::make_unique<Bme280>(Bme280Transport{sensorBus, address}, eventQueue,
+                                               warm != nullptr ? &warm->calibration : nullptr);
+        if (!bme280->isPresent()) {
+            LOG(BME280_NOT_FOUND, address >> 1);
+            continue;
+        }
+        Sensor &sensor = sensors[sensorCount];
+        sensor.app = this;
+        sensor.index = sensorCount++;
+        sensor.address = address;
+        sensor.bme280 = std::move(bme280);
+        if (warm != nullptr) {
+            sensor.temperature = warm->temperature;
+            sensor.pressure = warm->pressure;
+            sensor.humidity = warm->humidity;
+        }
+    }
+    if (warmStart) {
+        mhz19b.resume(warmState.co2WarmedUp, warmState.co2SensorUptimeMs);
+        co2ppm = warmState.co2ppm;
+        lastChange = currentRecord();
+        LOG(WARM_START, sensorCount, uint32_t(warmState.co2SensorUptimeMs / 1000), warmState.nextSequence);
+    }
+    // Added in the order of ConfigurationService's Measurement Periods
+    environmentTask = scheduler.add({this, &App::measureEnvironment}, MEASUREMENT_FAST_MS, MEASUREMENT_SLOW_MS);
+    co2Task = scheduler.add({this, &App::measureCO2}, MEASUREMENT_FAST_MS, MEASUREMENT_SLOW_MS);
+    consoleTask = scheduler.add({this, &App::printInfo}, CONSOLE_FAST_MS, CONSOLE_SLOW_MS);
+    connectionPolicy.onChange({this, &App::onConnectionPolicyChange});
+}
+
+void App::bleInitComplete(int error) {
+#define CHECK_ERROR(expr, message) \
+        if (int bleError = (expr); bleError != hal::BLE_ERROR_NONE) { \
+            LOG(message, bleError); \
+            return; \
+        }
+
+    CHECK_ERROR(error, BLE_INIT_FAILED);
+
+    environmentalService = std::make_unique<EnvironmentalService>(bluetooth.gattServer(), subscriptions,
+                                                                  sensorCount);
+    historyService = std::make_unique<HistoryService>(bluetooth.gattServer(), subscriptions, history,
+                                                      flashLog.isMounted() ? &flashLog : nullptr,
+                                                      hal::Callback<uint32_t()>{this, &App::now});
+    historyService->onTransfer({&connectionPolicy, &ConnectionPolicy::onTransfer});
+    configurationService = std::make_unique<ConfigurationService>(bluetooth.gattServer(), scheduler);
+    diagnosticsService = std::make_unique<DiagnosticsService>(bluetooth.gattServer());
+    statisticsService = std::make_unique<StatisticsService>(bluetooth.gattServer());
+    bluetooth.gattServer().onDataWritten({this, &App::bleOnDataWritten});
+    bluetooth.gattServer().onDataSent({this, &App::bleOnDataSent});
+    bluetooth.gattServer().onUpdatesChanged({this, &App::bleOnUpdatesChanged});
+
+    hal::Gap &gap = bluetooth.gap();
+    gap.onConnection({this, &App::bleOnConnect});
+    gap.onDisconnection({this, &App::bleOnDisconnect});
+    gap.onConnectionUpdated({this, &App::bleOnConnectionUpdated});
+
+    beacon = std::make_unique<Beacon>(gap, deviceName, bleUuidList, 1);
+    CHECK_ERROR(beacon->start(), BLE_BEACON_START_FAILED);
+    if (warmStart) {
+        // The readings from before the reset until the first measurement
+        beacon->update(history.nextSequence(), lastChange);
+    }
+    energyMeter.setAdvertisingInterval(beacon->getInterval());
+
+#undef CHECK_ERROR
+    LOG(BLE_INITIALIZED);
+}
+
+void App::printInfo() {
+    static int counter = 0;
+
+    LOG(REPORT_HEADER, counter++);
+    const Sensor &primary = sensors[0];
+    if (primary.temperature != Bme280::TEMPERATURE_SKIPPED) {
+        LOG(REPORT_TEMPERATURE, primary.temperature);
+    }
+    if (primary.pressure != Bme280::PRESSURE_SKIPPED) {
+        LOG(REPORT_PRESSURE, primary.pressure);
+    }
+    if (primary.humidity != Bme280::HUMIDITY_SKIPPED) {
+        LOG(REPORT_HUMIDITY, (primary.humidity * 100 + 512) / 1024);
+    }
+    for (size_t i = 1; i < sensorCount; ++i) {
+        const Sensor &sensor = sensors[i];
+        if (sensor.temperature != Bme280::TEMPERATURE_SKIPPED && sensor.pressure != Bme280::PRESSURE_SKIPPED
+            && sensor.humidity != Bme280::HUMIDITY_SKIPPED) {
+            LOG(REPORT_SENSOR, i + 1, sensor.temperature, sensor.pressure, (sensor.humidity * 100 + 512) / 1024);
+        }
+    }
+    if (co2ppm != 0) {
+        LOG(REPORT_CO2, co2ppm);
+    }
+
+    if (isGapConnected()) {
+        LOG(REPORT_CONNECTED_MULTI, bluetooth.gap().getConnectionCount(), bluetooth.gap().getMaxConnections());
+        for (size_t i = 0; i < ConnectionPolicy::MAX_CONNECTIONS; ++i) {
+            const ConnectionPolicy::Link &link = connectionPolicy.links()[i];
+            if (link.used) {
+                LOG(REPORT_CONNECTION, link.handle, link.parameters.minInterval * 125, link.parameters.slaveLatency,
+                    link.phy);
+            }
+        }
+    } else {
+        LOG(REPORT_NOT_CONNECTED);
+    }
+
+    EnergyMeter::Report energy = energyMeter.takeReport();
+    LOG(REPORT_ENERGY, energy.averageMcuNa() / 1000, energy.averageNa() / 1000, energy.cpu.awakeUs / 1000,
+        energy.elapsedMs);
+    reportDiagnostics();
+}
+
+void App::reportDiagnostics() {
+    auto queue = eventQueue.stats();
+    LOG(REPORT_QUEUE, queue.highWaterMark, queue.dropped);
+    if (queue.staticDropped != 0) {
+        LOG(REPORT_STATIC_DROPPED, queue.staticDropped);
+    }
+    LOG(REPORT_PRIORITIES, queue.backgroundDispatched, queue.maxWaitCycles / hal::cyclesPerUs(),
+        queue.maxWaitBackgroundCycles / hal::cyclesPerUs(), queue.maxBackgroundCycles / hal::cyclesPerUs());
+    if (Profiler::isEnabled()) {
+        for (size_t i = 0; i < size_t(Probe::COUNT); ++i) {
+            const Profiler::Stats &stats = Profiler::stats(Probe(i));
+            LOG(REPORT_PROBE, i, stats.count, stats.meanUs(), stats.maxUs);
+        }
+    }
+    const ConnectionPolicy::Stats &modes = connectionPolicy.stats();
+    LOG(REPORT_CONNECTION_MODES, modes.bulkSwitches, modes.idleSwitches, modes.refused, modes.phyUpdates);
+    const I2CBus::Stats &bus = sensorBus.stats();
+    LOG(REPORT_I2C_BUS, bus.transfers, bus.queued, bus.rejected, bus.errors);
+    if (diagnosticsService) {
+        diagnosticsService->update(queue.highWaterMark, uint32_t(queue.dropped));
+        diagnosticsService->updateConnections(connectionPolicy);
+    }
+}
+
+bool App::isGapConnected() const {
+    return bluetooth.gap().isConnected();
+}
+
+void App::measureEnvironment() {
+    // Bus transfers run in background, BLE events are processed meanwhile. The sensors convert at the same time,
+    // the bus runs their transfers one after another.
+    for (size_t i = 0; i < sensorCount; ++i) {
+        Sensor &sensor = sensors[i];
+        sensor.start = Profiler::start();
+        if (!sensor.bme280->readAllAsync({&sensor, &Sensor::onMeasured})) {
+            LOG(BME280_SENSOR_BUSY, i);
+        }
+    }
+}
+
+void App::onEnvironmentMeasured(Sensor &sensor, const Bme280::Measurement *measurement) {
+    if (measurement == nullptr) {
+        LOG(BME280_SENSOR_READ_FAILED, sensor.index);
+        return;
+    }
+    Profiler::stop(Probe::BME280_READ, sensor.start);
+    sensor.temperature = measurement->temperature;
+    sensor.pressure = measurement->pressure;
+    sensor.humidity = measurement->humidity;
+    energyMeter.addBme280Conversion();
+    if (isGapConnected()) {
+        if (sensor.temperature != Bme280::TEMPERATURE_SKIPPED) {
+            environmentalService->updateTemperature(sensor.index, sensor.temperature);
+        }
+        if (sensor.pressure != Bme280::PRESSURE_SKIPPED) {
+            environmentalService->updatePressure(sensor.index, sensor.pressure);
+        }
+        if (sensor.humidity != Bme280::HUMIDITY_SKIPPED) {
+            environmentalService->updateHumidity(sensor.index, sensor.humidity);
+        }
+    }
+    if (sensor.index == 0) {
+        recordEvent.post();
+    }
+}
+
+void App::onPrimaryMeasured() {
+    uint32_t sequence = history.nextSequence();
+    uint32_t time = now();
+    History::Record record = currentRecord();
+    recordHistory(time, record);
+    recordStatistics(record);
+    if (Deadband::environmentChanged(record, lastChange)) {
+        lastChange.temperature = record.temperature;
+        lastChange.humidity = record.humidity;
+        lastChange.pressure = record.pressure;
+        scheduler.activity(environmentTask);
+        scheduler.activity(consoleTask);
+    }
+    updateBoost();
+    if (beacon) {
+        beacon->update(sequence, record);
+        energyMeter.setAdvertisingInterval(beacon->getInterval());
+    }
+    if (isGapConnected()) {
+        environmentalService->updateSnapshot(sequence, time);
+        PROFILE_SCOPE(STATISTICS);
+        statisticsService->update(readingStatistics, hal::uptimeMs());
+    }
+}
+
+void App::mountFlashLog() {
+    if (int error = flashLog.mount(); error != 0) {
+        LOG(FLASH_LOG_MOUNT_FAILED, error);
+    } else {
+        if (flashLog.nextSequence() != 0) {
+            history.setNextSequence(flashLog.nextSequence());
+            timeOffset = flashLog.lastTime() + 1 - uint32_t(hal::uptimeMs() / 1000);
+        }
+        LOG(FLASH_LOG_MOUNTED, flashLog.firstSequence(), flashLog.nextSequence(), flashLog.stats().maxEraseCount);
+    }
+    // Without the flash log, or if its last append did not make it, samples continue the retained cursor
+    if (warmStart && warmState.nextSequence > history.nextSequence()) {
+        history.setNextSequence(warmState.nextSequence);
+        timeOffset = warmState.lastTime + 1 - uint32_t(hal::uptimeMs() / 1000);
+    }
+}
+
+History::Record App::currentRecord() const {
+    History::Record record{
+            0,
+            History::TEMPERATURE_UNKNOWN,
+            History::HUMIDITY_UNKNOWN,
+            History::PRESSURE_UNKNOWN,
+            History::CO2_UNKNOWN,
+    };
+    const Sensor &primary = sensors[0];
+    if (primary.temperature != Bme280::TEMPERATURE_SKIPPED) {
+        record.temperature = (int16_t) primary.temperature;
+    }
+    if (primary.humidity != Bme280::HUMIDITY_SKIPPED) {
+        record.humidity = (uint16_t) ((primary.humidity * 100 + 512) / 1024);
+    }
+    if (primary.pressure != Bme280::PRESSURE_SKIPPED) {
+        record.pressure = (uint16_t) ((primary.pressure + 1) / 2);
+    }
+    record.co2 = co2ppm;
+    return record;
+}
+
+void App::recordHistory(uint32_t time, const History::Record &record) {
+    PROFILE_SCOPE(HISTORY_APPEND);
+    uint32_t sequence = history.nextSequence();
+    history.append(time, record);
+
+    if (flashLog.isMounted()) {
+        FlashLog::Sample sample{sequence, time, record.temperature, record.humidity, record.pressure, record.co2};
+        if (int error = flashLog.append(sample); error != 0) {
+            LOG(FLASH_LOG_APPEND_FAILED, error);
+        }
+    }
+    saveWarmState(time);
+}
+
+void App::saveWarmState(uint32_t time) {
+    warmState.sensorCount = uint32_t(sensorCount);
+    for (size_t i = 0; i < sensorCount; ++i) {
+        const Sensor &sensor = sensors[i];
+        warmState.sensors[i] = WarmState::Sensor{sensor.address, sensor.bme280->getCalibration(),
+                                                 sensor.temperature, sensor.pressure, sensor.humidity};
+    }
+    warmState.co2ppm = co2ppm;
+    warmState.co2WarmedUp = mhz19b.isWarmedUp();
+    warmState.co2SensorUptimeMs = mhz19b.sensorUptimeMs();
+    warmState.nextSequence = history.nextSequence();
+    warmState.lastTime = time;
+    retainedState.store(warmState);
+}
+
+void App::recordStatistics(const History::Record &record) {
+    PROFILE_SCOPE(STATISTICS);
+    uint64_t nowMs = hal::uptimeMs();
+    if (record.temperature != History::TEMPERATURE_UNKNOWN) {
+        readingStatistics[StatisticsService::TEMPERATURE].add(nowMs, record.temperature);
+    }
+    if (record.humidity != History::HUMIDITY_UNKNOWN) {
+        readingStatistics[StatisticsService::HUMIDITY].add(nowMs, record.humidity);
+    }
+    if (record.pressure != History::PRESSURE_UNKNOWN) {
+        readingStatistics[StatisticsService::PRESSURE].add(nowMs, record.pressure);
+    }
+}
+
+void App::updateBoost() {
+    scheduler.setBoost(environmentalService && environmentalService->isSubscribed());
+}
+
+void App::measureCO2() {
+    mhz19bStart = Profiler::start();
+    mhz19b.sendRequest();
+    energyMeter.addUartTransaction();
+}
+
+void App::onCO2Change(uint16_t value) {
+    Profiler::stop(Probe::MHZ19B_ROUND_TRIP, mhz19bStart);
+    co2ppm = value;
+    readingStatistics[StatisticsService::CO2].add(hal::uptimeMs(), co2ppm);
+    History::Record record = currentRecord();
+    if (Deadband::co2Changed(record, lastChange)) {
+        lastChange.co2 = record.co2;
+        scheduler.activity(co2Task);
+        scheduler.activity(consoleTask);
+    }
+    if (isGapConnected()) {
+        environmentalService->updateCO2(co2ppm);
+    }
+}
+
+int App::run() {
+    eventQueue.call([&]() {
+        mountFlashLog();
+        int error = bluetooth.init({this, &App::bleInitComplete});
+        if (error != hal::BLE_ERROR_NONE) {
+            LOG(BLE_INIT_FAILED, error);
+        }
+        scheduler.start();
+    });
+    eventQueue.dispatch_forever();
+    return 0;
+}
@@ -0,0 +1,300 @@
+#ifndef APP_H
+#define APP_H
+
+#include <cstdint>
+#include <memory>
+
+#include <BME280.h>
+#include <ChannelStatistics.h>
+#include <EnergyMeter.h>
+#include <FlashLog.h>
+#include <Hal.h>
+#include <History.h>
+#include <I2CBus.h>
+#include <Log.h>
+#include <MHZ19B.h>
+#include <Profiler.h>
+#include <Retained.h>
+#include <Scheduler.h>
+
+#include "Beacon.h"
+#include "ConfigurationService.h"
+#include "ConnectionPolicy.h"
+#include "DiagnosticsService.h"
+#include "EnvironmentalService.h"
+#include "HistoryService.h"
+#include "StatisticsService.h"
+#include "Subscriptions.h"
+
+class App {
+    hal::EventQueue &eventQueue;
+    hal::Ble &bluetooth;
+    const char deviceName[11] = "shitmeter";
+    const uint16_t bleUuidList[1]{EnvironmentalService::UUID_ENVIRONMENTAL_SERVICE};
+    // Notifications are encoded and sent only for characteristics some connected client subscribed to
+    Subscriptions subscriptions;
+    // Connections idle at a long interval and speed up for history downloads
+    ConnectionPolicy connectionPolicy;
+    std::unique_ptr<Beacon> beacon;
+    std::unique_ptr<EnvironmentalService> environmentalService;
+    std::unique_ptr<HistoryService> historyService;
+    std::unique_ptr<ConfigurationService> configurationService;
+    std::unique_ptr<DiagnosticsService> diagnosticsService;
+    std::unique_ptr<StatisticsService> statisticsService;
+    // Measurements speed up while readings change or a client is subscribed, and slow down otherwise
+    Scheduler scheduler;
+    int environmentTask;
+    int co2Task;
+    int consoleTask;
+    EnergyMeter energyMeter;
+    // Recorded whether a client is connected or not, the largest object of the firmware
+    History history;
+    // The same samples, kept over resets
+    FlashLog flashLog;
+    // Aggregates of every reading, in StatisticsService::Channel order
+    ChannelStatistics readingStatistics[StatisticsService::CHANNEL_COUNT];
+    // Time of samples continues from the last one in flash, the time the device was off is not counted
+    uint32_t timeOffset = 0;
+    MHZ19B mhz19b;
+    // BME280s share the bus, their transfers are queued there rather than refused by the busy peripheral
+    I2CBus sensorBus;
+    // One conversion per measurement cycle, the sensor sleeps in between.
+    // Increase oversampling or enable the filter to trade latency and current for lower noise,
+    // skip a channel to compile its code out.
+    typedef bme280::Settings<bme280::OVERSAMPLING_X1, bme280::OVERSAMPLING_X1, bme280::OVERSAMPLING_X1,
+                             bme280::FILTER_OFF, bme280::MODE_FORCED> Bme280Settings;
+    // On I2C, bme280::SpiTransport takes a sensor on its own chip select instead
+    typedef bme280::I2CTransport<I2CBus> Bme280Transport;
+    typedef BME280<Bme280Transport, Bme280Settings> Bme280;
+    // Addresses probed at start-up. The first sensor found is the primary one: it is recorded in the history
+    // and the statistics, advertised and sent in the snapshot. The others have their own characteristics only.
+    static constexpr int BME280_ADDRESSES[] = {DEFAULT_SLAVE_ADDRESS, 0x77 << 1};
+    static constexpr size_t BME280_COUNT = sizeof(BME280_ADDRESSES) / sizeof(BME280_ADDRESSES[0]);
+
+    /** A BME280 that answered at start-up and its latest readings */
+    struct Sensor {
+        App *app = nullptr;
+        /** Of the sensor in EnvironmentalService, 0 for the primary one */
+        size_t index = 0;
+        int address = 0;
+        std::unique_ptr<Bme280> bme280;
+        int32_t temperature = Bme280::TEMPERATURE_SKIPPED;
+        uint32_t pressure = Bme280::PRESSURE_SKIPPED;
+        uint32_t humidity = Bme280::HUMIDITY_SKIPPED;
+        // Profiler timestamp of the pending request
+        uint32_t start = 0;
+
+        void onMeasured(const Bme280::Measurement *measurement) {
+            app->onEnvironmentMeasured(*this, measurement);
+        }
+    };
+
+    Sensor sensors[BME280_COUNT];
+    size_t sensorCount = 0;
+    // The history, statistics and advertising of a new primary reading are background work
+    hal::StaticEvent recordEvent;
+
+    /**
+     * What a warm restart continues with: after a soft or watchdog reset the sensors are not read for their
+     * calibration, the CO2 readings are not held back for the warm-up of a sensor that kept its power,
+     * the readings are known before the first measurement and samples continue the sequence and the time
+     * even without the flash log.
+     */
+    struct WarmState {
+        struct Sensor {
+            int address;
+            bme280::Calibration calibration;
+            int32_t temperature;
+            uint32_t pressure;
+            uint32_t humidity;
+        };
+
+        Sensor sensors[BME280_COUNT];
+        uint32_t sensorCount;
+        uint16_t co2ppm;
+        bool co2WarmedUp;
+        /** Up to the last save, the time from there to the reset is not counted */
+        uint64_t co2SensorUptimeMs;
+        /** History write cursor: the sequence number of the next sample and the time of the last one */
+        uint32_t nextSequence;
+        uint32_t lastTime;
+    };
+
+    /** "WRM1", the layout of WarmState */
+    static constexpr uint32_t WARM_STATE_MAGIC = 0x314d5257;
+    static Retained<WarmState, WARM_STATE_MAGIC> retainedState;
+    // Loaded at start-up, written after every sample
+    WarmState warmState{};
+    bool warmStart = false;
+    uint16_t co2ppm = 0;
+    // Profiler timestamp of the pending request
+    uint32_t mhz19bStart = 0;
+    // Readings the activity of the scheduler tasks is measured against
+    History::Record lastChange{};
+
+    void bleInitComplete(int error);
+
+    void bleOnDisconnect(hal::ConnectionHandle connection) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        uint8_t connections = bluetooth.gap().getConnectionCount();
+        LOG(BLE_DISCONNECTED_MULTI, connection, connections);
+        subscriptions.onDisconnection(connection);
+        connectionPolicy.onDisconnection(connection);
+        historyService->stop(connection);
+        beacon->onDisconnection();
+        updateBoost();
+        energyMeter.setAdvertisingInterval(beacon->getInterval());
+    }
+
+    void bleOnConnect(hal::ConnectionHandle connection) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        hal::Gap &gap = bluetooth.gap();
+        LOG(BLE_CONNECTED_MULTI, connection, gap.getConnectionCount());
+        if (!subscriptions.onConnection(connection)) {
+            LOG(BLE_TOO_MANY_CONNECTIONS, connection);
+        }
+        connectionPolicy.onConnection(connection);
+        // The new client reads every value and gets notified of every subscribed one at the next update
+        environmentalService->resetTriggers();
+        environmentalService->publish();
+        statisticsService->update(readingStatistics, hal::uptimeMs());
+        beacon->onConnection(gap.getConnectionCount() < gap.getMaxConnections());
+        updateBoost();
+        energyMeter.setAdvertisingInterval(beacon->getInterval());
+    }
+
+    void bleOnConnectionUpdated(hal::ConnectionHandle connection) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        connectionPolicy.onConnectionUpdated(connection);
+    }
+
+    /** Parameters of some connection changed */
+    void onConnectionPolicyChange() {
+        energyMeter.setConnectionEventRate(connectionPolicy.connectionEventRate());
+        if (diagnosticsService) {
+            diagnosticsService->updateConnections(connectionPolicy);
+        }
+    }
+
+    void bleOnUpdatesChanged(hal::GattServer::Handle handle) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        subscriptions.onUpdatesChanged(handle);
+        updateBoost();
+    }
+
+    void bleOnDataWritten(hal::ConnectionHandle connection, hal::GattServer::Handle handle, const uint8_t *data,
+                          uint16_t length) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        environmentalService->onDataWritten(handle, data, length);
+        historyService->onDataWritten(connection, handle, data, length);
+        configurationService->onDataWritten(handle, data, length);
+    }
+
+    void bleOnDataSent(unsigned count) {
+        PROFILE_SCOPE(BLE_CALLBACKS);
+        historyService->onDataSent(count);
+    }
+
+    void measureEnvironment();
+
+    void onEnvironmentMeasured(Sensor &sensor, const Bme280::Measurement *measurement);
+
+    /** History, beacon, statistics and snapshot of a new measurement of the primary sensor */
+    void onPrimaryMeasured();
+
+    void mountFlashLog();
+
+    /** Current readings in history units */
+    History::Record currentRecord() const;
+
+    void recordHistory(uint32_t time, const History::Record &record);
+
+    /** Stores the current warm state into retained RAM */
+    void saveWarmState(uint32_t time);
+
+    /** Adds the known BME280 readings of the record to their statistics */
+    void recordStatistics(const History::Record &record);
+
+    static constexpr uint32_t MEASUREMENT_FAST_MS = 3000;
+    static constexpr uint32_t MEASUREMENT_SLOW_MS = 60000;
+    static constexpr uint32_t CONSOLE_FAST_MS = 6000;
+    static constexpr uint32_t CONSOLE_SLOW_MS = 60000;
+
+    /** Time of samples, seconds */
+    uint32_t now() const {
+        return timeOffset + uint32_t(hal::uptimeMs() / 1000);
+    }
+
+    /** Runs the measurements at the fast rate while a client gets notifications */
+    void updateBoost();
+
+    void measureCO2();
+
+    void printInfo();
+
+    /** Queue and profiler statistics to the console and the diagnostics service */
+    void reportDiagnostics();
+
+    void onCO2Change(uint16_t value);
+
+public:
+    /** Calls posted to the queue once: the start-up in run() */
+    static constexpr size_t ONE_OFF_EVENTS = 1;
+    /** Events of the application itself: recordEvent */
+    static constexpr size_t STATIC_EVENTS = 1;
+    /**
+     * Size of the event queue: slots for every static event of the stack and the drivers and for the one-off
+     * calls. Posting to it does not fail, however many BLE events or received bytes arrive; a post that fails
+     * all the same is counted and reported.
+     */
+    static constexpr size_t EVENT_QUEUE_SIZE =
+            (hal::EventQueue::STATIC_EVENTS + STATIC_EVENTS + hal::Ble::STATIC_EVENTS
+             + ConnectionPolicy::STATIC_EVENTS + Scheduler::STATIC_EVENTS
+             + MHZ19B::STATIC_EVENTS + I2CBus::STATIC_EVENTS + Bme280::STATIC_EVENTS * BME280_COUNT)
+            * hal::StaticEvent::SLOTS * hal::StaticEvent::SLOT_SIZE
+            + ONE_OFF_EVENTS * EVENTS_EVENT_SIZE;
+
+    /**
+     * The history makes the object large, it should have static storage duration.
+     * @param eventQueue queue that runs all handlers, including BLE stack events
+     * @param sensorI2C I2C bus with BME280s at BME280_ADDRESSES, the ones that do not answer are skipped
+     * @param mhz19bSerial UART connected to MH-Z19B
+     * @param historyFlash flash region for the persistent history
+     */
+    App(hal::EventQueue &eventQueue, hal::Ble &bluetooth, hal::I2C &sensorI2C, hal::Serial &mhz19bSerial,
+        hal::Flash &historyFlash);
+
+    int run();
+
+    bool isGapConnected() const;
+
+    const Scheduler::Stats &schedulerStats() const {
+        return scheduler.stats();
+    }
+
+    MHZ19B::Stats co2SensorStats() const {
+        return mhz19b.stats();
+    }
+
+    EnergyMeter::Report energyTotal() const {
+        return energyMeter.total();
+    }
+
+    ChannelStatistics::Summary readingSummary(StatisticsService::Channel channel) {
+        return readingStatistics[channel].summary(hal::uptimeMs());
+    }
+
+    const I2CBus::Stats &sensorBusStats() const {
+        return sensorBus.stats();
+    }
+
+    size_t getSensorCount() const {
+        return sensorCount;
+    }
+
+    const ConnectionPolicy::Stats &connectionPolicyStats() const {
+        return connectionPolicy.stats();
+    }
+};
+
+#endif // APP_H
@@ -0,0 +1,102 @@
+#include <cstring>
+
+#include <Log.h>
+
+#include "Beacon.h"
+#include "EnvironmentalService.h"
+#include "Readings.h"
+
+Beacon::Beacon(hal::Gap &gap, const char *name, const uint16_t *serviceUuids, uint8_t serviceCount)
+        : gap(gap),
+          name(name),
+          serviceUuids(serviceUuids),
+          serviceCount(serviceCount) {
+    encode(0, advertised);
+}
+
+int Beacon::start() {
+    hal::AdvertisingData scanResponse;
+    int error = scanResponse.add(hal::AdvertisingData::COMPLETE_LOCAL_NAME, name, strlen(name));
+    if (error == hal::BLE_ERROR_NONE) {
+        error = gap.setScanResponse(scanResponse);
+    }
+    if (error == hal::BLE_ERROR_NONE) {
+        error = setPayload();
+    }
+    if (error == hal::BLE_ERROR_NONE) {
+        error = gap.startAdvertising(intervalMs, connectable);
+    }
+    return error;
+}
+
+void Beacon::update(uint32_t sequence, const History::Record &record) {
+    encode(sequence, record);
+    if (int error = setPayload(); error != hal::BLE_ERROR_NONE) {
+        LOG(BEACON_UPDATE_FAILED, error);
+    }
+
+    uint16_t interval = intervalMs;
+    if (Deadband::environmentChanged(record, advertised) || Deadband::co2Changed(record, advertised)) {
+        advertised = record;
+        interval = FAST_INTERVAL_MS;
+    } else if (interval < SLOW_INTERVAL_MS) {
+        interval = interval * 2 < SLOW_INTERVAL_MS ? interval * 2 : SLOW_INTERVAL_MS;
+    }
+    if (interval != intervalMs) {
+        intervalMs = interval;
+        restart();
+    }
+}
+
+void Beacon::onConnection(bool connectable) {
+    this->connectable = connectable;
+    // The stack stops connectable advertising on connection
+    restart();
+}
+
+void Beacon::onDisconnection() {
+    connectable = true;
+    intervalMs = FAST_INTERVAL_MS;
+    restart();
+}
+
+int Beacon::setPayload() {
+    hal::AdvertisingData advertisingData;
+    const uint8_t flags = hal::AdvertisingData::LE_GENERAL_DISCOVERABLE
+                          | hal::AdvertisingData::BREDR_NOT_SUPPORTED;
+    int error = advertisingData.add(hal::AdvertisingData::FLAGS, &flags, sizeof(flags));
+    if (error == hal::BLE_ERROR_NONE) {
+        error = advertisingData.add(hal::AdvertisingData::COMPLETE_LIST_16BIT_SERVICE_IDS,
+                                    serviceUuids, serviceCount * sizeof(uint16_t));
+    }
+    const uint16_t appearance = hal::AdvertisingData::GENERIC_THERMOMETER;
+    if (error == hal::BLE_ERROR_NONE) {
+        error = advertisingData.add(hal::AdvertisingData::APPEARANCE, &appearance, sizeof(appearance));
+    }
+    if (error == hal::BLE_ERROR_NONE) {
+        error = advertisingData.add(hal::AdvertisingData::SERVICE_DATA, serviceData, sizeof(serviceData));
+    }
+    if (error == hal::BLE_ERROR_NONE) {
+        error = gap.setAdvertisingPayload(advertisingData);
+    }
+    return error;
+}
+
+int Beacon::restart() {
+    gap.stopAdvertising();
+    int error = gap.startAdvertising(intervalMs, connectable);
+    if (error != hal::BLE_ERROR_NONE) {
+        LOG(BEACON_RESTART_FAILED, error);
+    }
+    return error;
+}
+
+void Beacon::encode(uint32_t sequence, const History::Record &record) {
+    const uint16_t uuid = EnvironmentalService::UUID_ENVIRONMENTAL_SERVICE;
+    memcpy(&serviceData[0], &uuid, sizeof(uuid));
+    serviceData[2] = uint8_t(sequence);
+    memcpy(&serviceData[3], &record.temperature, sizeof(record.temperature));
+    memcpy(&serviceData[5], &record.humidity, sizeof(record.humidity));
+    memcpy(&serviceData[7], &record.pressure, sizeof(record.pressure));
+    memcpy(&serviceData[9], &record.co2, sizeof(record.co2));
+}
@@ -0,0 +1,75 @@
+#ifndef BEACON_H
+#define BEACON_H
+
+#include <cstdint>
+
+#include <Hal.h>
+#include <History.h>
+
+/**
+ * @class Beacon
+ * @brief Advertising with the current readings, so any number of scanners get them without connecting.
+ *
+ * The advertising payload carries Service Data of the Environmental Sensing Service:
+ *   uint16 0x181A
+ *   uint8 sequence number of the measurement, lowest byte
+ *   History::Record values without the time delta: temperature, humidity, pressure, CO2
+ * The name goes to the scan response. Advertising is connectable while the stack has a free
+ * connection, and scannable only once all of them are taken.
+ *
+ * The interval drops to FAST_INTERVAL_MS when a reading changes by its Deadband and doubles
+ * with every measurement without such a change, up to SLOW_INTERVAL_MS.
+ */
+class Beacon {
+public:
+    static constexpr uint16_t FAST_INTERVAL_MS = 250;
+    static constexpr uint16_t SLOW_INTERVAL_MS = 4000;
+
+    /**
+     * @param name complete local name for the scan response
+     * @param serviceUuids 16-bit UUIDs of the services
+     */
+    Beacon(hal::Gap &gap, const char *name, const uint16_t *serviceUuids, uint8_t serviceCount);
+
+    /**
+     * Start advertising without readings.
+     * @return BleError code
+     */
+    int start();
+
+    /** Put new readings into the advertising payload and adapt the interval */
+    void update(uint32_t sequence, const History::Record &record);
+
+    /**
+     * Continue advertising after a central connected, scannable only if there is no free connection left.
+     * @param connectable whether another central can connect
+     */
+    void onConnection(bool connectable);
+
+    /** A connection is free again, advertising becomes connectable */
+    void onDisconnection();
+
+    uint16_t getInterval() const {
+        return intervalMs;
+    }
+
+private:
+    int setPayload();
+
+    int restart();
+
+    void encode(uint32_t sequence, const History::Record &record);
+
+
+    hal::Gap &gap;
+    const char *name;
+    const uint16_t *serviceUuids;
+    uint8_t serviceCount;
+    bool connectable = true;
+    uint16_t intervalMs = FAST_INTERVAL_MS;
+    uint8_t serviceData[2 + 1 + 8];
+    History::Record advertised{0, History::TEMPERATURE_UNKNOWN, History::HUMIDITY_UNKNOWN,
+                               History::PRESSURE_UNKNOWN, History::CO2_UNKNOWN};
+};
+
+#endif // BEACON_H
@@ -0,0 +1,44 @@
+#include <cstring>
+
+#include <Log.h>
+
+#include "ConfigurationService.h"
+
+ConfigurationService::ConfigurationService(hal::GattServer &gattServer, Scheduler &scheduler)
+        : gattServer(gattServer),
+          scheduler(scheduler) {
+    encodePeriods();
+    characteristics[MEASUREMENT_PERIODS].length = uint16_t(scheduler.getTaskCount() * 2 * sizeof(uint16_t));
+    gattServer.addService(vendorUuid(ID_CONFIGURATION_SERVICE), characteristics, CHARACTERISTIC_COUNT);
+}
+
+void ConfigurationService::onDataWritten(hal::GattServer::Handle handle, const uint8_t *data, uint16_t length) {
+    if (handle != characteristics[MEASUREMENT_PERIODS].valueHandle) {
+        return;
+    }
+    size_t count = scheduler.getTaskCount();
+    uint16_t written[2 * Scheduler::MAX_TASKS];
+    bool valid = length == count * 2 * sizeof(uint16_t);
+    if (valid) {
+        memcpy(written, data, length);
+        for (size_t i = 0; i < count; ++i) {
+            valid = valid && written[2 * i] != 0 && written[2 * i] <= written[2 * i + 1];
+        }
+    }
+    if (valid) {
+        for (size_t i = 0; i < count; ++i) {
+            scheduler.setPeriods(int(i), written[2 * i] * 1000u, written[2 * i + 1] * 1000u);
+        }
+    } else {
+        LOG(CONFIG_BAD_PERIODS, length);
+    }
+    encodePeriods();
+    gattServer.write(handle, (uint8_t *) periods, uint16_t(count * 2 * sizeof(uint16_t)), true);
+}
+
+void ConfigurationService::encodePeriods() {
+    for (size_t i = 0; i < scheduler.getTaskCount(); ++i) {
+        periods[2 * i] = uint16_t(scheduler.getFastPeriod(int(i)) / 1000);
+        periods[2 * i + 1] = uint16_t(scheduler.getSlowPeriod(int(i)) / 1000);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CONFIGURATION_SERVICE_H
+#define CONFIGURATION_SERVICE_H
+
+#include <cstdint>
+
+#include <Hal.h>
+#include <Scheduler.h>
+
+#include "VendorUuid.h"
+
+/**
+ * @class ConfigurationService
+ * @brief Vendor service with the settings of the device.
+ *
+ * Measurement Periods holds the fast and the slow period of every scheduler task, in the order
+ * the tasks were added, as pairs of uint16 seconds. A write of the whole value changes them,
+ * a malformed write is ignored and the value shows the periods in effect.
+ */
+class ConfigurationService {
+public:
+    static const uint16_t ID_CONFIGURATION_SERVICE = 0x0300;
+    static const uint16_t ID_MEASUREMENT_PERIODS_CHAR = 0x0301;
+
+    ConfigurationService(hal::GattServer &gattServer, Scheduler &scheduler);
+
+    /** Forwarded from the GATT server, handles writes of Measurement Periods */
+    void onDataWritten(hal::GattServer::Handle handle, const uint8_t *data, uint16_t length);
+
+private:
+    /** Fills the value with the periods in effect */
+    void encodePeriods();
+
+    enum {
+        MEASUREMENT_PERIODS,
+        CHARACTERISTIC_COUNT
+    };
+
+    hal::GattServer &gattServer;
+    Scheduler &scheduler;
+    uint16_t periods[2 * Scheduler::MAX_TASKS]{0};
+
+    hal::GattServer::Characteristic characteristics[CHARACTERISTIC_COUNT] = {
+            {vendorUuid(ID_MEASUREMENT_PERIODS_CHAR),
+             hal::GattServer::PROPERTY_READ | hal::GattServer::PROPERTY_WRITE, (uint8_t *) periods, 0,
+             sizeof(periods), 0, nullptr, 0},
+    };
+};
+
+#endif // CONFIGURATION_SERVICE_H
@@ -0,0 +1,150 @@
+#include <Log.h>
+
+#include "ConnectionPolicy.h"
+
+constexpr hal::ConnectionParameters ConnectionPolicy::IDLE_PARAMETERS;
+constexpr hal::ConnectionParameters ConnectionPolicy::BULK_PARAMETERS;
+
+ConnectionPolicy::ConnectionPolicy(hal::EventQueue &eventQueue, hal::Gap &gap)
+        : gap(gap),
+          timer(eventQueue, {this, &ConnectionPolicy::onTimer}) {}
+
+void ConnectionPolicy::onConnection(hal::ConnectionHandle connection) {
+    for (Link &link : linkTable) {
+        if (!link.used) {
+            link = {true, connection, MODE_DISCOVERY, MODE_DISCOVERY, false, hal::uptimeMs() + DISCOVERY_MS, 0,
+                    {0, 0, 0, 0}, gap.getPhy(connection)};
+            gap.getConnectionParameters(connection, link.parameters);
+            break;
+        }
+    }
+    reschedule();
+    if (changeCallback) {
+        changeCallback();
+    }
+}
+
+void ConnectionPolicy::onDisconnection(hal::ConnectionHandle connection) {
+    if (Link *link = find(connection)) {
+        link->used = false;
+    }
+    reschedule();
+    if (changeCallback) {
+        changeCallback();
+    }
+}
+
+void ConnectionPolicy::onConnectionUpdated(hal::ConnectionHandle connection) {
+    Link *link = find(connection);
+    if (link == nullptr) {
+        return;
+    }
+    gap.getConnectionParameters(connection, link->parameters);
+    hal::Phy phy = gap.getPhy(connection);
+    if (phy != link->phy) {
+        link->phy = phy;
+        ++statistics.phyUpdates;
+    }
+    // The procedure that blocked a request is over
+    apply(*link);
+    reschedule();
+    if (changeCallback) {
+        changeCallback();
+    }
+}
+
+void ConnectionPolicy::onTransfer(hal::ConnectionHandle connection, bool active) {
+    Link *link = find(connection);
+    if (link == nullptr) {
+        return;
+    }
+    link->bulk = active;
+    if (active) {
+        link->wanted = MODE_BULK;
+        apply(*link);
+        if (link->phy != hal::PHY_2M) {
+            // Stacks without PHY updates stay at 1M, that only costs time
+            gap.setPreferredPhy(connection, hal::PHY_2M);
+        }
+    } else {
+        link->idleAtMs = hal::uptimeMs() + BULK_LINGER_MS;
+    }
+    reschedule();
+}
+
+uint32_t ConnectionPolicy::connectionEventRate() const {
+    uint32_t rate = 0;
+    for (const Link &link : linkTable) {
+        if (link.used && link.parameters.minInterval != 0) {
+            // 1000 s are 800000 intervals of 1.25 ms
+            rate += 800000 / (uint32_t(link.parameters.minInterval) * (1 + link.parameters.slaveLatency));
+        }
+    }
+    return rate;
+}
+
+ConnectionPolicy::Link *ConnectionPolicy::find(hal::ConnectionHandle connection) {
+    for (Link &link : linkTable) {
+        if (link.used && link.handle == connection) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+void ConnectionPolicy::apply(Link &link) {
+    if (link.wanted == link.mode) {
+        return;
+    }
+    const hal::ConnectionParameters &parameters = link.wanted == MODE_BULK ? BULK_PARAMETERS : IDLE_PARAMETERS;
+    if (int error = gap.updateConnectionParameters(link.handle, parameters); error != hal::BLE_ERROR_NONE) {
+        ++statistics.refused;
+        link.retryAtMs = hal::uptimeMs() + RETRY_MS;
+        LOG(CONNECTION_UPDATE_REFUSED, link.handle, error);
+        return;
+    }
+    link.mode = link.wanted;
+    if (link.mode == MODE_BULK) {
+        ++statistics.bulkSwitches;
+    } else {
+        ++statistics.idleSwitches;
+    }
+    LOG(CONNECTION_MODE, link.handle, link.mode, parameters.minInterval * 125, parameters.slaveLatency);
+}
+
+void ConnectionPolicy::onTimer() {
+    uint64_t now = hal::uptimeMs();
+    for (Link &link : linkTable) {
+        if (!link.used) {
+            continue;
+        }
+        if (!link.bulk && link.wanted != MODE_IDLE && now >= link.idleAtMs) {
+            link.wanted = MODE_IDLE;
+            link.retryAtMs = now;
+        }
+        if (link.wanted != link.mode && now >= link.retryAtMs) {
+            apply(link);
+        }
+    }
+    reschedule();
+}
+
+void ConnectionPolicy::reschedule() {
+    uint64_t due = UINT64_MAX;
+    for (const Link &link : linkTable) {
+        if (!link.used) {
+            continue;
+        }
+        if (!link.bulk && link.wanted != MODE_IDLE && link.idleAtMs < due) {
+            due = link.idleAtMs;
+        }
+        if (link.wanted != link.mode && link.retryAtMs < due) {
+            due = link.retryAtMs;
+        }
+    }
+    timer.cancel();
+    if (due != UINT64_MAX) {
+        uint64_t now = hal::uptimeMs();
+        timer.postIn(due > now ? int(due - now) : 0);
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef CONNECTION_POLICY_H
+#define CONNECTION_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+
+#include "Subscriptions.h"
+
+/**
+ * @class ConnectionPolicy
+ * @brief Connection parameters per connection: slow while idle, fast during bulk transfers.
+ *
+ * A central connects at parameters of its own and discovers services at them for DISCOVERY_MS.
+ * Afterwards the connection goes idle: a long interval with slave latency, the device wakes once
+ * every couple of seconds unless it has a notification to send. A bulk transfer, a history download,
+ * switches the connection to a short interval and asks for the 2M PHY; the transfer ends and BULK_LINGER_MS
+ * later the connection goes idle again, so that a client downloading in several requests keeps
+ * the fast parameters. The PHY stays, 2M costs less energy per byte.
+ *
+ * The central has the last word: it may pick any interval of the requested range, refuse, or ignore a request.
+ * A request the stack refuses, e.g. while another update is in progress, is repeated when the connection
+ * is updated or the timer runs next. Parameters in use come from the stack and feed the energy estimate.
+ */
+class ConnectionPolicy {
+public:
+    static const size_t MAX_CONNECTIONS = SUBSCRIPTIONS_MAX_CONNECTIONS;
+    /** Events the policy keeps on the queue, see hal::StaticEvent */
+    static const size_t STATIC_EVENTS = 1;
+
+    static const uint32_t DISCOVERY_MS = 5000;
+    static const uint32_t BULK_LINGER_MS = 2000;
+    /** A refused request is repeated at most this often */
+    static const uint32_t RETRY_MS = 1000;
+
+    /**
+     * 360..400 ms, 3 events skipped, 6 s supervision timeout: a wakeup every 1.44 to 1.6 s.
+     * Within the limits iOS enforces: interval max * (latency + 1) at most 2 s, three times that below the timeout.
+     */
+    static constexpr hal::ConnectionParameters IDLE_PARAMETERS{288, 320, 3, 600};
+    /** 15..30 ms, the shortest iOS accepts, no latency, 4 s supervision timeout */
+    static constexpr hal::ConnectionParameters BULK_PARAMETERS{12, 24, 0, 400};
+
+    enum Mode : uint8_t {
+        /** The central's own parameters */
+        MODE_DISCOVERY,
+        MODE_IDLE,
+        MODE_BULK,
+    };
+
+    struct Stats {
+        uint32_t bulkSwitches = 0;
+        uint32_t idleSwitches = 0;
+        /** Parameter requests the stack refused */
+        uint32_t refused = 0;
+        uint32_t phyUpdates = 0;
+    };
+
+    /** A connection as the diagnostics report it */
+    struct Link {
+        bool used;
+        hal::ConnectionHandle handle;
+        /** Mode requested last */
+        Mode mode;
+        /** Mode the connection should be in, differs from mode while a request is refused */
+        Mode wanted;
+        bool bulk;
+        /** Uptime the connection goes idle at, unless a transfer is running */
+        uint64_t idleAtMs;
+        uint64_t retryAtMs;
+        hal::ConnectionParameters parameters;
+        hal::Phy phy;
+    };
+
+    ConnectionPolicy(hal::EventQueue &eventQueue, hal::Gap &gap);
+
+    void onConnection(hal::ConnectionHandle connection);
+
+    void onDisconnection(hal::ConnectionHandle connection);
+
+    /** Forwarded from the GAP, the central changed the parameters or the PHY */
+    void onConnectionUpdated(hal::ConnectionHandle connection);
+
+    /** A bulk transfer on the connection starts or ends */
+    void onTransfer(hal::ConnectionHandle connection, bool active);
+
+    /** Called when the parameters in use change, e.g. for the energy estimate */
+    void onChange(const hal::Callback<void()> &callback) {
+        changeCallback = callback;
+    }
+
+    /** Connection events per 1000 s of all connections at the parameters in use, see EnergyMeter */
+    uint32_t connectionEventRate() const;
+
+    const Link *links() const {
+        return linkTable;
+    }
+
+    const Stats &stats() const {
+        return statistics;
+    }
+
+private:
+    Link *find(hal::ConnectionHandle connection);
+
+    /** Requests the wanted mode if it is not the requested one */
+    void apply(Link &link);
+
+    void onTimer();
+
+    /** Moves the timer to the earliest deadline of the links */
+    void reschedule();
+
+    hal::Gap &gap;
+    hal::StaticEvent timer;
+    Link linkTable[MAX_CONNECTIONS]{};
+    Stats statistics;
+    hal::Callback<void()> changeCallback;
+};
+
+#endif // CONNECTION_POLICY_H
@@ -0,0 +1,46 @@
+#include <cstring>
+
+#include "DiagnosticsService.h"
+
+DiagnosticsService::DiagnosticsService(hal::GattServer &gattServer) : gattServer(gattServer) {
+    gattServer.addService(vendorUuid(ID_DIAGNOSTICS_SERVICE), characteristics, CHARACTERISTIC_COUNT);
+}
+
+void DiagnosticsService::update(size_t queueHighWaterMark, uint32_t queueDropped) {
+    const uint16_t probeCount = Profiler::isEnabled() ? uint16_t(Probe::COUNT) : 0;
+    const uint16_t highWaterMark = uint16_t(queueHighWaterMark);
+    memcpy(&profile[0], &highWaterMark, sizeof(highWaterMark));
+    memcpy(&profile[2], &probeCount, sizeof(probeCount));
+    memcpy(&profile[4], &queueDropped, sizeof(queueDropped));
+
+    uint8_t *probe = &profile[HEADER_LENGTH];
+    for (uint16_t i = 0; i < probeCount; ++i, probe += PROBE_LENGTH) {
+        const Profiler::Stats &stats = Profiler::stats(Probe(i));
+        const uint32_t values[4] = {stats.count, stats.minUs, stats.maxUs, stats.meanUs()};
+        memcpy(probe, values, sizeof(values));
+        memcpy(probe + sizeof(values), stats.histogram, sizeof(stats.histogram));
+    }
+    gattServer.write(characteristics[PROFILE].valueHandle, profile,
+                     uint16_t(HEADER_LENGTH + probeCount * PROBE_LENGTH), true);
+}
+
+void DiagnosticsService::updateConnections(const ConnectionPolicy &policy) {
+    const ConnectionPolicy::Stats &stats = policy.stats();
+    const uint32_t counts[4] = {stats.bulkSwitches, stats.idleSwitches, stats.refused, stats.phyUpdates};
+    memcpy(connections, counts, sizeof(counts));
+
+    size_t length = MODES_LENGTH;
+    for (size_t i = 0; i < ConnectionPolicy::MAX_CONNECTIONS; ++i) {
+        const ConnectionPolicy::Link &link = policy.links()[i];
+        if (!link.used) {
+            continue;
+        }
+        const uint16_t values[4] = {link.handle, link.parameters.minInterval, link.parameters.slaveLatency,
+                                    link.parameters.supervisionTimeout};
+        memcpy(&connections[length], values, sizeof(values));
+        connections[length + 8] = link.mode;
+        connections[length + 9] = link.phy;
+        length += CONNECTION_LENGTH;
+    }
+    gattServer.write(characteristics[CONNECTIONS].valueHandle, connections, uint16_t(length), true);
+}
@@ -0,0 +1,72 @@
+#ifndef DIAGNOSTICS_SERVICE_H
+#define DIAGNOSTICS_SERVICE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+#include <Profiler.h>
+
+#include "ConnectionPolicy.h"
+#include "VendorUuid.h"
+
+/**
+ * @class DiagnosticsService
+ * @brief Vendor service with the run-time statistics of the firmware.
+ *
+ * Profile is refreshed on every update(), little-endian:
+ *   uint16 event queue high-water mark, events
+ *   uint16 number of probes, 0 if the firmware is built without PROFILING
+ *   uint32 events the queue could not take
+ * and for every probe of ProfilerProbes.h, in its order:
+ *   uint32 count, minimum, maximum and mean duration in us
+ *   uint16[Profiler::BUCKETS] histogram
+ *
+ * Connections is refreshed whenever the parameters of a connection change:
+ *   uint32 switches to bulk mode, switches to idle mode, parameter requests refused, PHY updates
+ * and for every connection:
+ *   uint16 connection handle
+ *   uint16 connection interval in 1.25 ms units, slave latency, supervision timeout in 10 ms units
+ *   uint8 ConnectionPolicy::Mode, hal::Phy
+ */
+class DiagnosticsService {
+public:
+    static const uint16_t ID_DIAGNOSTICS_SERVICE = 0x0400;
+    static const uint16_t ID_PROFILE_CHAR = 0x0401;
+    static const uint16_t ID_CONNECTIONS_CHAR = 0x0402;
+
+    static const size_t HEADER_LENGTH = 8;
+    static const size_t PROBE_LENGTH = 4 * sizeof(uint32_t) + Profiler::BUCKETS * sizeof(uint16_t);
+    static const size_t PROFILE_LENGTH = HEADER_LENGTH + size_t(Probe::COUNT) * PROBE_LENGTH;
+    static const size_t MODES_LENGTH = 4 * sizeof(uint32_t);
+    static const size_t CONNECTION_LENGTH = 10;
+    static const size_t CONNECTIONS_LENGTH = MODES_LENGTH + ConnectionPolicy::MAX_CONNECTIONS * CONNECTION_LENGTH;
+
+    explicit DiagnosticsService(hal::GattServer &gattServer);
+
+    void update(size_t queueHighWaterMark, uint32_t queueDropped);
+
+    void updateConnections(const ConnectionPolicy &policy);
+
+private:
+    enum {
+        PROFILE,
+        CONNECTIONS,
+        CHARACTERISTIC_COUNT
+    };
+
+    hal::GattServer &gattServer;
+    uint8_t profile[PROFILE_LENGTH]{0};
+    uint8_t connections[CONNECTIONS_LENGTH]{0};
+
+    hal::GattServer::Characteristic characteristics[CHARACTERISTIC_COUNT] = {
+            {vendorUuid(ID_PROFILE_CHAR), hal::GattServer::PROPERTY_READ, profile, HEADER_LENGTH, sizeof(profile), 0,
+             nullptr, 0},
+            {vendorUuid(ID_CONNECTIONS_CHAR), hal::GattServer::PROPERTY_READ, connections, MODES_LENGTH,
+             sizeof(connections), 0, nullptr, 0},
+    };
+};
+
+static_assert(DiagnosticsService::PROFILE_LENGTH <= 512, "Profile must fit an attribute value");
+
+#endif // DIAGNOSTICS_SERVICE_H
@@ -0,0 +1,362 @@
+#ifndef ENVIRONMENTAL_SERVICE_H
+#define ENVIRONMENTAL_SERVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <Hal.h>
+#include <Log.h>
+#include <Profiler.h>
+
+#include "Subscriptions.h"
+#include "TriggerSetting.h"
+#include "VendorUuid.h"
+
+/** BME280s with characteristics in the service */
+#ifndef ENVIRONMENTAL_SERVICE_MAX_SENSORS
+#define ENVIRONMENTAL_SERVICE_MAX_SENSORS 2
+#endif
+
+/**
+* @class EnvironmentalService
+* @brief BLE Environmental Service. This service provides temperature, humidity and pressure measurement.
+* Service:  https://developer.bluetooth.org/gatt/services/Pages/ServiceViewer.aspx?u=org.bluetooth.service.environmental_sensing.xml
+* Temperature: https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.temperature.xml
+* Humidity: https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.humidity.xml
+* Pressure: https://developer.bluetooth.org/gatt/characteristics/Pages/CharacteristicViewer.aspx?u=org.bluetooth.characteristic.pressure.xml
+*
+* Every characteristic has an ES Trigger Setting descriptor. By default a value is notified when it changes
+* by more than the deadband of the characteristic, and at least once a minute.
+*
+* Every BME280 has its own temperature, humidity and pressure characteristics, told apart by their
+* Characteristic User Description, "Sensor 1" to "Sensor N". The first sensor comes first in the attribute
+* table, as with a single sensor, and its values are the ones in the snapshot.
+*
+* The vendor Environment Snapshot characteristic carries all values of a measurement cycle in one Snapshot
+* record. It is notified once per cycle if any of the values would be notified, a client that subscribes
+* to it instead of the separate characteristics gets one notification instead of up to four.
+*
+* Trigger settings are evaluated and values notified only for characteristics some client is subscribed to,
+* directly or through the snapshot. Values nobody is subscribed to are written to the attribute table for
+* reading at most once per HEARTBEAT_MS, and all of them by publish() when a client connects.
+*/
+class EnvironmentalService {
+public:
+    typedef int16_t TemperatureType_t;
+    typedef uint16_t HumidityType_t;
+    typedef uint32_t PressureType_t;
+    typedef uint16_t CO2Type_t;
+
+    /** Environment Snapshot value, 20 bytes, little-endian */
+    struct Snapshot {
+        uint32_t sequence; /* of the sample in the history */
+        uint32_t time; /* seconds, as in the history */
+        PressureType_t pressure;
+        TemperatureType_t temperature;
+        HumidityType_t humidity;
+        CO2Type_t co2;
+        uint8_t flags; /* SNAPSHOT_* bits of the values present */
+        uint8_t reserved;
+    };
+
+    enum SnapshotFlags : uint8_t {
+        SNAPSHOT_TEMPERATURE = 1 << 0,
+        SNAPSHOT_HUMIDITY = 1 << 1,
+        SNAPSHOT_PRESSURE = 1 << 2,
+        SNAPSHOT_CO2 = 1 << 3,
+    };
+
+    static constexpr uint16_t UUID_ENVIRONMENTAL_SERVICE = 0x181A;
+    static constexpr uint16_t UUID_PRESSURE_CHAR = 0x2A6D;
+    static constexpr uint16_t UUID_TEMPERATURE_CHAR = 0x2A6E;
+    static constexpr uint16_t UUID_HUMIDITY_CHAR = 0x2A6F;
+    static constexpr uint16_t UUID_CO2_CHAR = 0x2A70; /* non-standard extension */
+    static constexpr uint16_t UUID_ES_TRIGGER_SETTING = 0x290D;
+    static constexpr uint16_t UUID_USER_DESCRIPTION = 0x2901;
+    static constexpr uint16_t ID_SNAPSHOT_CHAR = 0x0200;
+
+    static constexpr uint32_t HEARTBEAT_MS = 60000;
+    /* Deadbands in characteristic units, around the noise of the sensors */
+    static constexpr uint32_t HUMIDITY_DEADBAND = 50; /* 0.5 % */
+    static constexpr uint32_t PRESSURE_DEADBAND = 200; /* 20 Pa */
+    static constexpr uint32_t TEMPERATURE_DEADBAND = 10; /* 0.1 C */
+    static constexpr uint32_t CO2_DEADBAND = 20; /* ppm */
+
+    static constexpr size_t MAX_SENSORS = ENVIRONMENTAL_SERVICE_MAX_SENSORS;
+
+    /**
+     * @brief   EnvironmentalService constructor.
+     * @param   _gattServer Reference to GATT server of BLE device.
+     * @param   _subscriptions The characteristics of the service are tracked there.
+     * @param   _sensorCount BME280s to add characteristics for, 1 to MAX_SENSORS.
+     */
+    EnvironmentalService(hal::GattServer &_gattServer, Subscriptions &_subscriptions, size_t _sensorCount = 1) :
+            gattServer(_gattServer),
+            subscriptions(_subscriptions),
+            sensorCount(_sensorCount < 1 ? 1 : _sensorCount < MAX_SENSORS ? _sensorCount : MAX_SENSORS),
+            characteristicCount(FIRST_EXTRA_SENSOR + int(sensorCount - 1) * SENSOR_CHARACTERISTICS) {
+        characteristics[CO2] = {UUID_CO2_CHAR, properties, (uint8_t *) &co2, sizeof(co2), sizeof(co2), 0,
+                                &co2TriggerDescriptor, 1};
+        characteristics[SNAPSHOT] = {vendorUuid(ID_SNAPSHOT_CHAR), properties, (uint8_t *) &snapshot,
+                                     sizeof(snapshot), sizeof(snapshot), 0, nullptr, 0};
+        triggers[CO2] = &co2Trigger;
+        triggers[SNAPSHOT] = nullptr;
+        for (size_t i = 0; i < sensorCount; ++i) {
+            Sensor &sensor = sensors[i];
+            sensor.description[7] = uint8_t('1' + i);
+            const uint16_t uuids[SENSOR_CHARACTERISTICS] = {UUID_HUMIDITY_CHAR, UUID_PRESSURE_CHAR,
+                                                            UUID_TEMPERATURE_CHAR};
+            uint8_t *const values[SENSOR_CHARACTERISTICS] = {(uint8_t *) &sensor.humidity,
+                                                             (uint8_t *) &sensor.pressure,
+                                                             (uint8_t *) &sensor.temperature};
+            const uint16_t lengths[SENSOR_CHARACTERISTICS] = {sizeof(sensor.humidity), sizeof(sensor.pressure),
+                                                              sizeof(sensor.temperature)};
+            for (int c = 0; c < SENSOR_CHARACTERISTICS; ++c) {
+                TriggerSetting &trigger = sensor.triggers[c];
+                sensor.descriptors[c][0] = {UUID_ES_TRIGGER_SETTING, trigger.getBuffer(), trigger.getLength(),
+                                            TriggerSetting::MAX_LENGTH, true, 0};
+                sensor.descriptors[c][1] = {UUID_USER_DESCRIPTION, sensor.description, sizeof(sensor.description),
+                                            sizeof(sensor.description), false, 0};
+                int index = characteristicIndex(i, c);
+                characteristics[index] = {uuids[c], properties, values[c], lengths[c], lengths[c], 0,
+                                          sensor.descriptors[c], 2};
+                triggers[index] = &trigger;
+            }
+        }
+        gattServer.addService(UUID_ENVIRONMENTAL_SERVICE, characteristics, size_t(characteristicCount));
+        for (int i = 0; i < characteristicCount; ++i) {
+            subscriptions.track(characteristics[i].valueHandle);
+        }
+    }
+
+    size_t getSensorCount() const {
+        return sensorCount;
+    }
+
+    /**
+     * @brief   Update humidity characteristic.
+     * @param   sensor Index of the BME280.
+     * @param   newHumidityVal New humidity measurement, 1/1024 %.
+     */
+    void updateHumidity(size_t sensor, uint32_t newHumidityVal) {
+        HumidityType_t &humidity = sensors[sensor].humidity;
+        humidity = (HumidityType_t) ((newHumidityVal * 100 + 512) / 1024);
+        update(characteristicIndex(sensor, HUMIDITY), (uint8_t *) &humidity, sizeof(HumidityType_t), humidity);
+    }
+
+    /**
+     * @brief   Update pressure characteristic.
+     * @param   sensor Index of the BME280.
+     * @param   newPressureVal New pressure measurement, Pa.
+     */
+    void updatePressure(size_t sensor, uint32_t newPressureVal) {
+        PressureType_t &pressure = sensors[sensor].pressure;
+        pressure = (PressureType_t) (newPressureVal * 10);
+        update(characteristicIndex(sensor, PRESSURE), (uint8_t *) &pressure, sizeof(PressureType_t), pressure);
+    }
+
+    /**
+     * @brief   Update temperature characteristic.
+     * @param   sensor Index of the BME280.
+     * @param   newTemperatureVal New temperature measurement, 0.01 C.
+     */
+    void updateTemperature(size_t sensor, int32_t newTemperatureVal) {
+        TemperatureType_t &temperature = sensors[sensor].temperature;
+        temperature = (TemperatureType_t) newTemperatureVal;
+        update(characteristicIndex(sensor, TEMPERATURE), (uint8_t *) &temperature, sizeof(TemperatureType_t),
+               temperature);
+    }
+
+    void updateCO2(uint16_t newCO2Val) {
+        co2 = newCO2Val;
+        update(CO2, (uint8_t *) &co2, sizeof(CO2Type_t), co2);
+    }
+
+    /**
+     * @brief   Update the snapshot with the latest values, call after the updates of a measurement cycle.
+     * @param   sequence Sequence number of the cycle in the history.
+     * @param   time Time of the cycle in the history.
+     */
+    void updateSnapshot(uint32_t sequence, uint32_t time) {
+        snapshot.sequence = sequence;
+        snapshot.time = time;
+        if (!subscriptions.isSubscribed(characteristics[SNAPSHOT].valueHandle)) {
+            if (isReadRefreshDue(SNAPSHOT)) {
+                encodeSnapshot();
+                writeLocal(SNAPSHOT);
+            }
+            return;
+        }
+        PROFILE_SCOPE(GATT_WRITE);
+        encodeSnapshot();
+        gattServer.write(characteristics[SNAPSHOT].valueHandle, (uint8_t *) &snapshot, sizeof(Snapshot),
+                         !snapshotChanged);
+        snapshotChanged = false;
+    }
+
+    /**
+     * @brief   Write every current value for reading, for a client that has just connected.
+     */
+    void publish() {
+        encodeSnapshot();
+        for (int i = 0; i < characteristicCount; ++i) {
+            writeLocal(i);
+        }
+    }
+
+    /**
+     * @brief   Handle a write of a trigger setting, forwarded from the GATT server.
+     */
+    void onDataWritten(hal::GattServer::Handle handle, const uint8_t *data, uint16_t length) {
+        for (int i = 0; i < characteristicCount; ++i) {
+            if (triggers[i] == nullptr || handle != characteristics[i].descriptors[0].handle) {
+                continue;
+            }
+            if (!triggers[i]->parse(data, length)) {
+                LOG(TRIGGER_SETTING_UNSUPPORTED, length);
+            }
+            // The stack keeps what the client wrote, it is replaced with the setting in effect
+            gattServer.write(handle, triggers[i]->getValue(), triggers[i]->getLength(), true);
+        }
+    }
+
+    /**
+     * @brief   Whether the client gets notifications of any of the values.
+     */
+    bool isSubscribed() const {
+        for (int i = 0; i < characteristicCount; ++i) {
+            if (subscriptions.isSubscribed(characteristics[i].valueHandle)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief   Notify every value at the next update, for a client that has just connected.
+     */
+    void resetTriggers() {
+        for (int i = 0; i < characteristicCount; ++i) {
+            if (triggers[i] != nullptr) {
+                triggers[i]->reset();
+            }
+        }
+        snapshotChanged = true;
+    }
+
+private:
+    /**
+     * Writes the value, it goes out as a notification only if the trigger setting says so.
+     * The trigger decides about the snapshot too, it is skipped only if neither has subscribers.
+     */
+    void update(int index, const uint8_t *value, uint16_t length, int64_t measurement) {
+        bool subscribed = subscriptions.isSubscribed(characteristics[index].valueHandle);
+        if (!subscribed && !subscriptions.isSubscribed(characteristics[SNAPSHOT].valueHandle)) {
+            if (isReadRefreshDue(index)) {
+                writeLocal(index);
+            }
+            return;
+        }
+        PROFILE_SCOPE(GATT_WRITE);
+        bool notify = triggers[index]->check(measurement, hal::uptimeMs());
+        if (subscribed) {
+            gattServer.write(characteristics[index].valueHandle, value, length, !notify);
+            localWriteMs[index] = hal::uptimeMs();
+        } else if (isReadRefreshDue(index)) {
+            writeLocal(index);
+        }
+        snapshotChanged = snapshotChanged || notify;
+    }
+
+    bool isReadRefreshDue(int index) const {
+        return hal::uptimeMs() - localWriteMs[index] >= HEARTBEAT_MS;
+    }
+
+    /** Updates the attribute table without notifying */
+    void writeLocal(int index) {
+        const hal::GattServer::Characteristic &characteristic = characteristics[index];
+        gattServer.write(characteristic.valueHandle, characteristic.value, characteristic.length, true);
+        localWriteMs[index] = hal::uptimeMs();
+    }
+
+    void encodeSnapshot() {
+        const TemperatureType_t temperature = sensors[0].temperature;
+        const HumidityType_t humidity = sensors[0].humidity;
+        const PressureType_t pressure = sensors[0].pressure;
+        snapshot.pressure = pressure;
+        snapshot.temperature = temperature;
+        snapshot.humidity = humidity;
+        snapshot.co2 = co2;
+        snapshot.flags = (temperature != std::numeric_limits<TemperatureType_t>::max() ? SNAPSHOT_TEMPERATURE : 0)
+                         | (humidity != std::numeric_limits<HumidityType_t>::max() ? SNAPSHOT_HUMIDITY : 0)
+                         | (pressure != std::numeric_limits<PressureType_t>::max() ? SNAPSHOT_PRESSURE : 0)
+                         | (co2 != std::numeric_limits<CO2Type_t>::max() ? SNAPSHOT_CO2 : 0);
+    }
+
+    /** Characteristics of a sensor, in the order of the attribute table */
+    enum {
+        HUMIDITY,
+        PRESSURE,
+        TEMPERATURE,
+        SENSOR_CHARACTERISTICS
+    };
+
+    /** The first sensor, then the ones that have no single-sensor counterpart, then the other sensors */
+    enum {
+        CO2 = SENSOR_CHARACTERISTICS,
+        SNAPSHOT,
+        FIRST_EXTRA_SENSOR,
+        MAX_CHARACTERISTICS = FIRST_EXTRA_SENSOR + (MAX_SENSORS - 1) * SENSOR_CHARACTERISTICS
+    };
+
+    static int characteristicIndex(size_t sensor, int characteristic) {
+        return sensor == 0 ? characteristic
+                           : FIRST_EXTRA_SENSOR + int(sensor - 1) * SENSOR_CHARACTERISTICS + characteristic;
+    }
+
+    /** Values, trigger settings and descriptors of a sensor's characteristics */
+    struct Sensor {
+        TemperatureType_t temperature = std::numeric_limits<TemperatureType_t>::max();
+        HumidityType_t humidity = std::numeric_limits<HumidityType_t>::max();
+        PressureType_t pressure = std::numeric_limits<PressureType_t>::max();
+        TriggerSetting triggers[SENSOR_CHARACTERISTICS] = {
+                {sizeof(humidity), false, HUMIDITY_DEADBAND, HEARTBEAT_MS},
+                {sizeof(pressure), false, PRESSURE_DEADBAND, HEARTBEAT_MS},
+                {sizeof(temperature), true, TEMPERATURE_DEADBAND, HEARTBEAT_MS},
+        };
+        /** "Sensor N" without the terminating zero */
+        uint8_t description[8] = {'S', 'e', 'n', 's', 'o', 'r', ' ', '1'};
+        /** ES Trigger Setting and Characteristic User Description of every characteristic */
+        hal::GattServer::Descriptor descriptors[SENSOR_CHARACTERISTICS][2]{};
+    };
+
+    static constexpr uint8_t properties =
+            hal::GattServer::PROPERTY_READ | hal::GattServer::PROPERTY_NOTIFY;
+
+    hal::GattServer &gattServer;
+    Subscriptions &subscriptions;
+    const size_t sensorCount;
+    const int characteristicCount;
+
+    Sensor sensors[MAX_SENSORS];
+    CO2Type_t co2 = std::numeric_limits<CO2Type_t>::max();
+    Snapshot snapshot{};
+    bool snapshotChanged = true;
+    /** Uptime of the last write of every value, notified or not */
+    uint64_t localWriteMs[MAX_CHARACTERISTICS]{0};
+
+    TriggerSetting co2Trigger{sizeof(co2), false, CO2_DEADBAND, HEARTBEAT_MS};
+    hal::GattServer::Descriptor co2TriggerDescriptor{UUID_ES_TRIGGER_SETTING, co2Trigger.getBuffer(),
+                                                     co2Trigger.getLength(), TriggerSetting::MAX_LENGTH, true, 0};
+
+    /** Trigger setting of every characteristic, the snapshot has none */
+    TriggerSetting *triggers[MAX_CHARACTERISTICS]{};
+    hal::GattServer::Characteristic characteristics[MAX_CHARACTERISTICS]{};
+};
+
+static_assert(sizeof(EnvironmentalService::Snapshot) == 20, "Snapshot must fit a notification with the default MTU");
+static_assert(ENVIRONMENTAL_SERVICE_MAX_SENSORS >= 1 && ENVIRONMENTAL_SERVICE_MAX_SENSORS <= 9,
+              "Sensors are numbered with a single digit");
+
+#endif // ENVIRONMENTAL_SERVICE_H
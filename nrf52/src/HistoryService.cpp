@@ -0,0 +1,203 @@
+#include <cstring>
+
+#include <Log.h>
+#include <Profiler.h>
+
+#include "HistoryService.h"
+
+namespace {
+
+timeseries::Sample toSample(uint32_t time, const History::Record &record) {
+    return {time, {uint16_t(record.temperature), record.humidity, record.pressure, record.co2}};
+}
+
+}
+
+HistoryService::HistoryService(hal::GattServer &gattServer, Subscriptions &subscriptions, const History &history,
+                               FlashLog *flashLog, const hal::Callback<uint32_t()> &clock)
+        : gattServer(gattServer),
+          subscriptions(subscriptions),
+          history(history),
+          flashLog(flashLog),
+          clock(clock) {
+    gattServer.addService(vendorUuid(ID_HISTORY_SERVICE), characteristics, CHARACTERISTIC_COUNT);
+    subscriptions.track(characteristics[DATA].valueHandle);
+}
+
+void HistoryService::onDataWritten(hal::ConnectionHandle connection, hal::GattServer::Handle handle,
+                                   const uint8_t *data, uint16_t length) {
+    if (handle != characteristics[CONTROL].valueHandle) {
+        return;
+    }
+    if (!subscriptions.isSubscribed(connection, characteristics[DATA].valueHandle)) {
+        LOG(HISTORY_NOT_SUBSCRIBED);
+        return;
+    }
+    if (transferring && connection != client) {
+        LOG(HISTORY_BUSY, client);
+        return;
+    }
+    uint32_t value;
+    if (length == sizeof(value)) {
+        memcpy(&value, data, sizeof(value));
+        start(connection, value, false);
+    } else if (length == sizeof(value) + 1 && data[0] == REQUEST_FROM_TIME) {
+        memcpy(&value, &data[1], sizeof(value));
+        if (flashLog != nullptr && flashLog->firstSequence() < history.firstSequence()) {
+            start(connection, flashLog->seekTime(value).sequence, false);
+        } else {
+            start(connection, history.seekTime(value).sequence, false);
+        }
+    } else if (length == sizeof(value) + 1 && data[0] == REQUEST_COMPRESSED) {
+        if (gattServer.getAttMtu(connection) < MIN_COMPRESSED_MTU) {
+            LOG(HISTORY_MTU_TOO_SMALL, MIN_COMPRESSED_MTU, gattServer.getAttMtu(connection));
+            return;
+        }
+        memcpy(&value, &data[1], sizeof(value));
+        start(connection, value, true);
+    } else {
+        LOG(HISTORY_BAD_CONTROL, length);
+    }
+}
+
+void HistoryService::onDataSent(unsigned) {
+    sendChunks();
+}
+
+void HistoryService::stop(hal::ConnectionHandle connection) {
+    if (transferring && connection == client) {
+        finish();
+    }
+}
+
+void HistoryService::start(hal::ConnectionHandle connection, uint32_t sequence, bool compress) {
+    client = connection;
+    compressed = compress;
+    position.inRam = flashLog == nullptr || sequence >= history.firstSequence();
+    if (position.inRam) {
+        position.ram = history.seek(sequence);
+        position.sequence = position.ram.sequence;
+    } else {
+        position.flash = flashLog->seekSequence(sequence);
+        position.sequence = position.flash.sequence;
+    }
+    transferring = true;
+    if (transferCallback) {
+        transferCallback(client, true);
+    }
+    sendChunks();
+}
+
+bool HistoryService::read(Position &position, uint32_t &sequence, uint32_t &time, History::Record &record) {
+    if (!position.inRam) {
+        FlashLog::Sample sample;
+        if (flashLog->read(position.flash, sample) && sample.sequence < history.firstSequence()) {
+            sequence = sample.sequence;
+            time = sample.time;
+            record = {0, sample.temperature, sample.humidity, sample.pressure, sample.co2};
+            position.sequence = sample.sequence + 1;
+            return true;
+        }
+        position.inRam = true;
+        position.ram = history.seek(position.sequence);
+    }
+    if (!history.read(position.ram, record)) {
+        return false;
+    }
+    sequence = position.ram.sequence - 1;
+    time = position.ram.time;
+    position.sequence = position.ram.sequence;
+    return true;
+}
+
+void HistoryService::sendChunks() {
+    while (transferring) {
+        unsigned payload = gattServer.getAttMtu(client) - hal::GattServer::NOTIFICATION_HEADER_LENGTH;
+        if (payload > MAX_CHUNK_LENGTH) {
+            payload = MAX_CHUNK_LENGTH;
+        }
+
+        // Samples appended during the transfer are sent too, the position commits once the stack takes the chunk
+        Position next = position;
+        uint16_t length = compressed ? fillBlock(next, payload) : fillRecords(next, payload);
+        if (length == HEADER_LENGTH) {
+            uint32_t now = clock();
+            memcpy(&chunk[0], &next.sequence, sizeof(next.sequence));
+            memcpy(&chunk[4], &now, sizeof(now));
+        }
+        uint32_t writeStart = Profiler::start();
+        int error = gattServer.write(client, characteristics[DATA].valueHandle, chunk, length);
+        Profiler::stop(Probe::GATT_WRITE, writeStart);
+        if (error == hal::BLE_ERROR_NO_MEM) {
+            return;
+        }
+        if (error != hal::BLE_ERROR_NONE) {
+            LOG(HISTORY_NOTIFY_FAILED, error);
+            finish();
+            return;
+        }
+        position = next;
+        if (length == HEADER_LENGTH) {
+            finish();
+        }
+    }
+}
+
+uint16_t HistoryService::fillRecords(Position &next, unsigned payload) {
+    uint32_t sequence;
+    uint32_t time;
+    History::Record record;
+    uint16_t length = HEADER_LENGTH;
+    if (!read(next, sequence, time, record)) {
+        return length;
+    }
+    // Reading skips overwritten and torn samples, the header takes the first sample read
+    memcpy(&chunk[0], &sequence, sizeof(sequence));
+    memcpy(&chunk[4], &time, sizeof(time));
+    uint32_t previousTime = time;
+    while (true) {
+        record.timeDelta = uint16_t(time - previousTime);
+        previousTime = time;
+        memcpy(&chunk[length], &record, sizeof(record));
+        length += sizeof(record);
+
+        // A delta too long for a record starts the next chunk
+        Position following = next;
+        if (length + sizeof(record) > payload || !read(following, sequence, time, record)
+            || time - previousTime > UINT16_MAX) {
+            return length;
+        }
+        next = following;
+    }
+}
+
+uint16_t HistoryService::fillBlock(Position &next, unsigned payload) {
+    uint32_t sequence;
+    uint32_t time;
+    History::Record record;
+    if (!read(next, sequence, time, record)) {
+        return HEADER_LENGTH;
+    }
+    PROFILE_SCOPE(HISTORY_ENCODE);
+    timeseries::Encoder encoder{chunk, payload};
+    encoder.begin(sequence, time);
+    // The MTU check makes sure the first sample fits
+    encoder.append(toSample(time, record));
+    while (true) {
+        // A skipped sample starts the next block, the samples of a block are consecutive
+        Position following = next;
+        uint32_t expected = sequence + 1;
+        if (!read(following, sequence, time, record) || sequence != expected
+            || !encoder.append(toSample(time, record))) {
+            return uint16_t(encoder.length());
+        }
+        next = following;
+    }
+}
+
+void HistoryService::finish() {
+    transferring = false;
+    if (transferCallback) {
+        transferCallback(client, false);
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef HISTORY_SERVICE_H
+#define HISTORY_SERVICE_H
+
+#include <cstdint>
+
+#include <FlashLog.h>
+#include <Hal.h>
+#include <History.h>
+#include <TimeSeries.h>
+
+#include "Subscriptions.h"
+#include "VendorUuid.h"
+
+/**
+ * @class HistoryService
+ * @brief Bulk download of the measurement history.
+ *
+ * A client subscribes to History Data and writes to History Control where to start from:
+ *   uint32 sequence number
+ *   0x01, uint32 time in seconds
+ *   0x02, uint32 sequence number, compressed
+ * Samples older than the RAM history come from the flash log. The backlog is sent as notifications
+ * as large as the ATT MTU allows, as many as the stack accepts per connection event. Every notification is
+ *   uint32 sequence of the first record
+ *   uint32 time in seconds the time deltas count from
+ *   History::Record[] samples
+ * A notification without records ends the transfer. Its header holds the sequence number to resume
+ * from next time and the current time, which relates sample times to the wall clock.
+ * A compressed transfer sends a block of lib/TimeSeries instead, with the same header and the temperature,
+ * humidity, pressure and CO2 of History::Record as its channels; a sample takes a byte and one or two more
+ * for every value that changed, instead of 10.
+ * It needs an ATT MTU of at least MIN_COMPRESSED_MTU, so that any sample fits a notification.
+ * Time counts seconds of operation and continues after reboot. Without the flash log the sequence
+ * starts from 0 after reboot, a client notices that by getting a smaller one than it asked for.
+ * Notifications go only to the client that asked. There is one transfer at a time, a request from
+ * another client while it runs is ignored.
+ */
+class HistoryService {
+public:
+    static const uint16_t ID_HISTORY_SERVICE = 0x0100;
+    static const uint16_t ID_HISTORY_CONTROL_CHAR = 0x0101;
+    static const uint16_t ID_HISTORY_DATA_CHAR = 0x0102;
+
+    static const uint16_t HEADER_LENGTH = 8;
+    /** Notification payload for the largest ATT MTU of the nRF52 SoftDevice, 247 */
+    static const uint16_t MAX_CHUNK_LENGTH = 244;
+
+    static const uint8_t REQUEST_FROM_TIME = 0x01;
+    static const uint8_t REQUEST_COMPRESSED = 0x02;
+    static const uint16_t MIN_COMPRESSED_MTU = uint16_t(hal::GattServer::NOTIFICATION_HEADER_LENGTH
+                                                        + timeseries::HEADER_LENGTH
+                                                        + timeseries::MAX_SAMPLE_LENGTH);
+
+    /**
+     * @param flashLog older samples, may be null
+     * @param clock current time of the samples
+     */
+    HistoryService(hal::GattServer &gattServer, Subscriptions &subscriptions, const History &history,
+                   FlashLog *flashLog, const hal::Callback<uint32_t()> &clock);
+
+    /** Forwarded from the GATT server, handles writes of History Control */
+    void onDataWritten(hal::ConnectionHandle connection, hal::GattServer::Handle handle, const uint8_t *data,
+                       uint16_t length);
+
+    /** Forwarded from the GATT server, continues the transfer once the stack has room again */
+    void onDataSent(unsigned count);
+
+    /** Drops the transfer when its client disconnects */
+    void stop(hal::ConnectionHandle connection);
+
+    /** Called with the client when a transfer starts and when it ends, for the connection parameters */
+    void onTransfer(const hal::Callback<void(hal::ConnectionHandle, bool)> &callback) {
+        transferCallback = callback;
+    }
+
+private:
+    /** Transfer position, samples come from the flash log until the RAM history has them */
+    struct Position {
+        uint32_t sequence;
+        bool inRam;
+        History::Cursor ram;
+        FlashLog::Cursor flash;
+    };
+
+    void start(hal::ConnectionHandle connection, uint32_t sequence, bool compress);
+
+    bool read(Position &position, uint32_t &sequence, uint32_t &time, History::Record &record);
+
+    void sendChunks();
+
+    /**
+     * Fills the chunk with the records from the position on, the position moves past them.
+     * @return length of the chunk, HEADER_LENGTH if there are no more samples
+     */
+    uint16_t fillRecords(Position &next, unsigned payload);
+
+    /** The same with a compressed block */
+    uint16_t fillBlock(Position &next, unsigned payload);
+
+    void finish();
+
+    enum {
+        CONTROL,
+        DATA,
+        CHARACTERISTIC_COUNT
+    };
+
+    hal::GattServer &gattServer;
+    Subscriptions &subscriptions;
+    const History &history;
+    FlashLog *flashLog;
+    hal::Callback<uint32_t()> clock;
+    hal::Callback<void(hal::ConnectionHandle, bool)> transferCallback;
+    bool transferring = false;
+    bool compressed = false;
+    hal::ConnectionHandle client = 0;
+    Position position{};
+    uint8_t control[5]{0};
+    uint8_t chunk[MAX_CHUNK_LENGTH]{0};
+
+    hal::GattServer::Characteristic characteristics[CHARACTERISTIC_COUNT] = {
+            {vendorUuid(ID_HISTORY_CONTROL_CHAR), hal::GattServer::PROPERTY_WRITE, control, sizeof(uint32_t),
+             sizeof(control), 0, nullptr, 0},
+            {vendorUuid(ID_HISTORY_DATA_CHAR), hal::GattServer::PROPERTY_NOTIFY, chunk, 0, sizeof(chunk), 0,
+             nullptr, 0},
+    };
+};
+
+#endif // HISTORY_SERVICE_H
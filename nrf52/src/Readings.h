@@ -0,0 +1,34 @@
+#ifndef READINGS_H
+#define READINGS_H
+
+#include <cstdint>
+
+#include <History.h>
+
+/**
+ * Smallest changes of the readings worth reacting to, in History::Record units.
+ * They are above the noise of the sensors at the default oversampling.
+ */
+struct Deadband {
+    static constexpr uint16_t TEMPERATURE = 10; /* 0.1 C */
+    static constexpr uint16_t HUMIDITY = 50; /* 0.5 % */
+    static constexpr uint16_t PRESSURE = 10; /* 20 Pa */
+    static constexpr uint16_t CO2 = 20; /* ppm */
+
+    static bool exceeded(int32_t a, int32_t b, int32_t deadband) {
+        return (a > b ? a - b : b - a) >= deadband;
+    }
+
+    /** Whether any BME280 reading moved by its deadband or more */
+    static bool environmentChanged(const History::Record &a, const History::Record &b) {
+        return exceeded(a.temperature, b.temperature, TEMPERATURE)
+               || exceeded(a.humidity, b.humidity, HUMIDITY)
+               || exceeded(a.pressure, b.pressure, PRESSURE);
+    }
+
+    static bool co2Changed(const History::Record &a, const History::Record &b) {
+        return exceeded(a.co2, b.co2, CO2);
+    }
+};
+
+#endif // READINGS_H
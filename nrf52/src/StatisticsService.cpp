@@ -0,0 +1,36 @@
+#include <cstring>
+
+#include "StatisticsService.h"
+
+StatisticsService::StatisticsService(hal::GattServer &gattServer) : gattServer(gattServer) {
+    summary[0] = CHANNEL_COUNT;
+    summary[1] = ChannelStatistics::WINDOWS;
+    for (size_t i = 0; i < ChannelStatistics::WINDOWS; ++i) {
+        const uint16_t minutes = uint16_t(ChannelStatistics::WINDOW_MS[i] / 60000);
+        memcpy(&summary[2 + i * sizeof(minutes)], &minutes, sizeof(minutes));
+    }
+    gattServer.addService(vendorUuid(ID_STATISTICS_SERVICE), characteristics, CHARACTERISTIC_COUNT);
+}
+
+void StatisticsService::update(ChannelStatistics (&channels)[CHANNEL_COUNT], uint64_t nowMs) {
+    uint8_t *channel = &summary[HEADER_LENGTH];
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c, channel += CHANNEL_LENGTH) {
+        const ChannelStatistics::Summary aggregates = channels[c].summary(nowMs);
+        // Truncation to 16 bits keeps the two's complement of negative temperatures
+        uint16_t values[CHANNEL_LENGTH / sizeof(uint16_t)];
+        size_t v = 0;
+        for (const RollingWindow::Summary &window : aggregates.windows) {
+            values[v++] = uint16_t(window.count > UINT16_MAX ? UINT16_MAX : window.count);
+            values[v++] = uint16_t(window.min);
+            values[v++] = uint16_t(window.max);
+            values[v++] = uint16_t(window.mean);
+            values[v++] = uint16_t(window.deviation);
+        }
+        values[v++] = uint16_t(aggregates.average);
+        for (int32_t percentile : aggregates.percentiles) {
+            values[v++] = uint16_t(percentile);
+        }
+        memcpy(channel, values, sizeof(values));
+    }
+    gattServer.write(characteristics[SUMMARY].valueHandle, summary, sizeof(summary), true);
+}
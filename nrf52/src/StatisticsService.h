@@ -0,0 +1,65 @@
+#ifndef STATISTICS_SERVICE_H
+#define STATISTICS_SERVICE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ChannelStatistics.h>
+#include <Hal.h>
+
+#include "VendorUuid.h"
+
+/**
+ * @class StatisticsService
+ * @brief Vendor service with aggregates of the readings, so a client gets a summary without the history.
+ *
+ * Summary is refreshed on every update(), little-endian:
+ *   uint8 number of channels, number of windows
+ *   uint16[windows] window lengths in minutes
+ * and for every channel, temperature, humidity, pressure and CO2 in History::Record units:
+ *   for every window: uint16 sample count, minimum, maximum, mean, standard deviation
+ *   exponential moving average, 10th, 50th and 90th percentile
+ * Values are 16-bit like in History::Record, signed for the temperature. A window without samples
+ * is all zeros, see ChannelStatistics for what the aggregates cover.
+ */
+class StatisticsService {
+public:
+    static const uint16_t ID_STATISTICS_SERVICE = 0x0500;
+    static const uint16_t ID_SUMMARY_CHAR = 0x0501;
+
+    enum Channel {
+        TEMPERATURE,
+        HUMIDITY,
+        PRESSURE,
+        CO2,
+        CHANNEL_COUNT
+    };
+
+    static const size_t HEADER_LENGTH = 2 + ChannelStatistics::WINDOWS * sizeof(uint16_t);
+    static const size_t WINDOW_LENGTH = 5 * sizeof(uint16_t);
+    static const size_t CHANNEL_LENGTH =
+            ChannelStatistics::WINDOWS * WINDOW_LENGTH + (1 + ChannelStatistics::PERCENTILES) * sizeof(uint16_t);
+    static const size_t SUMMARY_LENGTH = HEADER_LENGTH + CHANNEL_COUNT * CHANNEL_LENGTH;
+
+    explicit StatisticsService(hal::GattServer &gattServer);
+
+    void update(ChannelStatistics (&channels)[CHANNEL_COUNT], uint64_t nowMs);
+
+private:
+    enum {
+        SUMMARY,
+        CHARACTERISTIC_COUNT
+    };
+
+    hal::GattServer &gattServer;
+    uint8_t summary[SUMMARY_LENGTH]{0};
+
+    hal::GattServer::Characteristic characteristics[CHARACTERISTIC_COUNT] = {
+            {vendorUuid(ID_SUMMARY_CHAR), hal::GattServer::PROPERTY_READ, summary, sizeof(summary), sizeof(summary),
+             0, nullptr, 0},
+    };
+};
+
+static_assert(StatisticsService::SUMMARY_LENGTH <= 512, "Summary must fit an attribute value");
+
+#endif // STATISTICS_SERVICE_H
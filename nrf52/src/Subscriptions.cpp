@@ -0,0 +1,125 @@
+#include "Subscriptions.h"
+
+const size_t Subscriptions::MAX_CONNECTIONS;
+const size_t Subscriptions::MAX_CHARACTERISTICS;
+
+Subscriptions::Subscriptions(hal::GattServer &gattServer) : gattServer(gattServer) {}
+
+bool Subscriptions::track(hal::GattServer::Handle valueHandle) {
+    if (trackedCount == MAX_CHARACTERISTICS) {
+        return false;
+    }
+    tracked[trackedCount] = valueHandle;
+    for (Connection &connection : connections) {
+        if (connection.used) {
+            refresh(connection, trackedCount);
+        }
+    }
+    ++trackedCount;
+    updateAny();
+    return true;
+}
+
+bool Subscriptions::onConnection(hal::ConnectionHandle connection) {
+    for (Connection &slot : connections) {
+        if (!slot.used) {
+            slot = {true, connection, 0};
+            for (size_t i = 0; i < trackedCount; ++i) {
+                refresh(slot, i);
+            }
+            updateAny();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Subscriptions::onDisconnection(hal::ConnectionHandle connection) {
+    for (Connection &slot : connections) {
+        if (slot.used && slot.handle == connection) {
+            slot.used = false;
+        }
+    }
+    updateAny();
+}
+
+void Subscriptions::onUpdatesChanged(hal::GattServer::Handle valueHandle) {
+    for (size_t i = 0; i < trackedCount; ++i) {
+        if (tracked[i] != valueHandle) {
+            continue;
+        }
+        // The stack does not tell which client wrote the CCCD, there are only a few to ask
+        for (Connection &connection : connections) {
+            if (connection.used) {
+                refresh(connection, i);
+            }
+        }
+    }
+    updateAny();
+}
+
+bool Subscriptions::isSubscribed(hal::GattServer::Handle valueHandle) const {
+    return (any & bitOf(valueHandle)) != 0;
+}
+
+bool Subscriptions::isSubscribed(hal::ConnectionHandle connection, hal::GattServer::Handle valueHandle) const {
+    const Connection *slot = find(connection);
+    return slot != nullptr && (slot->subscribed & bitOf(valueHandle)) != 0;
+}
+
+size_t Subscriptions::getSubscriberCount(hal::GattServer::Handle valueHandle) const {
+    uint32_t bit = bitOf(valueHandle);
+    size_t count = 0;
+    for (const Connection &connection : connections) {
+        if (connection.used && (connection.subscribed & bit)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+size_t Subscriptions::getConnectionCount() const {
+    size_t count = 0;
+    for (const Connection &connection : connections) {
+        if (connection.used) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+uint32_t Subscriptions::bitOf(hal::GattServer::Handle valueHandle) const {
+    for (size_t i = 0; i < trackedCount; ++i) {
+        if (tracked[i] == valueHandle) {
+            return uint32_t(1) << i;
+        }
+    }
+    return 0;
+}
+
+const Subscriptions::Connection *Subscriptions::find(hal::ConnectionHandle connection) const {
+    for (const Connection &slot : connections) {
+        if (slot.used && slot.handle == connection) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void Subscriptions::refresh(Connection &connection, size_t index) {
+    uint32_t bit = uint32_t(1) << index;
+    if (gattServer.areUpdatesEnabled(connection.handle, tracked[index])) {
+        connection.subscribed |= bit;
+    } else {
+        connection.subscribed &= ~bit;
+    }
+}
+
+void Subscriptions::updateAny() {
+    any = 0;
+    for (const Connection &connection : connections) {
+        if (connection.used) {
+            any |= connection.subscribed;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Hal.h>
+
+/** Centrals connected at the same time, e.g. a phone and a gateway */
+#ifndef SUBSCRIPTIONS_MAX_CONNECTIONS
+#define SUBSCRIPTIONS_MAX_CONNECTIONS 4
+#endif
+
+/**
+ * @class Subscriptions
+ * @brief Which connected client enabled notifications of which characteristic.
+ *
+ * Services register their notifying characteristics with track(). The state of every connection is
+ * read from the stack when the client connects, bonded clients have their CCCDs restored by then, and
+ * again for a characteristic whenever some client writes its CCCD. Services ask isSubscribed() before
+ * they encode and send a value, which costs a bit test instead of a call into the stack.
+ */
+class Subscriptions {
+public:
+    static const size_t MAX_CONNECTIONS = SUBSCRIPTIONS_MAX_CONNECTIONS;
+    /** Bits of a connection's mask */
+    static const size_t MAX_CHARACTERISTICS = 32;
+
+    explicit Subscriptions(hal::GattServer &gattServer);
+
+    /**
+     * Track a notifying characteristic, after addService() assigned its handle.
+     * @return false if MAX_CHARACTERISTICS are tracked already
+     */
+    bool track(hal::GattServer::Handle valueHandle);
+
+    /** @return false if MAX_CONNECTIONS are tracked already, the client gets no notifications then */
+    bool onConnection(hal::ConnectionHandle connection);
+
+    void onDisconnection(hal::ConnectionHandle connection);
+
+    /** Forwarded from the GATT server, some client wrote the CCCD of the characteristic */
+    void onUpdatesChanged(hal::GattServer::Handle valueHandle);
+
+    /** Whether any client is subscribed to the characteristic */
+    bool isSubscribed(hal::GattServer::Handle valueHandle) const;
+
+    bool isSubscribed(hal::ConnectionHandle connection, hal::GattServer::Handle valueHandle) const;
+
+    /** Clients subscribed to the characteristic */
+    size_t getSubscriberCount(hal::GattServer::Handle valueHandle) const;
+
+    size_t getConnectionCount() const;
+
+private:
+    struct Connection {
+        bool used;
+        hal::ConnectionHandle handle;
+        /** Bit i is the characteristic at tracked[i] */
+        uint32_t subscribed;
+    };
+
+    /** Bit of the characteristic, 0 if it is not tracked */
+    uint32_t bitOf(hal::GattServer::Handle valueHandle) const;
+
+    const Connection *find(hal::ConnectionHandle connection) const;
+
+    /** Reads the CCCD of the characteristic for the connection from the stack */
+    void refresh(Connection &connection, size_t index);
+
+    /** Subscriptions of all connections together */
+    void updateAny();
+
+    hal::GattServer &gattServer;
+    hal::GattServer::Handle tracked[MAX_CHARACTERISTICS]{0};
+    size_t trackedCount = 0;
+    Connection connections[MAX_CONNECTIONS]{};
+    uint32_t any = 0;
+};
+
+#endif // SUBSCRIPTIONS_H
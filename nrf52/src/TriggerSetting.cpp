@@ -0,0 +1,150 @@
+#include <cstring>
+
+#include "TriggerSetting.h"
+
+TriggerSetting::TriggerSetting(uint8_t valueSize, bool isSigned, uint32_t deadband, uint32_t heartbeatMs)
+        : valueSize(valueSize),
+          isSigned(isSigned),
+          heartbeatMs(heartbeatMs),
+          deadband(deadband) {
+    encode();
+}
+
+bool TriggerSetting::parse(const uint8_t *data, uint16_t dataLength) {
+    if (dataLength < 1) {
+        return false;
+    }
+    switch (data[0]) {
+        case INACTIVE:
+            if (dataLength != 1) {
+                return false;
+            }
+            condition = INACTIVE;
+            break;
+        case FIXED_INTERVAL:
+        case MIN_INTERVAL:
+            // uint24 seconds
+            if (dataLength != 4) {
+                return false;
+            }
+            condition = (Condition) data[0];
+            operand = data[1] | data[2] << 8 | uint32_t(data[3]) << 16;
+            break;
+        case VALUE_CHANGED:
+            if (dataLength != 1 && dataLength != 1 + valueSize) {
+                return false;
+            }
+            if (dataLength != 1) {
+                int64_t newDeadband = readOperand(&data[1]);
+                if (newDeadband < 0) {
+                    return false;
+                }
+                deadband = uint32_t(newDeadband);
+            }
+            condition = VALUE_CHANGED;
+            break;
+        case LESS_THAN:
+        case LESS_OR_EQUAL:
+        case GREATER_THAN:
+        case GREATER_OR_EQUAL:
+        case EQUAL:
+        case NOT_EQUAL:
+            if (dataLength != 1 + valueSize) {
+                return false;
+            }
+            condition = (Condition) data[0];
+            operand = readOperand(&data[1]);
+            break;
+        default:
+            return false;
+    }
+    encode();
+    return true;
+}
+
+bool TriggerSetting::check(int64_t measurement, uint64_t nowMs) {
+    uint64_t silenceMs = nowMs - lastMs;
+    // Compared to the last notified value, so a slow drift is notified once it adds up
+    uint64_t change = measurement > lastValue ? measurement - lastValue : lastValue - measurement;
+    bool changed = change != 0 && change >= deadband;
+    bool heartbeat = silenceMs >= heartbeatMs;
+    bool notify;
+    switch (condition) {
+        case INACTIVE:
+            return false;
+        case FIXED_INTERVAL:
+            notify = !notifiedBefore || silenceMs >= uint64_t(operand) * 1000;
+            break;
+        case MIN_INTERVAL:
+            notify = !notifiedBefore || (changed && silenceMs >= uint64_t(operand) * 1000)
+                     || heartbeat;
+            break;
+        case VALUE_CHANGED:
+            notify = !notifiedBefore || changed || heartbeat;
+            break;
+        case LESS_THAN:
+            notify = measurement < operand || heartbeat;
+            break;
+        case LESS_OR_EQUAL:
+            notify = measurement <= operand || heartbeat;
+            break;
+        case GREATER_THAN:
+            notify = measurement > operand || heartbeat;
+            break;
+        case GREATER_OR_EQUAL:
+            notify = measurement >= operand || heartbeat;
+            break;
+        case EQUAL:
+            notify = measurement == operand || heartbeat;
+            break;
+        case NOT_EQUAL:
+            notify = measurement != operand || heartbeat;
+            break;
+        default:
+            notify = false;
+    }
+    if (notify) {
+        notifiedBefore = true;
+        lastValue = measurement;
+        lastMs = nowMs;
+    }
+    return notify;
+}
+
+void TriggerSetting::encode() {
+    value[0] = condition;
+    switch (condition) {
+        case INACTIVE:
+            length = 1;
+            break;
+        case FIXED_INTERVAL:
+        case MIN_INTERVAL:
+            value[1] = uint8_t(operand);
+            value[2] = uint8_t(operand >> 8);
+            value[3] = uint8_t(operand >> 16);
+            length = 4;
+            break;
+        case VALUE_CHANGED:
+            for (uint8_t i = 0; i < valueSize; ++i) {
+                value[1 + i] = uint8_t(deadband >> (8 * i));
+            }
+            length = 1 + valueSize;
+            break;
+        default:
+            for (uint8_t i = 0; i < valueSize; ++i) {
+                value[1 + i] = uint8_t(operand >> (8 * i));
+            }
+            length = 1 + valueSize;
+    }
+}
+
+int64_t TriggerSetting::readOperand(const uint8_t *data) const {
+    uint64_t raw = 0;
+    for (uint8_t i = 0; i < valueSize; ++i) {
+        raw |= uint64_t(data[i]) << (8 * i);
+    }
+    if (isSigned && valueSize < 8 && (raw >> (8 * valueSize - 1)) & 1) {
+        raw |= ~uint64_t(0) << (8 * valueSize);
+    }
+    return int64_t(raw);
+}
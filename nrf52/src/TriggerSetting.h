@@ -0,0 +1,92 @@
+#ifndef TRIGGER_SETTING_H
+#define TRIGGER_SETTING_H
+
+#include <cstdint>
+
+/**
+ * @class TriggerSetting
+ * @brief When a characteristic of the Environmental Sensing Service notifies, with the value
+ * of its ES Trigger Setting descriptor.
+ * Descriptor: https://www.bluetooth.com/specifications/gatt/viewer?attributeXmlFile=org.bluetooth.descriptor.es_trigger_setting.xml
+ *
+ * Conditions are the standard ones. "Value changed" means changed by at least the deadband since
+ * the last notification and takes the deadband as an optional operand in the characteristic format,
+ * which is an extension. The minimum interval condition also applies the deadband.
+ * Unless notifications are off or on a fixed interval, the value is also notified after the heartbeat
+ * period of silence, so clients can tell a stable value from a lost link.
+ */
+class TriggerSetting {
+public:
+    enum Condition : uint8_t {
+        INACTIVE = 0x00,
+        FIXED_INTERVAL = 0x01,
+        MIN_INTERVAL = 0x02,
+        VALUE_CHANGED = 0x03,
+        LESS_THAN = 0x04,
+        LESS_OR_EQUAL = 0x05,
+        GREATER_THAN = 0x06,
+        GREATER_OR_EQUAL = 0x07,
+        EQUAL = 0x08,
+        NOT_EQUAL = 0x09,
+    };
+
+    /** Condition and the largest operand, a 32-bit value */
+    static const uint16_t MAX_LENGTH = 5;
+
+    /**
+     * @param valueSize size of the characteristic value, bytes
+     * @param isSigned whether the characteristic value is signed
+     * @param deadband change that is notified, in characteristic units
+     * @param heartbeatMs longest time without a notification
+     */
+    TriggerSetting(uint8_t valueSize, bool isSigned, uint32_t deadband, uint32_t heartbeatMs);
+
+    /**
+     * Apply a descriptor value written by a client.
+     * @return false if the value is malformed, the setting does not change then
+     */
+    bool parse(const uint8_t *data, uint16_t length);
+
+    /** Descriptor value of the current setting */
+    const uint8_t *getValue() const {
+        return value;
+    }
+
+    uint16_t getLength() const {
+        return length;
+    }
+
+    uint8_t *getBuffer() {
+        return value;
+    }
+
+    /**
+     * Whether the new characteristic value must be notified, records the notification if so.
+     * @param measurement characteristic value, sign-extended
+     */
+    bool check(int64_t measurement, uint64_t nowMs);
+
+    /** The next value is notified regardless of the condition, e.g. for a new client */
+    void reset() {
+        notifiedBefore = false;
+    }
+
+private:
+    void encode();
+
+    int64_t readOperand(const uint8_t *data) const;
+
+    const uint8_t valueSize;
+    const bool isSigned;
+    const uint32_t heartbeatMs;
+    Condition condition = VALUE_CHANGED;
+    uint32_t deadband;
+    int64_t operand = 0; /* seconds for intervals, compared value otherwise */
+    uint8_t value[MAX_LENGTH]{0};
+    uint16_t length = 0;
+    bool notifiedBefore = false;
+    int64_t lastValue = 0;
+    uint64_t lastMs = 0;
+};
+
+#endif // TRIGGER_SETTING_H
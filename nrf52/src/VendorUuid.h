@@ -0,0 +1,20 @@
+#ifndef VENDOR_UUID_H
+#define VENDOR_UUID_H
+
+#include <cstdint>
+
+#include <Hal.h>
+
+/**
+ * Base of the UUIDs of services and characteristics that are not assigned by Bluetooth SIG,
+ * f3a1xxxx-5c1e-4b7a-9d42-7e1c0b8a6d25. Bytes 2 and 3 hold the 16-bit id.
+ */
+static constexpr uint8_t VENDOR_UUID_BASE[hal::Uuid::LONG_LENGTH] = {
+        0xf3, 0xa1, 0x00, 0x00, 0x5c, 0x1e, 0x4b, 0x7a, 0x9d, 0x42, 0x7e, 0x1c, 0x0b, 0x8a, 0x6d, 0x25,
+};
+
+inline hal::Uuid vendorUuid(uint16_t id) {
+    return hal::Uuid::fromBase(VENDOR_UUID_BASE, id);
+}
+
+#endif // VENDOR_UUID_H
@@ -0,0 +1,295 @@
+#ifdef HAL_NATIVE
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <FileFlash.h>
+#include <SimulatedBle.h>
+#include <SimulatedBme280.h>
+#include <SimulatedBme280Spi.h>
+#include <SimulatedI2CBus.h>
+#include <SimulatedMhz19b.h>
+#include <TextLogConsole.h>
+#include <TimeSeries.h>
+
+#include "App.h"
+
+/**
+ * Runs the firmware on Linux against simulated peripherals. Time is virtual, so a day of operation
+ * takes seconds. A central connects for the first 10 minutes of every hour and downloads the history
+ * recorded since the previous connection. At the end power is cut in the middle of a flash log append
+ * and the log is mounted again, the way the next boot would, and the primary sensor is read over its
+ * SPI port to compare the driver on both transports.
+ *
+ * Usage: program [hours] [-v] [-g] [-c] [-f file] [-l file] [-t file]
+ *   hours  virtual duration, 24 by default
+ *   -v     print the firmware log
+ *   -g     a gateway stays connected too, subscribed to the Environment Snapshot only
+ *   -c     the central downloads the history compressed
+ *   -f     flash image of the history log, kept between runs; a temporary one by default
+ *   -l     write the binary log to a file, for tools/logdecode.py
+ *   -t     write the downloaded samples to a file, a trace for tools/codecbench.cpp
+ */
+int main(int argc, char **argv) {
+    double hours = 24;
+    bool verbose = false;
+    bool gateway = false;
+    bool compressed = false;
+    const char *flashFile = nullptr;
+    FILE *logFile = nullptr;
+    FILE *traceFile = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            gateway = true;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            compressed = true;
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            flashFile = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            logFile = fopen(argv[++i], "wb");
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            traceFile = fopen(argv[++i], "w");
+        } else {
+            hours = atof(argv[i]);
+        }
+    }
+    if (!verbose) {
+        std::cerr.setstate(std::ios::failbit);
+    }
+
+    hal::EventQueue eventQueue{50 * EVENTS_EVENT_SIZE};
+    TextLogConsole console{eventQueue, std::cerr, logFile};
+    SimulatedBle bluetooth{eventQueue};
+    // Two sensors share the bus, the second one in another room
+    SimulatedI2CBus sensorI2C{eventQueue};
+    SimulatedBme280 bme280{eventQueue};
+    SimulatedBme280 secondBme280{eventQueue, 0x77 << 1, 2};
+    sensorI2C.attach(bme280);
+    sensorI2C.attach(secondBme280);
+    SimulatedMhz19b mhz19bSerial{eventQueue};
+    // One response in fifty is garbled or missing, the driver has to recover
+    mhz19bSerial.setFaultRate(0.02);
+    FileFlash historyFlash{flashFile};
+    static App app{eventQueue, bluetooth, sensorI2C, mhz19bSerial, historyFlash};
+
+    uint32_t resumeSequence = 0;
+    uint64_t historySamples = 0;
+    uint64_t historyBytes = 0;
+    uint64_t historyTransfers = 0;
+    uint64_t transferStartMs = 0;
+    uint64_t longestTransferMs = 0;
+    hal::ConnectionHandle phone = SimulatedBle::INVALID_CONNECTION;
+    hal::ConnectionHandle gatewayConnection = SimulatedBle::INVALID_CONNECTION;
+    uint64_t gatewayNotifications = 0;
+    bluetooth.onClientNotification([&](hal::ConnectionHandle connection, hal::GattServer::Handle handle,
+                                       const uint8_t *data, uint16_t length) {
+        if (connection == gatewayConnection) {
+            ++gatewayNotifications;
+            return;
+        }
+        if (handle != bluetooth.findHandle(vendorUuid(HistoryService::ID_HISTORY_DATA_CHAR))) {
+            return;
+        }
+        historyBytes += length;
+        if (length == HistoryService::HEADER_LENGTH) {
+            memcpy(&resumeSequence, data, sizeof(resumeSequence));
+            ++historyTransfers;
+            longestTransferMs = std::max(longestTransferMs, eventQueue.tick() - transferStartMs);
+            return;
+        }
+        // Both formats decode to the channels of the codec, the trace has one line per sample
+        timeseries::Decoder decoder;
+        decoder.open(data, length);
+        uint32_t sequence = decoder.header().sequence;
+        uint32_t time = decoder.header().time;
+        timeseries::Sample sample{};
+        for (size_t offset = HistoryService::HEADER_LENGTH; offset < length; ++sequence) {
+            if (compressed) {
+                if (!decoder.next(sample)) {
+                    break;
+                }
+            } else {
+                History::Record record;
+                memcpy(&record, data + offset, sizeof(record));
+                offset += sizeof(record);
+                time += record.timeDelta;
+                sample = {time, {uint16_t(record.temperature), record.humidity, record.pressure, record.co2}};
+            }
+            ++historySamples;
+            if (traceFile != nullptr) {
+                fprintf(traceFile, "%u,%u,%d,%u,%u,%u\n", sequence, sample.time, int16_t(sample.values[0]),
+                        sample.values[1], sample.values[2], sample.values[3]);
+            }
+        }
+    });
+
+    if (gateway) {
+        eventQueue.call_in(1000, [&]() {
+            gatewayConnection = bluetooth.connect(hal::GattServer::DEFAULT_ATT_MTU, false);
+            bluetooth.subscribe(gatewayConnection, bluetooth.findHandle(
+                    vendorUuid(EnvironmentalService::ID_SNAPSHOT_CHAR)));
+        });
+    }
+    eventQueue.call_every(3600 * 1000, [&]() {
+        phone = bluetooth.connect(247);
+        transferStartMs = eventQueue.tick();
+        uint8_t request[5] = {HistoryService::REQUEST_COMPRESSED};
+        memcpy(&request[1], &resumeSequence, sizeof(resumeSequence));
+        bluetooth.clientWrite(phone, bluetooth.findHandle(vendorUuid(HistoryService::ID_HISTORY_CONTROL_CHAR)),
+                              compressed ? request : &request[1], compressed ? 5 : 4);
+        eventQueue.call_in(600 * 1000, [&]() {
+            bluetooth.disconnect(phone);
+        });
+    });
+    eventQueue.call_in(int(hours * 3600 * 1000), &eventQueue, &hal::EventQueue::break_dispatch);
+
+    app.run();
+
+    // Power goes off while a sample is programmed, half of it reaches the flash
+    historyFlash.cutPower(sizeof(FlashLog::Sample) / 2);
+    eventQueue.dispatch(3000);
+    historyFlash.restorePower();
+    FlashLog recovered{historyFlash};
+    int mountError = recovered.mount();
+    uint64_t intactSamples = 0;
+    FlashLog::Sample sample{};
+    FlashLog::Cursor cursor = recovered.seekSequence(0);
+    while (recovered.read(cursor, sample)) {
+        ++intactSamples;
+    }
+    uint32_t firstTime = 0;
+    cursor = recovered.seekSequence(0);
+    if (recovered.read(cursor, sample)) {
+        firstTime = sample.time;
+    }
+    const int seeks = 10000;
+    auto seekStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks; ++i) {
+        recovered.seekTime(firstTime + uint32_t(uint64_t(i) * (recovered.lastTime() - firstTime) / seeks));
+    }
+    auto seekNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - seekStart).count();
+
+    // The same chip through the SPI transport: the forced conversion it starts is then read over I2C too
+    typedef bme280::Settings<bme280::OVERSAMPLING_X1, bme280::OVERSAMPLING_X1, bme280::OVERSAMPLING_X1,
+                             bme280::FILTER_OFF, bme280::MODE_FORCED> Bme280Settings;
+    SimulatedBme280Spi bme280Spi{eventQueue, bme280};
+    BME280<bme280::SpiTransport<>, Bme280Settings> spiSensor{bme280::SpiTransport<>{bme280Spi}, eventQueue};
+    BME280<bme280::I2CTransport<SimulatedBme280>, Bme280Settings> i2cSensor{
+            bme280::I2CTransport<SimulatedBme280>{bme280, bme280.getAddress()}, eventQueue};
+    eventQueue.dispatch(100);
+    const SimulatedBme280Spi::Stats spiBefore = bme280Spi.stats();
+    bme280::Measurement spiMeasurement{};
+    bool spiMeasured = false;
+    spiSensor.readAllAsync([&](const bme280::Measurement *measurement) {
+        spiMeasured = measurement != nullptr;
+        if (spiMeasured) {
+            spiMeasurement = *measurement;
+        }
+    });
+    eventQueue.dispatch(100);
+    const bme280::Measurement i2cMeasurement = i2cSensor.readAll();
+    const bool spiMatches = spiSensor.isPresent() && spiMeasured
+                            && spiMeasurement.temperature == i2cMeasurement.temperature
+                            && spiMeasurement.pressure == i2cMeasurement.pressure
+                            && spiMeasurement.humidity == i2cMeasurement.humidity;
+
+    const hal::EventQueue::Stats &queue = eventQueue.stats();
+    EnergyMeter::Report energy = app.energyTotal();
+    const ChannelStatistics::Summary temperature = app.readingSummary(StatisticsService::TEMPERATURE);
+    const RollingWindow::Summary &day = temperature.windows[ChannelStatistics::WINDOWS - 1];
+    std::cout << "Virtual time:        " << eventQueue.tick() / 1000 << " s" << std::endl
+              << "Events dispatched:   " << queue.dispatched << std::endl
+              << "Events dropped:      " << queue.dropped << std::endl
+              << "Queue high-water:    " << queue.highWaterMark << std::endl
+              << "Log entries dropped: " << Log::dropped() << std::endl
+              << "Priorities:          " << queue.backgroundDispatched << " background events, longest wait "
+              << queue.maxWaitCycles << " ns (" << queue.maxWaitBackgroundCycles << " ns in background), "
+              << "longest background handler " << queue.maxBackgroundCycles << " ns, bound "
+              << (queue.maxWaitBackgroundCycles <= queue.maxBackgroundCycles ? "holds" : "exceeded") << std::endl
+              << "Host time per event: " << (queue.dispatched ? queue.hostNanoseconds / queue.dispatched : 0)
+              << " ns avg, " << queue.maxHostNanoseconds << " ns max" << std::endl
+              << "Scheduler:           " << app.schedulerStats().wakeups << " wakeups, "
+              << app.schedulerStats().runs << " task runs" << std::endl
+              << "Energy estimate:     " << energy.averageMcuNa() / 1000.0 << " uA nRF52 (CPU "
+              << energy.cpuNc * 1000 / std::max<uint64_t>(energy.elapsedMs, 1) / 1000.0 << ", radio "
+              << energy.radioNc * 1000 / std::max<uint64_t>(energy.elapsedMs, 1) / 1000.0 << "), "
+              << energy.averageNa() / 1000.0 << " uA with sensors, "
+              << energy.advertisingEvents << " advertising events, " << energy.connectionEvents
+              << " connection events" << std::endl
+              << "BME280:              " << app.getSensorCount() << " sensors, " << bme280.stats().conversions
+              << " and " << secondBme280.stats().conversions << " conversions, " << sensorI2C.stats().transfers
+              << " I2C transfers, " << sensorI2C.stats().bytes << " bytes, bus busy "
+              << sensorI2C.stats().busyUs / 1000 << " ms, " << sensorI2C.stats().collisions << " collisions"
+              << std::endl
+              << "BME280 over SPI:     " << (spiMatches ? "same reading as I2C, " : "differs from I2C, ")
+              << bme280Spi.stats().transactions - spiBefore.transactions << " transactions, "
+              << bme280Spi.stats().bytes - spiBefore.bytes << " bytes, bus busy "
+              << (bme280Spi.stats().busyNs - spiBefore.busyNs) / 1000.0 << " us a measurement" << std::endl
+              << "I2C bus arbiter:     " << app.sensorBusStats().transfers << " transfers, "
+              << app.sensorBusStats().queued << " queued, " << app.sensorBusStats().rejected << " rejected, "
+              << app.sensorBusStats().errors << " errors, " << app.sensorBusStats().maxPending << " max pending"
+              << std::endl
+              << "MH-Z19B:             " << mhz19bSerial.stats().requests << " requests, "
+              << mhz19bSerial.stats().responses << " responses, "
+              << mhz19bSerial.stats().lostBytes << " lost bytes, UART enabled "
+              << mhz19bSerial.stats().enabledMs / 1000 << " s, " << mhz19bSerial.stats().faults << " faults"
+              << std::endl
+              << "MH-Z19B driver:      " << app.co2SensorStats().readings << " readings, "
+              << app.co2SensorStats().timeouts << " timeouts, " << app.co2SensorStats().failures << " failures, "
+              << app.co2SensorStats().checksumErrors << " checksum errors, "
+              << app.co2SensorStats().writeErrors << " write errors, "
+              << app.co2SensorStats().skippedBytes << " bytes skipped" << std::endl
+              << "GATT:                " << bluetooth.stats().writes << " writes, "
+              << bluetooth.stats().notifications << " notifications, "
+              << bluetooth.stats().notifiedBytes << " bytes notified, "
+              << bluetooth.stats().connections << " connections, "
+              << bluetooth.stats().txBufferFull << " times TX buffers full, "
+              << gatewayNotifications << " notifications to the gateway" << std::endl
+              << "Connection modes:    " << app.connectionPolicyStats().bulkSwitches << " to bulk, "
+              << app.connectionPolicyStats().idleSwitches << " to idle, " << app.connectionPolicyStats().refused
+              << " refused, " << bluetooth.stats().parameterUpdates << " parameter updates, "
+              << bluetooth.stats().phyUpdates << " PHY updates" << std::endl
+              << "Advertising:         " << bluetooth.stats().advertisingEvents << " events, "
+              << bluetooth.stats().advertisingPayloads << " payloads, "
+              << bluetooth.stats().advertisingStarts << " starts" << std::endl
+              << "History:             " << historySamples << " samples downloaded in "
+              << historyTransfers << " transfers, " << (compressed ? "compressed, " : "")
+              << double(historyBytes) / std::max<uint64_t>(historySamples, 1) << " bytes a sample, longest "
+              << longestTransferMs << " ms" << std::endl
+              << "Temperature 24 h:    " << day.count << " samples, " << day.min / 100.0 << ".." << day.max / 100.0
+              << " C, mean " << day.mean / 100.0 << " C, deviation " << day.deviation / 100.0 << " C, median "
+              << temperature.percentiles[1] / 100.0 << " C, average " << temperature.average / 100.0 << " C"
+              << std::endl
+              << "Flash:               " << historyFlash.stats().erases << " erases, "
+              << historyFlash.stats().maxSectorErases << " max per sector, "
+              << historyFlash.stats().programmedBytes << " bytes programmed" << std::endl
+              << "Flash log remount:   " << (mountError == 0 ? "ok, " : "failed, ") << "samples "
+              << recovered.firstSequence() << ".." << recovered.nextSequence() << ", "
+              << intactSamples << " intact, seek by time " << seekNanoseconds / seeks << " ns" << std::endl;
+    if (logFile != nullptr) {
+        fclose(logFile);
+    }
+    if (traceFile != nullptr) {
+        fclose(traceFile);
+    }
+    const char *const probeNames[] = {
+#define PROFILER_PROBE_NAME(name) #name,
+            PROFILER_PROBES(PROFILER_PROBE_NAME)
+#undef PROFILER_PROBE_NAME
+    };
+    for (size_t i = 0; Profiler::isEnabled() && i < size_t(Probe::COUNT); ++i) {
+        const Profiler::Stats &stats = Profiler::stats(Probe(i));
+        std::cout << "Probe " << probeNames[i] << ": " << std::string(18 - strlen(probeNames[i]), ' ')
+                  << stats.count << " times, " << stats.minUs << ".." << stats.maxUs << " us, mean "
+                  << stats.meanUs() << " us" << std::endl;
+    }
+    return 0;
+}
+
+#endif
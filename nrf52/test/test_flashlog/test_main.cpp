@@ -0,0 +1,185 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <FlashLog.h>
+#include <unity.h>
+
+namespace {
+
+/** NOR flash in RAM: 4 sectors of 256 bytes, 11 samples each */
+class RamFlash : public hal::Flash {
+public:
+    static const uint32_t SECTOR_SIZE = 256;
+    static const uint32_t SECTORS = 4;
+
+    RamFlash() {
+        memset(data, 0xFF, sizeof(data));
+    }
+
+    int init() override {
+        return 0;
+    }
+
+    uint32_t getProgramSize() const override {
+        return 4;
+    }
+
+    uint32_t getSectorSize() const override {
+        return SECTOR_SIZE;
+    }
+
+    uint32_t getSize() const override {
+        return sizeof(data);
+    }
+
+    int read(uint32_t address, void *buffer, uint32_t size) override {
+        memcpy(buffer, &data[address], size);
+        return 0;
+    }
+
+    int program(uint32_t address, const void *bytes, uint32_t size) override {
+        for (uint32_t i = 0; i < size; ++i) {
+            data[address + i] &= static_cast<const uint8_t *>(bytes)[i];
+        }
+        return 0;
+    }
+
+    int erase(uint32_t address, uint32_t size) override {
+        memset(&data[address], 0xFF, size);
+        return 0;
+    }
+
+    uint8_t data[SECTOR_SIZE * SECTORS];
+};
+
+/** Header and slot layout of FlashLog: 20 bytes each */
+const uint32_t SLOTS_PER_SECTOR = (RamFlash::SECTOR_SIZE - 20) / 20;
+
+RamFlash *flash;
+FlashLog *flashLog;
+std::vector<FlashLog::Sample> appended;
+
+/** Two samples a second apart every 10 seconds, so some times repeat at the sector starts */
+void append(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t sequence = uint32_t(appended.size());
+        FlashLog::Sample sample{sequence, 10 * (sequence / 2) + sequence % 2, int16_t(2000 + sequence),
+                                uint16_t(4000 + sequence), 50000, uint16_t(400 + sequence)};
+        TEST_ASSERT_EQUAL_INT(0, flashLog->append(sample));
+        appended.push_back(sample);
+    }
+}
+
+void assertSample(const FlashLog::Sample &expected, const FlashLog::Sample &actual) {
+    TEST_ASSERT_EQUAL_MEMORY(&expected, &actual, sizeof(expected));
+}
+
+/** The cursor reads the samples from the given index of appended on, except the one numbered skipped */
+void assertReadsFrom(FlashLog::Cursor cursor, size_t index, uint32_t skipped = UINT32_MAX) {
+    FlashLog::Sample sample{};
+    for (; index < appended.size(); ++index) {
+        if (appended[index].sequence == skipped) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(flashLog->read(cursor, sample));
+        assertSample(appended[index], sample);
+    }
+    TEST_ASSERT_FALSE(flashLog->read(cursor, sample));
+}
+
+/** Index in appended of the first stored sample with the key not less than the value */
+template<typename Key>
+size_t expectedIndex(uint32_t value, Key key, uint32_t skipped = UINT32_MAX) {
+    size_t index = flashLog->firstSequence();
+    while (index < appended.size() && (key(appended[index]) < value || appended[index].sequence == skipped)) {
+        ++index;
+    }
+    return index;
+}
+
+uint32_t sequenceOf(const FlashLog::Sample &sample) {
+    return sample.sequence;
+}
+
+uint32_t timeOf(const FlashLog::Sample &sample) {
+    return sample.time;
+}
+
+void assertSeeks(uint32_t skipped = UINT32_MAX) {
+    for (uint32_t sequence = 0; sequence <= appended.size() + 1; ++sequence) {
+        assertReadsFrom(flashLog->seekSequence(sequence), expectedIndex(sequence, sequenceOf, skipped), skipped);
+    }
+    uint32_t lastTime = appended.empty() ? 0 : appended.back().time;
+    for (uint32_t time = 0; time <= lastTime + 2; ++time) {
+        assertReadsFrom(flashLog->seekTime(time), expectedIndex(time, timeOf, skipped), skipped);
+    }
+}
+
+}
+
+void setUp() {
+    flash = new RamFlash();
+    flashLog = new FlashLog(*flash);
+    appended.clear();
+    TEST_ASSERT_EQUAL_INT(0, flashLog->mount());
+}
+
+void tearDown() {
+    delete flashLog;
+    delete flash;
+}
+
+void test_empty_log() {
+    TEST_ASSERT_EQUAL_UINT32(0, flashLog->nextSequence());
+    TEST_ASSERT_EQUAL_UINT32(0, flashLog->firstSequence());
+    assertSeeks();
+}
+
+void test_seek_within_the_first_sectors() {
+    append(2 * SLOTS_PER_SECTOR + 3);
+    TEST_ASSERT_EQUAL_UINT32(0, flashLog->firstSequence());
+    assertSeeks();
+}
+
+void test_seek_after_the_log_rotated() {
+    append(5 * RamFlash::SECTORS * SLOTS_PER_SECTOR + 4);
+    // The oldest sector makes room for the active one
+    TEST_ASSERT_TRUE(flashLog->firstSequence() > 0);
+    TEST_ASSERT_EQUAL_UINT32(appended.size(), flashLog->nextSequence());
+    TEST_ASSERT_TRUE(appended.size() - flashLog->firstSequence() > (RamFlash::SECTORS - 1) * SLOTS_PER_SECTOR);
+    assertSeeks();
+}
+
+void test_seek_after_remount() {
+    append(3 * RamFlash::SECTORS * SLOTS_PER_SECTOR + 7);
+    uint32_t firstSequence = flashLog->firstSequence();
+    delete flashLog;
+    flashLog = new FlashLog(*flash);
+    TEST_ASSERT_EQUAL_INT(0, flashLog->mount());
+    TEST_ASSERT_EQUAL_UINT32(firstSequence, flashLog->firstSequence());
+    TEST_ASSERT_EQUAL_UINT32(appended.size(), flashLog->nextSequence());
+    TEST_ASSERT_EQUAL_UINT32(appended.back().time, flashLog->lastTime());
+    assertSeeks();
+    // Appends continue where the log ended
+    append(SLOTS_PER_SECTOR);
+    assertSeeks();
+}
+
+void test_seek_steps_over_a_torn_sample() {
+    append(2 * SLOTS_PER_SECTOR + 5);
+    // A sample in the middle of the second sector, as if power went off while it was programmed
+    const uint32_t torn = SLOTS_PER_SECTOR + 4;
+    flash->data[RamFlash::SECTOR_SIZE + 20 + 4 * 20] ^= 0xFF;
+    assertSeeks(torn);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_log);
+    RUN_TEST(test_seek_within_the_first_sectors);
+    RUN_TEST(test_seek_after_the_log_rotated);
+    RUN_TEST(test_seek_after_remount);
+    RUN_TEST(test_seek_steps_over_a_torn_sample);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <History.h>
+#include <unity.h>
+
+namespace {
+
+struct Appended {
+    uint32_t sequence;
+    uint32_t time;
+    History::Record record;
+};
+
+/** Numerical Recipes LCG, the same stream on every platform */
+uint32_t randomState = 1;
+
+uint32_t random(uint32_t range) {
+    randomState = randomState * 1664525u + 1013904223u;
+    return (randomState >> 8) % range;
+}
+
+History *history;
+std::vector<Appended> appended;
+uint32_t lastTime;
+History::Record lastRecord;
+
+void append(uint32_t time, const History::Record &record) {
+    appended.push_back({history->nextSequence(), time, record});
+    history->append(time, record);
+    lastTime = time;
+    lastRecord = record;
+}
+
+/** Slowly changing readings every 3 seconds or a minute, now and then an unknown value or a long pause */
+void appendReadings(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        History::Record record = lastRecord;
+        record.temperature = int16_t(record.temperature + int16_t(random(5)) - 2);
+        record.humidity = uint16_t(record.humidity + random(21) - 10);
+        record.pressure = uint16_t(record.pressure + random(3) - 1);
+        record.co2 = uint16_t(random(10) == 0 ? 400 + random(1000) : record.co2);
+        if (random(200) == 0) {
+            record.temperature = History::TEMPERATURE_UNKNOWN;
+            record.humidity = History::HUMIDITY_UNKNOWN;
+            record.pressure = History::PRESSURE_UNKNOWN;
+            record.co2 = History::CO2_UNKNOWN;
+        } else if (record.temperature == History::TEMPERATURE_UNKNOWN) {
+            record = {0, 2150, 4500, 50650, 800};
+        }
+        uint32_t pause = random(500) == 0 ? 100000 : random(4) == 0 ? 60 : 3;
+        append(lastTime + pause, record);
+    }
+}
+
+/** Samples that change every value as much as there is */
+void appendJumps(uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        History::Record record = lastRecord;
+        record.temperature = int16_t(record.temperature ^ INT16_MIN);
+        record.humidity ^= 0x8000;
+        record.pressure ^= 0x8000;
+        record.co2 ^= 0x8000;
+        append(lastTime + 0x80000000u, record);
+    }
+}
+
+const Appended &stored(uint32_t sequence) {
+    return appended[sequence - appended.front().sequence];
+}
+
+void assertRecord(const Appended &expected, const History::Cursor &cursor, const History::Record &record) {
+    TEST_ASSERT_EQUAL_UINT32(expected.sequence + 1, cursor.sequence);
+    TEST_ASSERT_EQUAL_UINT32(expected.time, cursor.time);
+    TEST_ASSERT_EQUAL_INT16(expected.record.temperature, record.temperature);
+    TEST_ASSERT_EQUAL_UINT16(expected.record.humidity, record.humidity);
+    TEST_ASSERT_EQUAL_UINT16(expected.record.pressure, record.pressure);
+    TEST_ASSERT_EQUAL_UINT16(expected.record.co2, record.co2);
+}
+
+/** The cursor reads every stored sample from the given one on */
+void assertReadsFrom(History::Cursor cursor, uint32_t sequence) {
+    History::Record record{};
+    for (; sequence < history->nextSequence(); ++sequence) {
+        TEST_ASSERT_TRUE(history->read(cursor, record));
+        assertRecord(stored(sequence), cursor, record);
+    }
+    TEST_ASSERT_FALSE(history->read(cursor, record));
+}
+
+}
+
+void setUp() {
+    randomState = 1;
+    history = new History();
+    appended.clear();
+    lastTime = 1000;
+    lastRecord = {0, 2150, 4500, 50650, 800};
+}
+
+void tearDown() {
+    delete history;
+}
+
+void test_empty_history() {
+    TEST_ASSERT_EQUAL_UINT32(0, history->firstSequence());
+    TEST_ASSERT_EQUAL_UINT32(0, history->nextSequence());
+    History::Record record;
+    History::Cursor cursor = history->seek(0);
+    TEST_ASSERT_FALSE(history->read(cursor, record));
+    // Numbering continues from a log only before the first sample
+    history->setNextSequence(500);
+    append(1000, lastRecord);
+    history->setNextSequence(7);
+    TEST_ASSERT_EQUAL_UINT32(500, history->firstSequence());
+    TEST_ASSERT_EQUAL_UINT32(501, history->nextSequence());
+    TEST_ASSERT_TRUE(history->read(cursor, record));
+    assertRecord(appended[0], cursor, record);
+}
+
+void test_seek_before_the_history_is_full() {
+    appendReadings(300);
+    TEST_ASSERT_EQUAL_UINT32(0, history->firstSequence());
+    for (uint32_t sequence = 0; sequence <= history->nextSequence(); ++sequence) {
+        assertReadsFrom(history->seek(sequence), sequence);
+    }
+}
+
+void test_oldest_blocks_are_dropped() {
+    appendReadings(20000);
+    uint32_t first = history->firstSequence();
+    TEST_ASSERT_TRUE(first > 0);
+    // Compression keeps several times the samples of 10-byte records in the same RAM
+    TEST_ASSERT_TRUE(history->nextSequence() - first > 2 * History::BLOCKS * History::BLOCK_LENGTH / 10);
+    assertReadsFrom(history->seek(0), first);
+    for (uint32_t sequence = first; sequence <= history->nextSequence() + 1; sequence += 7) {
+        assertReadsFrom(history->seek(sequence), std::min(sequence, history->nextSequence()));
+    }
+}
+
+void test_seek_time() {
+    appendReadings(5000);
+    uint32_t first = history->firstSequence();
+    for (uint32_t sequence = first; sequence < history->nextSequence(); sequence += 3) {
+        uint32_t time = stored(sequence).time;
+        // The first sample at the time, and at a time between samples the one after it
+        uint32_t expected = sequence;
+        while (expected > first && stored(expected - 1).time == time) {
+            --expected;
+        }
+        assertReadsFrom(history->seekTime(time), expected);
+        uint32_t later = sequence;
+        while (later < history->nextSequence() && stored(later).time == time) {
+            ++later;
+        }
+        assertReadsFrom(history->seekTime(time + 1), later);
+    }
+    assertReadsFrom(history->seekTime(0), first);
+    assertReadsFrom(history->seekTime(lastTime + 1), history->nextSequence());
+}
+
+void test_cursor_follows_appends() {
+    appendReadings(100);
+    History::Cursor cursor = history->seek(history->nextSequence());
+    History::Record record;
+    // Samples appended after the cursor reached the end, across the start of new blocks
+    for (int i = 0; i < 2000; ++i) {
+        appendReadings(1 + random(3));
+        while (cursor.sequence < history->nextSequence()) {
+            uint32_t sequence = cursor.sequence;
+            TEST_ASSERT_TRUE(history->read(cursor, record));
+            assertRecord(stored(sequence), cursor, record);
+        }
+        TEST_ASSERT_FALSE(history->read(cursor, record));
+    }
+}
+
+void test_cursor_of_dropped_samples_continues_from_the_oldest() {
+    appendReadings(1000);
+    History::Cursor cursor = history->seek(500);
+    appendReadings(50000);
+    TEST_ASSERT_TRUE(history->firstSequence() > 500);
+    assertReadsFrom(cursor, history->firstSequence());
+}
+
+void test_worst_case_capacity() {
+    appendJumps(3 * History::MIN_CAPACITY);
+    TEST_ASSERT_TRUE(history->nextSequence() - history->firstSequence() >= History::MIN_CAPACITY);
+    assertReadsFrom(history->seek(0), history->firstSequence());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_history);
+    RUN_TEST(test_seek_before_the_history_is_full);
+    RUN_TEST(test_oldest_blocks_are_dropped);
+    RUN_TEST(test_seek_time);
+    RUN_TEST(test_cursor_follows_appends);
+    RUN_TEST(test_cursor_of_dropped_samples_continues_from_the_oldest);
+    RUN_TEST(test_worst_case_capacity);
+    return UNITY_END();
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+
+#include <QuantileEstimator.h>
+#include <RollingWindow.h>
+#include <unity.h>
+
+namespace {
+
+/** Numerical Recipes LCG, the same stream on every platform */
+uint32_t randomState = 1;
+
+uint32_t random(uint32_t range) {
+    randomState = randomState * 1664525u + 1013904223u;
+    return (randomState >> 8) % range;
+}
+
+/** 12 buckets of a second */
+const uint32_t WINDOW_MS = 12000;
+
+struct Sample {
+    uint64_t timeMs;
+    int32_t value;
+};
+
+/** Summary of the samples of the buckets in the window that ends at nowMs, computed the long way */
+RollingWindow::Summary bruteForce(const std::deque<Sample> &samples, uint64_t nowMs) {
+    const uint64_t bucketMs = WINDOW_MS / RollingWindow::BUCKETS;
+    const uint64_t current = nowMs / bucketMs;
+    uint32_t count = 0;
+    int32_t min = INT32_MAX;
+    int32_t max = INT32_MIN;
+    int64_t sum = 0;
+    uint64_t squares = 0;
+    for (const Sample &sample : samples) {
+        if (sample.timeMs / bucketMs + RollingWindow::BUCKETS <= current) {
+            continue;
+        }
+        ++count;
+        min = std::min(min, sample.value);
+        max = std::max(max, sample.value);
+        sum += sample.value;
+        squares += uint64_t(int64_t(sample.value) * sample.value);
+    }
+    if (count == 0) {
+        return RollingWindow::Summary{0, 0, 0, 0, 0};
+    }
+    double mean = double(sum) / count;
+    double variance = double(squares) / count - mean * mean;
+    return RollingWindow::Summary{count, min, max, int32_t(std::lround(mean)),
+                                  uint32_t(std::lround(variance > 0 ? std::sqrt(variance) : 0))};
+}
+
+void assertSummary(const RollingWindow::Summary &expected, const RollingWindow::Summary &actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.count, actual.count);
+    TEST_ASSERT_EQUAL_INT32(expected.min, actual.min);
+    TEST_ASSERT_EQUAL_INT32(expected.max, actual.max);
+    TEST_ASSERT_EQUAL_INT32(expected.mean, actual.mean);
+    TEST_ASSERT_EQUAL_UINT32(expected.deviation, actual.deviation);
+}
+
+}
+
+void setUp() {
+    randomState = 1;
+}
+
+void tearDown() {}
+
+void test_window_without_samples() {
+    RollingWindow window{WINDOW_MS};
+    assertSummary(RollingWindow::Summary{0, 0, 0, 0, 0}, window.summary(5000));
+    TEST_ASSERT_EQUAL_UINT32(WINDOW_MS, window.getLength());
+}
+
+void test_window_summary_is_exact() {
+    RollingWindow window{WINDOW_MS};
+    window.add(100, -10);
+    window.add(1100, 20);
+    window.add(2100, 30);
+    window.add(3100, 40);
+    // Mean 20, variance (900 + 0 + 100 + 400) / 4 = 350
+    assertSummary(RollingWindow::Summary{4, -10, 40, 20, 19}, window.summary(3100));
+}
+
+void test_buckets_leave_the_window() {
+    RollingWindow window{WINDOW_MS};
+    window.add(0, 100);
+    window.add(5000, 5);
+    assertSummary(RollingWindow::Summary{2, 5, 100, 53, 48}, window.summary(11999));
+    // The first bucket leaves once the twelfth after it starts
+    assertSummary(RollingWindow::Summary{1, 5, 5, 5, 0}, window.summary(12000));
+    assertSummary(RollingWindow::Summary{0, 0, 0, 0, 0}, window.summary(17000));
+    // A gap longer than the window leaves nothing behind
+    window.add(100000, -7);
+    assertSummary(RollingWindow::Summary{1, -7, -7, -7, 0}, window.summary(100000));
+}
+
+void test_window_matches_brute_force() {
+    RollingWindow window{WINDOW_MS};
+    std::deque<Sample> samples;
+    uint64_t now = 0;
+    int32_t value = 2000;
+    for (int i = 0; i < 20000; ++i) {
+        // Mostly a sample every few hundred milliseconds, now and then a pause longer than the window
+        now += random(50) == 0 ? 5000 + random(20000) : random(700);
+        value += int32_t(random(201)) - 100;
+        value = std::max(INT16_MIN + 0, std::min(INT16_MAX + 0, value));
+        window.add(now, value);
+        samples.push_back({now, value});
+        while (samples.front().timeMs + 2 * WINDOW_MS < now) {
+            samples.pop_front();
+        }
+        assertSummary(bruteForce(samples, now), window.summary(now));
+        if (random(10) == 0) {
+            uint64_t later = now + random(3 * WINDOW_MS);
+            assertSummary(bruteForce(samples, later), window.summary(later));
+            now = later;
+        }
+    }
+}
+
+void test_quantile_of_few_samples_is_exact() {
+    QuantileEstimator median{0.5f};
+    TEST_ASSERT_EQUAL_UINT32(0, median.getCount());
+    TEST_ASSERT_FLOAT_WITHIN(0, 0.0f, median.value());
+    median.add(5);
+    median.add(1);
+    median.add(3);
+    TEST_ASSERT_FLOAT_WITHIN(0, 3.0f, median.value());
+    median.add(4);
+    median.add(2);
+    TEST_ASSERT_FLOAT_WITHIN(0, 3.0f, median.value());
+    median.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, median.getCount());
+}
+
+void test_quantiles_of_a_uniform_stream() {
+    const float quantiles[] = {0.1f, 0.5f, 0.9f};
+    for (float quantile : quantiles) {
+        QuantileEstimator estimator{quantile};
+        for (int i = 0; i < 100000; ++i) {
+            estimator.add(float(random(10001)));
+        }
+        TEST_ASSERT_EQUAL_UINT32(100000, estimator.getCount());
+        // Within 1 % of the range
+        TEST_ASSERT_FLOAT_WITHIN(100.0f, 10000 * quantile, estimator.value());
+    }
+}
+
+void test_quantile_of_a_constant_stream() {
+    QuantileEstimator median{0.5f};
+    for (int i = 0; i < 1000; ++i) {
+        median.add(42);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0, 42.0f, median.value());
+}
+
+void test_median_of_a_skewed_stream() {
+    QuantileEstimator median{0.5f};
+    // A skewed stream: most samples are small, the median stays among them
+    for (int i = 0; i < 50000; ++i) {
+        median.add(random(4) == 0 ? float(1000 + random(1000)) : float(random(100)));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, 100 * (0.5f / 0.75f), median.value());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_window_without_samples);
+    RUN_TEST(test_window_summary_is_exact);
+    RUN_TEST(test_buckets_leave_the_window);
+    RUN_TEST(test_window_matches_brute_force);
+    RUN_TEST(test_quantile_of_few_samples_is_exact);
+    RUN_TEST(test_quantiles_of_a_uniform_stream);
+    RUN_TEST(test_quantile_of_a_constant_stream);
+    RUN_TEST(test_median_of_a_skewed_stream);
+    return UNITY_END();
+}
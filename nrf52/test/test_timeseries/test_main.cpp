@@ -0,0 +1,196 @@
+#include <cstdint>
+#include <cstring>
+
+#include <History.h>
+#include <TimeSeries.h>
+#include <unity.h>
+
+using timeseries::Decoder;
+using timeseries::Encoder;
+using timeseries::Sample;
+
+namespace {
+
+const size_t BLOCK_LENGTH = 244;
+
+Sample sample(uint32_t time, int16_t temperature, uint16_t humidity, uint16_t pressure, uint16_t co2) {
+    return Sample{time, {uint16_t(temperature), humidity, pressure, co2}};
+}
+
+void assertSample(const Sample &expected, const Sample &actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.time, actual.time);
+    TEST_ASSERT_EQUAL_MEMORY(expected.values, actual.values, sizeof(expected.values));
+}
+
+/** Encodes the samples into one block and decodes them back */
+void assertRoundTrip(const Sample *samples, size_t count, uint32_t sequence, uint32_t time) {
+    uint8_t block[BLOCK_LENGTH];
+    Encoder encoder{block, sizeof(block)};
+    encoder.begin(sequence, time);
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_TRUE(encoder.append(samples[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT32(count, encoder.count());
+
+    Decoder decoder;
+    TEST_ASSERT_TRUE(decoder.open(block, encoder.length()));
+    TEST_ASSERT_EQUAL_UINT32(sequence, decoder.header().sequence);
+    TEST_ASSERT_EQUAL_UINT32(time, decoder.header().time);
+    Sample decoded{};
+    for (size_t i = 0; i < count; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(uint32_t(sequence + i), decoder.sequence());
+        TEST_ASSERT_TRUE(decoder.next(decoded));
+        assertSample(samples[i], decoded);
+    }
+    TEST_ASSERT_FALSE(decoder.next(decoded));
+}
+
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_steady_samples_take_a_byte() {
+    uint8_t block[BLOCK_LENGTH];
+    Encoder encoder{block, sizeof(block)};
+    encoder.begin(0, 1000);
+    TEST_ASSERT_TRUE(encoder.append(sample(1003, 2150, 4500, 50650, 800)));
+    size_t first = encoder.length();
+    TEST_ASSERT_TRUE(encoder.append(sample(1006, 2150, 4500, 50650, 800)));
+    TEST_ASSERT_TRUE(encoder.append(sample(1009, 2150, 4500, 50650, 800)));
+    TEST_ASSERT_EQUAL_size_t(first + 2, encoder.length());
+    // A small change takes a byte more
+    TEST_ASSERT_TRUE(encoder.append(sample(1012, 2151, 4500, 50650, 800)));
+    TEST_ASSERT_EQUAL_size_t(first + 4, encoder.length());
+}
+
+void test_round_trip_of_slow_readings() {
+    Sample samples[40];
+    for (uint32_t i = 0; i < 40; ++i) {
+        samples[i] = sample(100 + 3 * i + (i % 7 == 0 ? 1 : 0), int16_t(2150 - int32_t(i % 5)), uint16_t(4500 + i),
+                            uint16_t(50650 - (i % 3)), uint16_t(800 + 2 * (i % 4)));
+    }
+    assertRoundTrip(samples, 40, 12345, 97);
+}
+
+void test_round_trip_of_wrapping_differences() {
+    const Sample samples[] = {
+            sample(0, INT16_MAX, 0, UINT16_MAX, 0),
+            sample(0xFFFFFFF0, INT16_MIN, UINT16_MAX, 0, UINT16_MAX),
+            sample(5, INT16_MAX, 0, UINT16_MAX, 0),
+            sample(5, -1, 0x8000, 0x7FFF, 1),
+            sample(UINT32_MAX, 1, 0x7FFF, 0x8000, 0xFFFE),
+    };
+    assertRoundTrip(samples, sizeof(samples) / sizeof(samples[0]), UINT32_MAX - 2, 0x80000000);
+}
+
+void test_round_trip_of_unknown_markers() {
+    const Sample samples[] = {
+            sample(10, 2150, 4500, 50650, 800),
+            sample(13, History::TEMPERATURE_UNKNOWN, History::HUMIDITY_UNKNOWN, History::PRESSURE_UNKNOWN,
+                   History::CO2_UNKNOWN),
+            sample(16, History::TEMPERATURE_UNKNOWN, History::HUMIDITY_UNKNOWN, History::PRESSURE_UNKNOWN,
+                   History::CO2_UNKNOWN),
+            sample(19, -2150, 4500, 50650, 800),
+    };
+    assertRoundTrip(samples, sizeof(samples) / sizeof(samples[0]), 0, 10);
+}
+
+void test_worst_case_sample_fits_the_smallest_block() {
+    uint8_t block[timeseries::HEADER_LENGTH + timeseries::MAX_SAMPLE_LENGTH];
+    Encoder encoder{block, sizeof(block)};
+    encoder.begin(0, 0);
+    // Every difference the largest there is: zig-zag makes the most negative ones the longest varints
+    TEST_ASSERT_TRUE(encoder.append(sample(0x80000000, INT16_MIN, 0x8000, 0x8000, 0x8000)));
+    TEST_ASSERT_EQUAL_size_t(sizeof(block), encoder.length());
+    TEST_ASSERT_FALSE(encoder.append(sample(0x80000001, 0, 0, 0, 0)));
+}
+
+void test_full_block_is_left_unchanged() {
+    uint8_t block[timeseries::HEADER_LENGTH + 2 * timeseries::MAX_SAMPLE_LENGTH];
+    Encoder encoder{block, sizeof(block)};
+    encoder.begin(7, 0);
+    const Sample first = sample(3, 2150, 4500, 50650, 800);
+    TEST_ASSERT_TRUE(encoder.append(first));
+    uint32_t time = 3;
+    while (encoder.append(sample(time += 3, 2150, 4500, 50650, 800))) {
+    }
+    size_t length = encoder.length();
+    uint32_t count = encoder.count();
+    uint8_t before[sizeof(block)];
+    memcpy(before, block, sizeof(block));
+
+    TEST_ASSERT_FALSE(encoder.append(sample(time + 100, -2150, 0, 0, 5000)));
+    TEST_ASSERT_EQUAL_size_t(length, encoder.length());
+    TEST_ASSERT_EQUAL_UINT32(count, encoder.count());
+    TEST_ASSERT_EQUAL_MEMORY(before, block, sizeof(block));
+
+    // The block still decodes to what went in
+    Decoder decoder;
+    Sample decoded{};
+    TEST_ASSERT_TRUE(decoder.open(block, length));
+    TEST_ASSERT_TRUE(decoder.next(decoded));
+    assertSample(first, decoded);
+    uint32_t samples = 1;
+    while (decoder.next(decoded)) {
+        ++samples;
+    }
+    TEST_ASSERT_EQUAL_UINT32(count, samples);
+    TEST_ASSERT_EQUAL_UINT32(time - 3, decoded.time);
+}
+
+void test_truncated_sample_is_rejected() {
+    uint8_t block[BLOCK_LENGTH];
+    Encoder encoder{block, sizeof(block)};
+    encoder.begin(0, 0);
+    const Sample first = sample(3, 2150, 4500, 50650, 800);
+    TEST_ASSERT_TRUE(encoder.append(first));
+    size_t firstEnd = encoder.length();
+    TEST_ASSERT_TRUE(encoder.append(sample(100000, -2150, 0, 0, 5000)));
+
+    // Every cut inside the second sample leaves the first one and nothing else
+    for (size_t length = firstEnd + 1; length < encoder.length(); ++length) {
+        Decoder decoder;
+        Sample decoded{};
+        TEST_ASSERT_TRUE(decoder.open(block, length));
+        TEST_ASSERT_TRUE(decoder.next(decoded));
+        assertSample(first, decoded);
+        TEST_ASSERT_FALSE(decoder.next(decoded));
+        TEST_ASSERT_EQUAL_UINT32(1, decoder.sequence());
+    }
+}
+
+void test_block_shorter_than_header_is_rejected() {
+    uint8_t block[timeseries::HEADER_LENGTH] = {0};
+    Decoder decoder;
+    TEST_ASSERT_FALSE(decoder.open(block, timeseries::HEADER_LENGTH - 1));
+    TEST_ASSERT_TRUE(decoder.open(block, timeseries::HEADER_LENGTH));
+    Sample decoded{};
+    TEST_ASSERT_FALSE(decoder.next(decoded));
+}
+
+void test_overlong_varint_is_rejected() {
+    uint8_t block[timeseries::HEADER_LENGTH + 7] = {0};
+    // Time present, a varint that does not end within 32 bits
+    block[timeseries::HEADER_LENGTH] = 1;
+    memset(&block[timeseries::HEADER_LENGTH + 1], 0xFF, 6);
+    Decoder decoder;
+    Sample decoded{};
+    TEST_ASSERT_TRUE(decoder.open(block, sizeof(block)));
+    TEST_ASSERT_FALSE(decoder.next(decoded));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_steady_samples_take_a_byte);
+    RUN_TEST(test_round_trip_of_slow_readings);
+    RUN_TEST(test_round_trip_of_wrapping_differences);
+    RUN_TEST(test_round_trip_of_unknown_markers);
+    RUN_TEST(test_worst_case_sample_fits_the_smallest_block);
+    RUN_TEST(test_full_block_is_left_unchanged);
+    RUN_TEST(test_truncated_sample_is_rejected);
+    RUN_TEST(test_block_shorter_than_header_is_rejected);
+    RUN_TEST(test_overlong_varint_is_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,187 @@
+/**
+ * Compresses recorded traces with lib/TimeSeries and reports the compression ratio and the time per sample.
+ *
+ * Build on the host from nrf52/:
+ *   g++ -std=c++14 -O2 -Ilib/TimeSeries tools/codecbench.cpp lib/TimeSeries/TimeSeries.cpp -o codecbench
+ *
+ * Usage: codecbench [-b bytes] [file...]
+ *   -b    block length, 244 by default: a notification at the largest ATT MTU
+ *   file  trace, standard input by default. A line per sample, "sequence,time,temperature,humidity,pressure,co2"
+ *         in the units of History::Record, e.g. written by the -t option of the simulation
+ *
+ * Samples are cut into blocks the way HistoryService does it: a block ends when the next sample does not fit
+ * or its sequence number does not follow. Every trace is decoded again and compared to the input.
+ * The ratio is to the 10 bytes of a History::Record, block headers included.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <TimeSeries.h>
+
+namespace {
+
+const size_t RECORD_LENGTH = 10;
+/** Encoding runs at least this long, for a stable time per sample */
+const double MIN_BENCHMARK_NS = 2e8;
+
+struct Trace {
+    std::vector<uint32_t> sequences;
+    std::vector<timeseries::Sample> samples;
+};
+
+bool load(FILE *file, Trace &trace) {
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        unsigned sequence, time, humidity, pressure, co2;
+        int temperature;
+        if (sscanf(line, "%u,%u,%d,%u,%u,%u", &sequence, &time, &temperature, &humidity, &pressure, &co2) != 6) {
+            fprintf(stderr, "Bad trace line: %s", line);
+            return false;
+        }
+        trace.sequences.push_back(sequence);
+        trace.samples.push_back({time, {uint16_t(temperature), uint16_t(humidity), uint16_t(pressure),
+                                        uint16_t(co2)}});
+    }
+    return true;
+}
+
+/**
+ * Encodes the whole trace into consecutive blocks, each preceded by its length.
+ * @return total length of the blocks without the length bytes
+ */
+size_t encode(const Trace &trace, size_t blockLength, std::vector<uint8_t> &output) {
+    std::vector<uint8_t> block(blockLength);
+    timeseries::Encoder encoder{block.data(), blockLength};
+    size_t total = 0;
+    auto flush = [&]() {
+        if (encoder.count() != 0) {
+            output.push_back(uint8_t(encoder.length()));
+            output.push_back(uint8_t(encoder.length() >> 8));
+            output.insert(output.end(), block.begin(), block.begin() + encoder.length());
+            total += encoder.length();
+        }
+    };
+    for (size_t i = 0; i < trace.samples.size(); ++i) {
+        const timeseries::Sample &sample = trace.samples[i];
+        if (encoder.count() != 0 && trace.sequences[i] == trace.sequences[i - 1] + 1 && encoder.append(sample)) {
+            continue;
+        }
+        flush();
+        encoder.begin(trace.sequences[i], sample.time);
+        encoder.append(sample);
+    }
+    flush();
+    return total;
+}
+
+/** @return the number of samples decoded, or SIZE_MAX at the first one that differs from the trace */
+size_t decode(const std::vector<uint8_t> &input, const Trace *trace) {
+    size_t count = 0;
+    timeseries::Decoder decoder;
+    timeseries::Sample sample;
+    for (size_t offset = 0; offset + 2 <= input.size();) {
+        size_t length = size_t(input[offset] | input[offset + 1] << 8);
+        decoder.open(&input[offset + 2], length);
+        offset += 2 + length;
+        while (true) {
+            uint32_t sequence = decoder.sequence();
+            if (!decoder.next(sample)) {
+                break;
+            }
+            if (trace != nullptr && (count >= trace->samples.size() || trace->sequences[count] != sequence
+                                     || trace->samples[count].time != sample.time
+                                     || memcmp(trace->samples[count].values, sample.values,
+                                               sizeof(sample.values)) != 0)) {
+                return SIZE_MAX;
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+/** Mean nanoseconds a call to run takes, repeated for at least MIN_BENCHMARK_NS */
+template<typename Run>
+double measure(Run run) {
+    typedef std::chrono::steady_clock Clock;
+    uint64_t runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed;
+    do {
+        run();
+        ++runs;
+        elapsed = double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    } while (elapsed < MIN_BENCHMARK_NS);
+    return elapsed / double(runs);
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t blockLength = 244;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            blockLength = size_t(atoi(argv[++i]));
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (blockLength < timeseries::HEADER_LENGTH + timeseries::MAX_SAMPLE_LENGTH || blockLength > UINT16_MAX) {
+        fprintf(stderr, "Block length must be %u..%u bytes\n",
+                unsigned(timeseries::HEADER_LENGTH + timeseries::MAX_SAMPLE_LENGTH), unsigned(UINT16_MAX));
+        return 2;
+    }
+    if (files.empty()) {
+        files.push_back("-");
+    }
+
+    int result = 0;
+    printf("%-24s %9s %12s %10s %7s %11s %11s\n", "trace", "samples", "bytes", "bytes/smp", "ratio",
+           "encode ns", "decode ns");
+    for (const char *name : files) {
+        FILE *file = strcmp(name, "-") == 0 ? stdin : fopen(name, "r");
+        if (file == nullptr) {
+            perror(name);
+            result = 1;
+            continue;
+        }
+        Trace trace;
+        bool loaded = load(file, trace);
+        if (file != stdin) {
+            fclose(file);
+        }
+        if (!loaded || trace.samples.empty()) {
+            fprintf(stderr, "%s: no samples\n", name);
+            result = 1;
+            continue;
+        }
+
+        std::vector<uint8_t> encoded;
+        size_t bytes = encode(trace, blockLength, encoded);
+        if (decode(encoded, &trace) != trace.samples.size()) {
+            fprintf(stderr, "%s: decoded samples differ from the trace\n", name);
+            result = 1;
+            continue;
+        }
+        std::vector<uint8_t> scratch;
+        scratch.reserve(encoded.size());
+        double encodeNs = measure([&]() {
+            scratch.clear();
+            encode(trace, blockLength, scratch);
+        });
+        volatile size_t sink = 0;
+        double decodeNs = measure([&]() {
+            sink = sink + decode(encoded, nullptr);
+        });
+
+        size_t count = trace.samples.size();
+        printf("%-24s %9zu %12zu %10.2f %6.2fx %11.1f %11.1f\n", name, count, bytes, double(bytes) / count,
+               double(count * RECORD_LENGTH) / bytes, encodeNs / count, decodeNs / count);
+    }
+    return result;
+}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Decodes the binary log of the firmware, see lib/Log/Log.h for the frame layout.
+
+Usage: logdecode.py [file]
+    file  log captured from the console UART, e.g. /dev/ttyACM0 or the -l file of the simulation;
+          standard input by default
+The message formats come from lib/Log/LogMessages.h of the same source tree.
+"""
+
+import os
+import re
+import struct
+import sys
+
+FRAME_START = 0xA5
+MAX_ARGS = 4
+MESSAGES_H = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'lib', 'Log', 'LogMessages.h')
+
+
+def load_formats(path):
+    with open(path) as header:
+        text = header.read()
+    return [fmt.encode().decode('unicode_escape')
+            for fmt in re.findall(r'LOG_MESSAGE\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)]
+
+
+def format_message(fmt, args):
+    result = []
+    args = iter(args)
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        if c != '%' or i + 1 == len(fmt):
+            result.append(c)
+            i += 1
+            continue
+        conversion = fmt[i + 1]
+        i += 2
+        if conversion == '%':
+            result.append('%')
+            continue
+        value = next(args, 0)
+        if conversion == 'u':
+            result.append(str(value & 0xFFFFFFFF))
+        elif conversion == 'x':
+            result.append('%x' % (value & 0xFFFFFFFF))
+        elif conversion == 'F':
+            result.append('%s%d.%02d' % ('-' if value < 0 else '', abs(value) // 100, abs(value) % 100))
+        else:
+            result.append(str(value))
+    return ''.join(result)
+
+
+def frames(stream):
+    """Yields (id, time, args), skipping bytes until a frame with a valid check byte"""
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buffer += chunk
+        while True:
+            start = buffer.find(FRAME_START)
+            if start < 0:
+                buffer.clear()
+                break
+            del buffer[:start]
+            if len(buffer) < 8:
+                break
+            arg_count = buffer[7]
+            length = 8 + 4 * arg_count + 1
+            if arg_count > MAX_ARGS:
+                del buffer[:1]
+                continue
+            if len(buffer) < length:
+                break
+            check = 0
+            for byte in buffer[1:length - 1]:
+                check ^= byte
+            if check != buffer[length - 1]:
+                del buffer[:1]
+                continue
+            message_id, time_ms = struct.unpack_from('<HI', buffer, 1)
+            args = struct.unpack_from('<%di' % arg_count, buffer, 8)
+            del buffer[:length]
+            yield message_id, time_ms, args
+
+
+def main():
+    formats = load_formats(MESSAGES_H)
+    stream = open(sys.argv[1], 'rb', buffering=0) if len(sys.argv) > 1 else sys.stdin.buffer
+    for message_id, time_ms, args in frames(stream):
+        if message_id < len(formats):
+            text = format_message(formats[message_id], args)
+        else:
+            text = 'unknown message %d %s' % (message_id, list(args))
+        print('[%d.%03d] %s' % (time_ms // 1000, time_ms % 1000, text), flush=True)
+
+
+if __name__ == '__main__':
+    main()